@@ -1,10 +1,10 @@
 #include "SetupApp.h"
 
+#include <ImportedScene.h>
+
 #include <iostream>
 
-#include <assimp/cimport.h>
 #include <assimp/scene.h>
-#include <assimp/postprocess.h>
 
 namespace sess
 {
@@ -21,7 +21,13 @@ SetupApp::~SetupApp()
 //
 bool SetupApp::InitializeApp()
 {
-	auto walkingMan = aiImportFile("../simpleMan2.6.fbx", aiProcessPreset_TargetRealtime_MaxQuality);
+	// Freed when this returns - there's nothing here that needs it after that
+	ImportedScene walkingMan;
+	if (!walkingMan.Read("../simpleMan2.6.fbx", ImportProfileFlags(ImportProfile::Max)))
+	{
+		std::cerr << "Could not import the walking man: " << walkingMan.ErrorString() << std::endl;
+		return false;
+	}
 
 	std::cout << "Number of meshes found in file: " << walkingMan->mNumMeshes << std::endl;
 	std::cout << "Number of vertices in first mesh: " << walkingMan->mMeshes[0]->mNumVertices << std::endl;
@@ -1,81 +1,37 @@
 #include "AssimpRoadModel.h"
 
-#include <assimp/cimport.h>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <assimp/material.h>
+#include <CookedModel.h>
 
 #include <iostream>
 
 namespace sess
 {
 
-std::shared_ptr<AssimpRoadModel> AssimpRoadModel::LoadFromFile(const char * fName, ComPtr<ID3D11Device> d3dDevice, const Transform & transform)
+std::shared_ptr<AssimpRoadModel> AssimpRoadModel::LoadFromFile(const char * fName, ComPtr<ID3D11Device> d3dDevice, const Transform & transform, ImportProfile profile)
 {
-	const aiScene* scene = aiImportFile(fName, aiProcessPreset_TargetRealtime_MaxQuality);
-
-	if (!scene)
+	LoadTimer timer;
+	CookedModel model;
+	if (!LoadCookedModel(fName, ImportProfileFlags(profile), MaterialOnlyShader::Vertex::Layout(), model, &timer))
 	{
 		std::cerr << "Could not load file " << fName << std::endl;
 		return nullptr;
 	}
 
-	// Load all meshes and whatnot
+	// GPU buffers straight out of the cooked model (see CookedModel.h) - no copy of the
+	//  vertices on our side at all
 	std::vector<Mesh> meshes;
-	meshes.reserve(scene->mNumMeshes);
-	for (std::uint32_t meshIdx = 0u; meshIdx < scene->mNumMeshes; meshIdx++)
+	meshes.reserve(model.MeshCount());
+	for (std::uint32_t meshIdx = 0u; meshIdx < model.MeshCount(); meshIdx++)
 	{
-		aiMesh* mesh = scene->mMeshes[meshIdx];
-
-		std::vector<MaterialOnlyShader::Vertex> verts;
-		verts.reserve(mesh->mNumVertices);
-		
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		aiColor4D specularColor;
-		aiColor4D diffuseColor;
-		aiColor4D ambientColor;
-		float shininess;
-
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specularColor);
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuseColor);
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &ambientColor);
-		aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
-
-		MaterialOnlyShader::Material meshMaterial
-		(
-			Color(specularColor.r, specularColor.g, specularColor.b, shininess), // Specular
-			Color(diffuseColor.r, diffuseColor.g, diffuseColor.b, diffuseColor.a), // Diffuse
-			Color(ambientColor.r, ambientColor.g, ambientColor.b, ambientColor.a) // Ambient
-		);
-
-		for (std::uint32_t vertIdx = 0u; vertIdx < mesh->mNumVertices; vertIdx++)
-		{
-			aiVector3D vert = mesh->mVertices[vertIdx];
-			aiVector3D norm = mesh->mNormals[vertIdx];
-
-			verts.push_back
-			(
-				MaterialOnlyShader::Vertex
-				(
-					Vec3(vert.x, vert.y, vert.z),
-					Vec3(norm.x, norm.y, norm.z)
-				)
-			);
-		}
-
-		std::vector<std::uint32_t> indices;
-		indices.reserve(mesh->mNumFaces * 3u);
-		for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++)
-		{
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[0u]);
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[1u]);
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[2u]);
-		}
-
-		MaterialOnlyShader::RenderCall call(d3dDevice, verts, indices);
+		CookedModel::MeshView cooked = model.GetMesh(meshIdx);
+		MaterialOnlyShader::Material meshMaterial(cooked.Specular, cooked.Diffuse, cooked.Ambient);
+		MaterialOnlyShader::RenderCall call(d3dDevice, model.GetVertices<MaterialOnlyShader::Vertex>(meshIdx), cooked.VertexCount, cooked.Indices, cooked.IndexCount, cooked.Ranges, cooked.RangeCount);
 
 		meshes.push_back({ call, meshMaterial });
 	}
+	timer.EndStage("upload");
+
+	timer.Report(std::cout, fName);
 
 	return std::make_shared<AssimpRoadModel>(meshes, transform);
 }
@@ -87,7 +43,7 @@ bool AssimpRoadModel::Update(float dt)
 
 bool AssimpRoadModel::Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader) const
 {
-	shader->SetModelTransform(transform_.GetTransformMatrix());
+	shader->SetModelTransform(transform_.GetAffineMatrix());
 
 	for (auto&& mesh : meshes_)
 	{
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ImportProfile.h>
 #include <Transform.h>
 #include <vector>
 #include <memory>
@@ -22,7 +23,7 @@ public:
 	
 	AssimpRoadModel(const std::vector<Mesh>& meshes, const Transform& transform);
 
-	static std::shared_ptr<AssimpRoadModel> LoadFromFile(const char* fName, ComPtr<ID3D11Device> d3dDevice, const Transform& transform);
+	static std::shared_ptr<AssimpRoadModel> LoadFromFile(const char* fName, ComPtr<ID3D11Device> d3dDevice, const Transform& transform, ImportProfile profile = ImportProfile::Default);
 	bool Update(float dt);
 	bool Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader) const;
 
@@ -137,7 +137,7 @@ bool DebugMaterialIcosphere::Update(float dt)
 bool DebugMaterialIcosphere::Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader) const
 {
 	shader->SetObjectMaterial(material_);
-	shader->SetModelTransform(modelTransform_.GetTransformMatrix());
+	shader->SetModelTransform(modelTransform_.GetAffineMatrix());
 	shader->Render(context, *call_);
 
 	return true;
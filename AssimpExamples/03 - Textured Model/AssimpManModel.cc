@@ -2,36 +2,120 @@
 
 #include <lodepng.h>
 
-#include <assimp/cimport.h>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <assimp/material.h>
+#include <CookedModel.h>
+#include <CompactVertex.h>
 
 #include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
 
 namespace sess
 {
 
-std::shared_ptr<AssimpManModel> AssimpManModel::LoadFromFile(const char* fName, const char* textureFilename, ComPtr<ID3D11Device> d3dDevice, ComPtr<ID3D11DeviceContext> d3dDeviceContext, const Transform& transform)
+std::shared_ptr<AssimpManModel> AssimpManModel::LoadFromFile(const char* fName, const char* textureFilename, ComPtr<ID3D11Device> d3dDevice, ComPtr<ID3D11DeviceContext> d3dDeviceContext, const Transform& transform, ImportProfile profile)
 {
-	const aiScene* scene = aiImportFile(fName, aiProcessPreset_TargetRealtime_MaxQuality);
+	std::shared_ptr<MeshData> meshData = LoadMeshes(fName, d3dDevice, transform, profile);
+	std::shared_ptr<TexturedShader::Texture> texture = CreateTexture(d3dDevice, d3dDeviceContext, LoadTextureImage(textureFilename));
+	return Create(meshData, texture);
+}
 
-	if (!scene)
+std::shared_ptr<AssimpManModel::MeshData> AssimpManModel::LoadMeshes(const char* fName, ComPtr<ID3D11Device> d3dDevice, const Transform& transform, ImportProfile profile, AssetLoader* loader, const AssetArchive* archive)
+{
+	LoadTimer timer;
+	CookedModel model;
+	if (!LoadCookedModel(fName, ImportProfileFlags(profile), TexturedShader::Vertex::Layout(), model, &timer, archive, loader ? loader->ForEachFunction() : ForEachFn()))
 	{
 		std::cerr << "Could not load file " << fName << std::endl;
 		return nullptr;
 	}
 
+	// The meshes are all in their own space - the node tree is what puts them in place.
+	//  The transform passed in goes above all of it, so the whole model moves together.
+	auto meshData = std::make_shared<MeshData>();
+	std::uint32_t root = meshData->Hierarchy.Add(transform);
+	std::uint32_t firstNode = model.AddNodes(meshData->Hierarchy, root);
+
+	// The cooked vertices are floats, in TexturedShader::Vertex's layout. Those go onto the GPU
+	//  as compact vertices (see CompactVertex.h) - 16 bytes each instead of 40 - with how much
+	//  precision that cost, mesh by mesh.
+	// Meshes don't share anything, so with a loader they each get encoded and uploaded on
+	//  whichever of its threads is free. The error reports wait until the end, so they
+	//  don't come out all jumbled together.
+	std::vector<std::unique_ptr<Mesh>> sceneMeshes(model.MeshCount());
+	std::vector<CompactVertexError> errors(model.MeshCount());
+	auto uploadMesh = [&](std::size_t meshIdx)
+	{
+		CookedModel::MeshView cooked = model.GetMesh((std::uint32_t)meshIdx);
+		TexturedShader::Material meshMaterial(cooked.Specular, cooked.Diffuse, cooked.Ambient);
+
+		std::vector<CompactTexturedVertex> compact(cooked.VertexCount);
+		CompactVertexDecode decode = EncodeCompactVertices(cooked.Vertices, TexturedShader::Vertex::Layout(), cooked.VertexCount, cooked.Bounds, compact.data());
+		errors[meshIdx] = MeasureError(cooked.Vertices, TexturedShader::Vertex::Layout(), compact.data(), decode, cooked.VertexCount);
+
+		TexturedShader::RenderCall call(d3dDevice, compact.data(), cooked.VertexCount, decode, cooked.Indices, cooked.IndexCount, cooked.Ranges, cooked.RangeCount);
+
+		sceneMeshes[meshIdx].reset(new Mesh{ call, meshMaterial, cooked.Bounds, root });
+	};
+	if (loader)
+	{
+		loader->ForEach(model.MeshCount(), uploadMesh);
+	}
+	else
+	{
+		for (std::size_t meshIdx = 0u; meshIdx < model.MeshCount(); meshIdx++)
+		{
+			uploadMesh(meshIdx);
+		}
+	}
+	timer.EndStage("upload");
+
+	for (std::size_t meshIdx = 0u; meshIdx < errors.size(); meshIdx++)
+	{
+		errors[meshIdx].Report(std::cout, (std::string(fName) + " mesh " + std::to_string(meshIdx)).c_str());
+	}
+
+	// One entry for every node that uses a mesh. A mesh used by more than one node gets
+	//  drawn more than once, but the copies share the same GPU buffers.
+	meshData->Meshes.reserve(model.MeshCount());
+	for (std::uint32_t nodeIdx = 0u; nodeIdx < model.NodeCount(); nodeIdx++)
+	{
+		CookedModel::NodeView node = model.GetNode(nodeIdx);
+		for (std::uint32_t i = 0u; i < node.MeshCount; i++)
+		{
+			Mesh mesh = *sceneMeshes[node.Meshes[i]];
+			mesh.Node = firstNode + nodeIdx;
+			meshData->Meshes.push_back(mesh);
+		}
+	}
+
+	timer.Report(std::cout, fName);
+
+	return meshData;
+}
+
+std::shared_ptr<AssimpManModel::TextureImage> AssimpManModel::LoadTextureImage(const char* fName, const AssetArchive* archive)
+{
 	//
 	// Load image with LodePNG
 	//
-	std::vector<unsigned char> textureData; // Raw pixel data
-	std::uint32_t imageWidth, imageHeight; // Image metadata
-
-	// Decode image with LodePNG
-	std::uint32_t decodeError = lodepng::decode(textureData, imageWidth, imageHeight, textureFilename);
+	auto image = std::make_shared<TextureImage>();
+
+	// Decode image with LodePNG - straight from the archive's mapping if it's in there, so
+	//  there's no reading the file into a buffer first
+	AssetArchive::Entry png;
+	std::uint32_t decodeError = (archive && archive->Find(fName, png))
+		? lodepng::decode(image->Pixels, image->Width, image->Height, png.Data, png.Size)
+		: lodepng::decode(image->Pixels, image->Width, image->Height, fName);
+	if (decodeError)
+	{
+		std::cerr << "Could not decode " << fName << ": " << lodepng_error_text(decodeError) << std::endl;
+		return nullptr;
+	}
 
 	// Flip all values on Y
+	std::vector<unsigned char>& textureData = image->Pixels;
+	std::uint32_t imageWidth = image->Width, imageHeight = image->Height;
 	for (int row = 0; row < imageHeight / 2u; row++)
 	{
 		for (int col = 0; col < imageWidth; col++)
@@ -51,93 +135,92 @@ std::shared_ptr<AssimpManModel> AssimpManModel::LoadFromFile(const char* fName,
 	// ... Done loading image. Lode Vandevenne, you're AWESOME dude
 	//
 
-	TexturedShader::Texture manTexture(d3dDevice, d3dDeviceContext, textureData, imageWidth, imageHeight);
+	return image;
+}
 
-	// Load all meshes and whatnot
-	std::vector<Mesh> meshes;
-	meshes.reserve(scene->mNumMeshes);
-	for (std::uint32_t meshIdx = 0u; meshIdx < scene->mNumMeshes; meshIdx++)
+std::shared_ptr<TexturedShader::Texture> AssimpManModel::CreateTexture(ComPtr<ID3D11Device> d3dDevice, ComPtr<ID3D11DeviceContext> d3dDeviceContext, const std::shared_ptr<TextureImage>& image)
+{
+	if (!image)
 	{
-		aiMesh* mesh = scene->mMeshes[meshIdx];
-
-		std::vector<TexturedShader::Vertex> verts;
-		verts.reserve(mesh->mNumVertices);
-
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		aiColor4D specularColor;
-		aiColor4D diffuseColor;
-		aiColor4D ambientColor;
-		float shininess;
-
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specularColor);
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuseColor);
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &ambientColor);
-		aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
-
-		TexturedShader::Material meshMaterial
-		(
-			Color(specularColor.r, specularColor.g, specularColor.b, shininess), // Specular
-			Color(diffuseColor.r, diffuseColor.g, diffuseColor.b, diffuseColor.a), // Diffuse
-			Color(ambientColor.r, ambientColor.g, ambientColor.b, ambientColor.a) // Ambient
-		);
-
-		for (std::uint32_t vertIdx = 0u; vertIdx < mesh->mNumVertices; vertIdx++)
-		{
-			aiVector3D vert = mesh->mVertices[vertIdx];
-			aiVector3D norm = mesh->mNormals[vertIdx];
-			aiVector3D uv = mesh->mTextureCoords[0][vertIdx];
-
-			verts.push_back
-			(
-				TexturedShader::Vertex
-				(
-					Vec3(vert.x, vert.y, vert.z),
-					Vec3(norm.x, norm.y, norm.z),
-					uv.x, uv.y
-				)
-			);
-		}
-
-		std::vector<std::uint32_t> indices;
-		indices.reserve(mesh->mNumFaces * 3u);
-		for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++)
-		{
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[0u]);
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[1u]);
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[2u]);
-		}
+		return nullptr;
+	}
 
-		TexturedShader::RenderCall call(d3dDevice, verts, indices);
+	return std::make_shared<TexturedShader::Texture>(d3dDevice, d3dDeviceContext, image->Pixels, image->Width, image->Height);
+}
 
-		meshes.push_back({ call, meshMaterial });
+std::shared_ptr<AssimpManModel> AssimpManModel::Create(const std::shared_ptr<MeshData>& meshData, const std::shared_ptr<TexturedShader::Texture>& texture)
+{
+	if (!meshData || !texture)
+	{
+		return nullptr;
 	}
 
-	return std::make_shared<AssimpManModel>(meshes, transform, manTexture);
+	return std::make_shared<AssimpManModel>(meshData->Meshes, meshData->Hierarchy, *texture);
 }
 
 bool AssimpManModel::Update(float dt)
 {
+	// Nothing moves on its own yet, but anything that calls SetLocal on the hierarchy
+	//  only costs the nodes underneath it
+	if (hierarchy_.IsDirty())
+	{
+		hierarchy_.Update();
+		UpdateWorldBounds();
+	}
+
 	return true;
 }
 
-bool AssimpManModel::Render(ComPtr<ID3D11DeviceContext> context, TexturedShader* shader) const
+bool AssimpManModel::Render(ComPtr<ID3D11DeviceContext> context, TexturedShader* shader, const Frustum& frustum, CullStats* stats) const
 {
-	shader->SetModelTransform(transform_.GetTransformMatrix());
+	// Cull first - if every mesh is off screen, there's no reason to touch the shader at all
+	if (frustum.Cull(worldBounds_, visible_.data(), stats) == 0u)
+	{
+		return true;
+	}
+
 	shader->SetTexture(texture_);
 
-	for (auto&& mesh : meshes_)
+	std::uint32_t boundNode = TransformHierarchy::NoParent;
+	for (std::size_t meshIdx = 0u; meshIdx < meshes_.size(); meshIdx++)
 	{
-		shader->SetObjectMaterial(mesh.Material);
-		shader->Render(context, mesh.Call);
+		if (!visible_[meshIdx])
+		{
+			continue;
+		}
+
+		// Meshes are listed node by node, so this only changes when the node does
+		if (meshes_[meshIdx].Node != boundNode)
+		{
+			boundNode = meshes_[meshIdx].Node;
+			shader->SetModelTransform(hierarchy_.GetWorldMatrix(boundNode));
+		}
+
+		shader->SetObjectMaterial(meshes_[meshIdx].Material);
+		shader->Render(context, meshes_[meshIdx].Call);
 	}
 
 	return true;
 }
 
-AssimpManModel::AssimpManModel(const std::vector<Mesh>& meshes, const Transform& transform, TexturedShader::Texture texture)
+AssimpManModel::AssimpManModel(const std::vector<Mesh>& meshes, TransformHierarchy hierarchy, TexturedShader::Texture texture)
 	: meshes_(meshes)
-	, transform_(transform)
 	, texture_(texture)
-{}
+	, hierarchy_(std::move(hierarchy))
+{
+	hierarchy_.Update();
+	UpdateWorldBounds();
+	visible_.resize(meshes_.size());
+}
+
+void AssimpManModel::UpdateWorldBounds()
+{
+	worldBounds_.Clear();
+	worldBounds_.Reserve(meshes_.size());
+	for (auto&& mesh : meshes_)
+	{
+		worldBounds_.PushBack(mesh.Bounds.Transformed(hierarchy_.GetWorldMatrix(mesh.Node)));
+	}
+}
 
 };
@@ -1,6 +1,10 @@
 #pragma once
 
-#include <Transform.h>
+#include <AssetArchive.h>
+#include <AssetLoader.h>
+#include <ImportProfile.h>
+#include <TransformHierarchy.h>
+#include <Frustum.h>
 #include <vector>
 #include <memory>
 
@@ -16,14 +20,48 @@ public:
 	{
 		TexturedShader::RenderCall Call;
 		TexturedShader::Material Material;
+		AABB Bounds; // Mesh space
+		std::uint32_t Node; // Which node in the hierarchy places this mesh
+	};
+
+	// Everything from the model file, on the GPU and ready to go - all that's missing is the texture
+	struct MeshData
+	{
+	public:
+		std::vector<Mesh> Meshes;
+		TransformHierarchy Hierarchy;
+	};
+
+	// Decoded RGBA pixels, flipped so the first row is the bottom of the image (where V = 0 is)
+	struct TextureImage
+	{
+	public:
+		std::vector<unsigned char> Pixels;
+		std::uint32_t Width;
+		std::uint32_t Height;
 	};
 
 public:
-	AssimpManModel(const std::vector<Mesh>& meshes, const Transform& transform, TexturedShader::Texture texture);
+	AssimpManModel(const std::vector<Mesh>& meshes, TransformHierarchy hierarchy, TexturedShader::Texture texture);
+
+	// Loads everything, one piece after another, on this thread
+	static std::shared_ptr<AssimpManModel> LoadFromFile(const char* fName, const char* textureFilename, ComPtr<ID3D11Device> d3dDevice, ComPtr<ID3D11DeviceContext> d3dDeviceContext, const Transform& transform, ImportProfile profile = ImportProfile::Default);
+
+	// The pieces of LoadFromFile, for running as separate AssetLoader jobs. Each one returns
+	//  nullptr if it (or whatever it was given) failed. With an archive, files that are in it
+	//  come out of it (see AssetArchive.h), and anything else comes off the disk as usual.
+	// The model file and the image don't need each other, and can load at the same time.
+	//  LoadMeshes only needs the device, so it's fine on a worker - with a loader, it
+	//  cooks (if it has to), encodes and uploads the meshes on the loader's threads too.
+	static std::shared_ptr<MeshData> LoadMeshes(const char* fName, ComPtr<ID3D11Device> d3dDevice, const Transform& transform, ImportProfile profile = ImportProfile::Default, AssetLoader* loader = nullptr, const AssetArchive* archive = nullptr);
+	static std::shared_ptr<TextureImage> LoadTextureImage(const char* fName, const AssetArchive* archive = nullptr);
+	// Generates mip maps with the context, so this one belongs on the main thread
+	static std::shared_ptr<TexturedShader::Texture> CreateTexture(ComPtr<ID3D11Device> d3dDevice, ComPtr<ID3D11DeviceContext> d3dDeviceContext, const std::shared_ptr<TextureImage>& image);
+	static std::shared_ptr<AssimpManModel> Create(const std::shared_ptr<MeshData>& meshData, const std::shared_ptr<TexturedShader::Texture>& texture);
 
-	static std::shared_ptr<AssimpManModel> LoadFromFile(const char* fName, const char* textureFilename, ComPtr<ID3D11Device> d3dDevice, ComPtr<ID3D11DeviceContext> d3dDeviceContext, const Transform& transform);
 	bool Update(float dt);
-	bool Render(ComPtr<ID3D11DeviceContext> context, TexturedShader* shader) const;
+	// Meshes outside of the frustum are skipped. If stats is given, the culling results are added to it.
+	bool Render(ComPtr<ID3D11DeviceContext> context, TexturedShader* shader, const Frustum& frustum, CullStats* stats = nullptr) const;
 
 	AssimpManModel(const AssimpManModel&) = delete;
 	~AssimpManModel() = default;
@@ -31,7 +69,15 @@ public:
 protected:
 	std::vector<Mesh> meshes_;
 	TexturedShader::Texture texture_;
-	Transform transform_;
+	// Node 0 is the transform the model was loaded with, and the file's own node tree
+	//  (if it has one) hangs off of that
+	TransformHierarchy hierarchy_;
+
+	// World space bounds of each mesh, redone whenever the hierarchy changes
+	AABBSoA worldBounds_;
+	mutable std::vector<std::uint8_t> visible_; // Scratch space for culling
+
+	void UpdateWorldBounds();
 };
 
 };
\ No newline at end of file
@@ -1,107 +1,123 @@
 #include "AssimpRoadModel.h"
 
-#include <assimp/cimport.h>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <assimp/material.h>
+#include <CookedModel.h>
 
 #include <iostream>
+#include <utility>
 
 namespace sess
 {
 
-std::shared_ptr<AssimpRoadModel> AssimpRoadModel::LoadFromFile(const char * fName, ComPtr<ID3D11Device> d3dDevice, const Transform & transform)
+std::shared_ptr<AssimpRoadModel> AssimpRoadModel::LoadFromFile(const char * fName, ComPtr<ID3D11Device> d3dDevice, const Transform & transform, ImportProfile profile, AssetLoader* loader, const AssetArchive* archive)
 {
-	const aiScene* scene = aiImportFile(fName, aiProcessPreset_TargetRealtime_MaxQuality);
-
-	if (!scene)
+	LoadTimer timer;
+	CookedModel model;
+	if (!LoadCookedModel(fName, ImportProfileFlags(profile), MaterialOnlyShader::Vertex::Layout(), model, &timer, archive, loader ? loader->ForEachFunction() : ForEachFn()))
 	{
 		std::cerr << "Could not load file " << fName << std::endl;
 		return nullptr;
 	}
 
-	// Load all meshes and whatnot
-	std::vector<Mesh> meshes;
-	meshes.reserve(scene->mNumMeshes);
-	for (std::uint32_t meshIdx = 0u; meshIdx < scene->mNumMeshes; meshIdx++)
+	// The meshes are all in their own space - the node tree is what puts them in place.
+	//  The transform passed in goes above all of it, so the whole model moves together.
+	TransformHierarchy hierarchy;
+	std::uint32_t root = hierarchy.Add(transform);
+	std::uint32_t firstNode = model.AddNodes(hierarchy, root);
+
+	// GPU buffers straight out of the cooked model (see CookedModel.h) - no copy of the
+	//  vertices on our side at all
+	std::vector<Mesh> sceneMeshes;
+	sceneMeshes.reserve(model.MeshCount());
+	for (std::uint32_t meshIdx = 0u; meshIdx < model.MeshCount(); meshIdx++)
 	{
-		aiMesh* mesh = scene->mMeshes[meshIdx];
-
-		std::vector<MaterialOnlyShader::Vertex> verts;
-		verts.reserve(mesh->mNumVertices);
-		
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		aiColor4D specularColor;
-		aiColor4D diffuseColor;
-		aiColor4D ambientColor;
-		float shininess;
-
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specularColor);
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuseColor);
-		aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &ambientColor);
-		aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
-
-		MaterialOnlyShader::Material meshMaterial
-		(
-			Color(specularColor.r, specularColor.g, specularColor.b, shininess), // Specular
-			Color(diffuseColor.r, diffuseColor.g, diffuseColor.b, diffuseColor.a), // Diffuse
-			Color(ambientColor.r, ambientColor.g, ambientColor.b, ambientColor.a) // Ambient
-		);
-
-		for (std::uint32_t vertIdx = 0u; vertIdx < mesh->mNumVertices; vertIdx++)
-		{
-			aiVector3D vert = mesh->mVertices[vertIdx];
-			aiVector3D norm = mesh->mNormals[vertIdx];
-
-			verts.push_back
-			(
-				MaterialOnlyShader::Vertex
-				(
-					Vec3(vert.x, vert.y, vert.z),
-					Vec3(norm.x, norm.y, norm.z)
-				)
-			);
-		}
+		CookedModel::MeshView cooked = model.GetMesh(meshIdx);
+		MaterialOnlyShader::Material meshMaterial(cooked.Specular, cooked.Diffuse, cooked.Ambient);
+		MaterialOnlyShader::RenderCall call(d3dDevice, model.GetVertices<MaterialOnlyShader::Vertex>(meshIdx), cooked.VertexCount, cooked.Indices, cooked.IndexCount, cooked.Ranges, cooked.RangeCount);
 
-		std::vector<std::uint32_t> indices;
-		indices.reserve(mesh->mNumFaces * 3u);
-		for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++)
+		sceneMeshes.push_back({ call, meshMaterial, cooked.Bounds, root });
+	}
+	timer.EndStage("upload");
+
+	// One entry for every node that uses a mesh. A mesh used by more than one node gets
+	//  drawn more than once, but the copies share the same GPU buffers.
+	std::vector<Mesh> meshes;
+	meshes.reserve(model.MeshCount());
+	for (std::uint32_t nodeIdx = 0u; nodeIdx < model.NodeCount(); nodeIdx++)
+	{
+		CookedModel::NodeView node = model.GetNode(nodeIdx);
+		for (std::uint32_t i = 0u; i < node.MeshCount; i++)
 		{
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[0u]);
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[1u]);
-			indices.push_back(mesh->mFaces[faceIdx].mIndices[2u]);
+			Mesh mesh = sceneMeshes[node.Meshes[i]];
+			mesh.Node = firstNode + nodeIdx;
+			meshes.push_back(mesh);
 		}
-
-		MaterialOnlyShader::RenderCall call(d3dDevice, verts, indices);
-
-		meshes.push_back({ call, meshMaterial });
 	}
 
-	return std::make_shared<AssimpRoadModel>(meshes, transform);
+	timer.Report(std::cout, fName);
+
+	return std::make_shared<AssimpRoadModel>(meshes, std::move(hierarchy));
 }
 
 bool AssimpRoadModel::Update(float dt)
 {
+	// Nothing moves on its own yet, but anything that calls SetLocal on the hierarchy
+	//  only costs the nodes underneath it
+	if (hierarchy_.IsDirty())
+	{
+		hierarchy_.Update();
+		UpdateWorldBounds();
+	}
+
 	return true;
 }
 
-bool AssimpRoadModel::Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader) const
+bool AssimpRoadModel::Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader, const Frustum& frustum, CullStats* stats) const
 {
-	shader->SetModelTransform(transform_.GetTransformMatrix());
+	// Cull first - if every mesh is off screen, there's no reason to touch the shader at all
+	if (frustum.Cull(worldBounds_, visible_.data(), stats) == 0u)
+	{
+		return true;
+	}
 
-	for (auto&& mesh : meshes_)
+	std::uint32_t boundNode = TransformHierarchy::NoParent;
+	for (std::size_t meshIdx = 0u; meshIdx < meshes_.size(); meshIdx++)
 	{
-		shader->SetObjectMaterial(mesh.Material);
-		shader->Render(context, mesh.Call);
+		if (!visible_[meshIdx])
+		{
+			continue;
+		}
+
+		// Meshes are listed node by node, so this only changes when the node does
+		if (meshes_[meshIdx].Node != boundNode)
+		{
+			boundNode = meshes_[meshIdx].Node;
+			shader->SetModelTransform(hierarchy_.GetWorldMatrix(boundNode));
+		}
+
+		shader->SetObjectMaterial(meshes_[meshIdx].Material);
+		shader->Render(context, meshes_[meshIdx].Call);
 	}
 
 	return true;
 }
 
-AssimpRoadModel::AssimpRoadModel(const std::vector<Mesh>& meshes, const Transform& transform)
+AssimpRoadModel::AssimpRoadModel(const std::vector<Mesh>& meshes, TransformHierarchy hierarchy)
 	: meshes_(meshes)
-	, transform_(transform)
-{}
+	, hierarchy_(std::move(hierarchy))
+{
+	hierarchy_.Update();
+	UpdateWorldBounds();
+	visible_.resize(meshes_.size());
+}
 
+void AssimpRoadModel::UpdateWorldBounds()
+{
+	worldBounds_.Clear();
+	worldBounds_.Reserve(meshes_.size());
+	for (auto&& mesh : meshes_)
+	{
+		worldBounds_.PushBack(mesh.Bounds.Transformed(hierarchy_.GetWorldMatrix(mesh.Node)));
+	}
+}
 
 };
\ No newline at end of file
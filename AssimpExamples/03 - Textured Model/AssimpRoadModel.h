@@ -1,6 +1,10 @@
 #pragma once
 
-#include <Transform.h>
+#include <AssetArchive.h>
+#include <AssetLoader.h>
+#include <ImportProfile.h>
+#include <TransformHierarchy.h>
+#include <Frustum.h>
 #include <vector>
 #include <memory>
 
@@ -16,22 +20,34 @@ public:
 	{
 		MaterialOnlyShader::RenderCall Call;
 		MaterialOnlyShader::Material Material;
+		AABB Bounds; // Mesh space
+		std::uint32_t Node; // Which node in the hierarchy places this mesh
 	};
 
 public:
-	
-	AssimpRoadModel(const std::vector<Mesh>& meshes, const Transform& transform);
+	AssimpRoadModel(const std::vector<Mesh>& meshes, TransformHierarchy hierarchy);
 
-	static std::shared_ptr<AssimpRoadModel> LoadFromFile(const char* fName, ComPtr<ID3D11Device> d3dDevice, const Transform& transform);
+	// With an archive, the model comes out of that if it's in there (see AssetArchive.h). With
+	//  a loader, a fresh cook converts its meshes on the loader's threads.
+	static std::shared_ptr<AssimpRoadModel> LoadFromFile(const char* fName, ComPtr<ID3D11Device> d3dDevice, const Transform& transform, ImportProfile profile = ImportProfile::Default, AssetLoader* loader = nullptr, const AssetArchive* archive = nullptr);
 	bool Update(float dt);
-	bool Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader) const;
+	// Meshes outside of the frustum are skipped. If stats is given, the culling results are added to it.
+	bool Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader, const Frustum& frustum, CullStats* stats = nullptr) const;
 
 	AssimpRoadModel(const AssimpRoadModel&) = delete;
 	~AssimpRoadModel() = default;
 
 protected:
 	std::vector<Mesh> meshes_;
-	Transform transform_;
+	// Node 0 is the transform the model was loaded with, and the file's own node tree
+	//  (if it has one) hangs off of that
+	TransformHierarchy hierarchy_;
+
+	// World space bounds of each mesh, redone whenever the hierarchy changes
+	AABBSoA worldBounds_;
+	mutable std::vector<std::uint8_t> visible_; // Scratch space for culling
+
+	void UpdateWorldBounds();
 };
 
 };
\ No newline at end of file
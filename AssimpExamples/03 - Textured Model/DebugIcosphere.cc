@@ -1,5 +1,7 @@
 #include "DebugIcosphere.h"
 
+#include <algorithm>
+
 namespace sess
 {
 
@@ -96,11 +98,13 @@ DebugMaterialIcosphere::DebugMaterialIcosphere
 	, rotationSpeed_(rotationSpeed)
 	, rotationAngle_(0.f)
 	, modelTransform_(position, Quaternion::Identity, scale)
+	, bounds_()
 {
 	std::vector<MaterialOnlyShader::Vertex> vertices;
 	vertices.reserve(_countof(verts));
 	for (std::uint32_t idx = 0u; idx < _countof(verts); idx += 3)
 	{
+		bounds_.Radius = std::max(bounds_.Radius, Vec3(verts[idx], verts[idx + 1u], verts[idx + 2u]).Magnitude());
 		vertices.push_back
 		(
 			MaterialOnlyShader::Vertex
@@ -134,10 +138,23 @@ bool DebugMaterialIcosphere::Update(float dt)
 	return true;
 }
 
-bool DebugMaterialIcosphere::Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader) const
+bool DebugMaterialIcosphere::Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader, const Frustum& frustum, CullStats* stats) const
 {
+	Affine3x4 model = modelTransform_.GetAffineMatrix();
+
+	bool visible = frustum.Intersects(bounds_.Transformed(model));
+	if (stats)
+	{
+		stats->Tested++;
+		stats->Rejected += visible ? 0u : 1u;
+	}
+	if (!visible)
+	{
+		return true;
+	}
+
 	shader->SetObjectMaterial(material_);
-	shader->SetModelTransform(modelTransform_.GetTransformMatrix());
+	shader->SetModelTransform(model);
 	shader->Render(context, *call_);
 
 	return true;
@@ -4,6 +4,7 @@
 #include "MaterialOnlyShader.h"
 
 #include <Transform.h>
+#include <Frustum.h>
 
 #include <d3d11.h>
 #include <wrl.h>
@@ -21,7 +22,8 @@ public:
 	~DebugMaterialIcosphere() = default;
 
 	bool Update(float dt);
-	bool Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader) const;
+	// Skipped entirely if the sphere is outside of the frustum
+	bool Render(ComPtr<ID3D11DeviceContext> context, MaterialOnlyShader* shader, const Frustum& frustum, CullStats* stats = nullptr) const;
 
 protected:
 	std::shared_ptr<MaterialOnlyShader::RenderCall> call_;
@@ -31,6 +33,7 @@ protected:
 	float rotationAngle_;
 
 	Transform modelTransform_;
+	BoundingSphere bounds_; // Model space
 };
 
 };
\ No newline at end of file
@@ -0,0 +1,12 @@
+// Per-frame camera data, shared by every shader. PerFrameConstantBuffer copies
+//  FreeCamera::FrameBlock in here as-is, so this must match that struct.
+// The matrices are already column major (HLSL's default), nothing gets transposed.
+
+cbuffer PerFrame : register(b1)
+{
+	matrix mView;
+	matrix mProj;
+	matrix mViewProj;
+	matrix mInverseView;
+	float4 CameraPosition;
+};
@@ -7,25 +7,55 @@ namespace sess
 {
 
 MaterialOnlyShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const std::vector<MaterialOnlyShader::Vertex>& vertices, const std::vector<std::uint32_t>& indices)
+	: RenderCall(device, vertices.data(), vertices.size(), indices.data(), indices.size())
+{}
+
+MaterialOnlyShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const MaterialOnlyShader::Vertex* vertices, std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount)
+	: VertexBuffer(nullptr)
+	, IndexBuffer(nullptr)
+	, IndexFormat(DXGI_FORMAT_R32_UINT)
+	, NumberOfIndices((std::uint32_t)indexCount)
+	, Ranges(1u, IndexRange{ 0u, (std::uint32_t)indexCount, 0u })
+{
+	if (vertexCount > MaxShortIndexVertices)
+	{
+		CreateBuffers(device, vertices, vertexCount, indices, indexCount);
+		return;
+	}
+
+	// Everything fits in 16 bits - half the index buffer for free
+	std::vector<std::uint16_t> shortIndices(indexCount);
+	if (indexCount > 0u)
+	{
+		NarrowIndices(indices, &shortIndices[0], indexCount);
+	}
+	IndexFormat = DXGI_FORMAT_R16_UINT;
+	CreateBuffers(device, vertices, vertexCount, shortIndices.data(), indexCount);
+}
+
+MaterialOnlyShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const MaterialOnlyShader::Vertex* vertices, std::size_t vertexCount, const std::uint16_t* indices, std::size_t indexCount, const IndexRange* ranges, std::size_t rangeCount)
 	: VertexBuffer(nullptr)
 	, IndexBuffer(nullptr)
-	, NumberOfIndices(0u)
+	, IndexFormat(DXGI_FORMAT_R16_UINT)
+	, NumberOfIndices((std::uint32_t)indexCount)
+	, Ranges(ranges, ranges + rangeCount)
+{
+	CreateBuffers(device, vertices, vertexCount, indices, indexCount);
+}
+
+void MaterialOnlyShader::RenderCall::CreateBuffers(ComPtr<ID3D11Device> device, const MaterialOnlyShader::Vertex* vertices, std::size_t vertexCount, const void* indices, std::size_t indexCount)
 {
 	HRESULT hr = {};
 	D3D11_BUFFER_DESC vbDesc = {};
 	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	vbDesc.CPUAccessFlags = 0x00;
 	vbDesc.MiscFlags = 0x00;
-	vbDesc.ByteWidth = sizeof(MaterialOnlyShader::Vertex) * (UINT)vertices.size();
+	vbDesc.ByteWidth = sizeof(MaterialOnlyShader::Vertex) * (UINT)vertexCount;
 	vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
 	vbDesc.StructureByteStride = 0x00;
 
-	// Vector elements must be stored contiguously. As per the C++11 standard,
-	//  they don't necessarily have to be stored as an array, but the identity
-	//  &v[n] = &v[0] + n for all 0 <= n < v.size() must hold true.
-	// http://www.open-std.org/jtc1/sc22/wg21/docs/lwg-defects.html#69
 	D3D11_SUBRESOURCE_DATA vertexData = {};
-	vertexData.pSysMem = &vertices[0];
+	vertexData.pSysMem = vertices;
 	
 	hr = device->CreateBuffer(&vbDesc, &vertexData, &VertexBuffer);
 	if (FAILED(hr))
@@ -38,16 +68,19 @@ MaterialOnlyShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const st
 	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	ibDesc.CPUAccessFlags = 0x00;
 	ibDesc.MiscFlags = 0x00;
-	ibDesc.ByteWidth = sizeof(std::uint32_t) * (UINT)indices.size();
+	ibDesc.ByteWidth = (IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(std::uint16_t) : sizeof(std::uint32_t)) * (UINT)indexCount;
 	ibDesc.Usage = D3D11_USAGE_IMMUTABLE;
 	ibDesc.StructureByteStride = 0x00;
 
 	D3D11_SUBRESOURCE_DATA indexData = {};
-	indexData.pSysMem = &indices[0];
+	indexData.pSysMem = indices;
 
 	hr = device->CreateBuffer(&ibDesc, &indexData, &IndexBuffer);
-
-	NumberOfIndices = (std::uint32_t)indices.size();
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to allocate index buffer for render call! " << hr << std::endl;
+		return;
+	}
 }
 
 MaterialOnlyShader::MaterialOnlyShader()
@@ -55,13 +88,9 @@ MaterialOnlyShader::MaterialOnlyShader()
 	, pixelShader_(nullptr)
 	, inputLayout_(nullptr)
 	, vsc_object_(nullptr)
-	, vsc_frame_(nullptr)
 	, psc_object_(nullptr)
-	, psc_frame_(nullptr)
 	, psc_scene_(nullptr)
-	, DVSC_PerObject({ { Matrix::Identity }, true })
-	, DVSC_PerFrame({ { Matrix::Identity, Matrix::Identity }, true })
-	, DPSC_PerFrame({ { Vec3::Zero }, true })
+	, DVSC_PerObject({ { Affine3x4::Identity }, true })
 	, DPSC_PerObject({ { { Color::Palette::Black, Color::Palette::Black, Color::Palette::Black } }, true })
 	, DPSC_PerScene({ { { Vec3::UnitY, Color::Palette::CreamIGuess, Color::Palette::CreamIGuess, Color::Palette::CreamIGuess } }, true })
 {}
@@ -151,14 +180,6 @@ std::future<bool> MaterialOnlyShader::Initialize(ComPtr<ID3D11Device> device)
 			return false;
 		}
 
-		bufferDesc.ByteWidth = sizeof(MaterialOnlyShader::DVSC_PerFrame.VSC_PerFrame);
-		hr = device->CreateBuffer(&bufferDesc, nullptr, &vsc_frame_);
-		if (FAILED(hr))
-		{
-			std::cerr << "Failed to create vertex shader per-frame constant buffer" << std::endl;
-			return false;
-		}
-
 		bufferDesc.ByteWidth = sizeof(MaterialOnlyShader::DPSC_PerObject.PSC_PerObject);
 		hr = device->CreateBuffer(&bufferDesc, nullptr, &psc_object_);
 		if (FAILED(hr))
@@ -167,14 +188,6 @@ std::future<bool> MaterialOnlyShader::Initialize(ComPtr<ID3D11Device> device)
 			return false;
 		}
 
-		bufferDesc.ByteWidth = sizeof(MaterialOnlyShader::DPSC_PerFrame.PSC_PerFrame);
-		hr = device->CreateBuffer(&bufferDesc, nullptr, &psc_frame_);
-		if (FAILED(hr))
-		{
-			std::cerr << "Failed to create pixel shader per-frame constant buffer" << std::endl;
-			return false;
-		}
-
 		bufferDesc.ByteWidth = sizeof(MaterialOnlyShader::DPSC_PerScene.PSC_PerScene);
 		hr = device->CreateBuffer(&bufferDesc, nullptr, &psc_scene_);
 		if (FAILED(hr))
@@ -237,23 +250,6 @@ bool MaterialOnlyShader::Render(ComPtr<ID3D11DeviceContext> context, const Rende
 	// Update constant buffers. This involves mapping a chunk of host-side (i.e., CPU-side)
 	//  memory to the constant buffer, writing to that memory, and then uploading to the
 	//  graphics card. The mapping and uploading operations are "map" and "unmap", respectively
-	if (DVSC_PerFrame.isDirty)
-	{
-		D3D11_MAPPED_SUBRESOURCE vscb;
-		
-		hr = context->Map(vsc_frame_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0x00, &vscb);
-		if (FAILED(hr))
-		{
-			std::cerr << "Material only shader render: Failed to map vertex per-frame buffer for CPU writing" << std::endl;
-			return false;
-		}
-
-		memcpy(vscb.pData, &(DVSC_PerFrame.VSC_PerFrame), sizeof(DVSC_PerFrame.VSC_PerFrame));
-		context->Unmap(vsc_frame_.Get(), 0);
-
-		DVSC_PerFrame.isDirty = false;
-	}
-
 	if (DVSC_PerObject.isDirty)
 	{
 		D3D11_MAPPED_SUBRESOURCE vscb;
@@ -271,23 +267,6 @@ bool MaterialOnlyShader::Render(ComPtr<ID3D11DeviceContext> context, const Rende
 		DVSC_PerObject.isDirty = false;
 	}
 
-	if (DPSC_PerFrame.isDirty)
-	{
-		D3D11_MAPPED_SUBRESOURCE pscb;
-
-		hr = context->Map(psc_frame_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0x00, &pscb);
-		if (FAILED(hr))
-		{
-			std::cerr << "Material only shader render: Failed to map pixel per-frame buffer for CPU writing" << std::endl;
-			return false;
-		}
-
-		memcpy(pscb.pData, &(DPSC_PerFrame.PSC_PerFrame), sizeof(DPSC_PerFrame.PSC_PerFrame));
-		context->Unmap(psc_frame_.Get(), 0);
-
-		DPSC_PerFrame.isDirty = false;
-	}
-
 	if (DPSC_PerObject.isDirty)
 	{
 		D3D11_MAPPED_SUBRESOURCE pscb;
@@ -323,11 +302,10 @@ bool MaterialOnlyShader::Render(ComPtr<ID3D11DeviceContext> context, const Rende
 	}
 
 	// Set the constant buffers to the pipeline
-	ID3D11Buffer* vsCBuffers[] = { vsc_object_.Get(), vsc_frame_.Get() };
-	context->VSSetConstantBuffers(0, _countof(vsCBuffers), vsCBuffers);
-
-	ID3D11Buffer* psCBuffers[] = { psc_object_.Get(), psc_frame_.Get(), psc_scene_.Get() };
-	context->PSSetConstantBuffers(0, _countof(psCBuffers), psCBuffers);
+	// Slot 1 (per frame) is shared between all shaders - see PerFrameConstantBuffer
+	context->VSSetConstantBuffers(0, 1, vsc_object_.GetAddressOf());
+	context->PSSetConstantBuffers(0, 1, psc_object_.GetAddressOf());
+	context->PSSetConstantBuffers(2, 1, psc_scene_.GetAddressOf());
 
 	// Set the input vertex buffer
 	std::uint32_t stride = sizeof(MaterialOnlyShader::Vertex);
@@ -335,51 +313,36 @@ bool MaterialOnlyShader::Render(ComPtr<ID3D11DeviceContext> context, const Rende
 	// Set the vertex buffer as input to the graphics pipeline. Only using one.
 	context->IASetVertexBuffers(0, 1, call.VertexBuffer.GetAddressOf(), &stride, &offset);
 
-	// Set the index buffer as input to the graphics pipeline. Specify that we're using 32 bit unsigned integers
-	//  DXGI is weird about formats, R32 means "one component, having 32 bits". The "R" stands for "red"
+	// Set the index buffer as input to the graphics pipeline. Specify whether we're using 16 or 32 bit unsigned integers
+	//  DXGI is weird about formats, R16 means "one component, having 16 bits". The "R" stands for "red"
 	//  A set of three values, 32 bit uints each, would be DXGI_FORMAT_R32G32B32_UINT, for example.
-	context->IASetIndexBuffer(call.IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0u);
+	context->IASetIndexBuffer(call.IndexBuffer.Get(), call.IndexFormat, 0u);
 
 	// We're drawing triangles...
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	// Draw! Draw! Draw!
-	context->DrawIndexed(call.NumberOfIndices, 0u, 0u);
+	// Meshes too big for 16 bit indices come in a few ranges, each one offset into the vertex buffer
+	for (const IndexRange& range : call.Ranges)
+	{
+		context->DrawIndexed(range.IndexCount, range.StartIndex, (INT)range.BaseVertex);
+	}
 
 	return true;
 }
 
-void MaterialOnlyShader::SetModelTransform(const Matrix& modelTransformation)
+void MaterialOnlyShader::SetModelTransform(const Affine3x4& modelTransformation)
 {
 	DVSC_PerObject.VSC_PerObject.Model = modelTransformation;
 	DVSC_PerObject.isDirty = true;
 }
 
-void MaterialOnlyShader::SetViewTransform(const Matrix& viewTransform)
-{
-	DVSC_PerFrame.VSC_PerFrame.View = viewTransform.Transpose();
-	DVSC_PerFrame.isDirty = true;
-}
-
-void MaterialOnlyShader::SetProjectionTransform(const Matrix& projTransform)
-{
-	DVSC_PerFrame.VSC_PerFrame.Proj = projTransform.Transpose();
-	DVSC_PerFrame.isDirty = true;
-}
-
 void MaterialOnlyShader::SetObjectMaterial(const Material& objectMaterial)
 {
 	DPSC_PerObject.PSC_PerObject.ObjectMaterial = objectMaterial;
 	DPSC_PerObject.isDirty = true;
 }
 
-void MaterialOnlyShader::SetCameraPosition(const Vec3& cameraPosition)
-{
-	DPSC_PerFrame.PSC_PerFrame.CameraPosition = cameraPosition;
-	DPSC_PerFrame.PSC_PerFrame.__extra = 1.f;
-	DPSC_PerFrame.isDirty = true;
-}
-
 void MaterialOnlyShader::SetSunLight(const DirectionalLight& light)
 {
 	DPSC_PerScene.PSC_PerScene.SunLight = light;
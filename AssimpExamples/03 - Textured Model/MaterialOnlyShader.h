@@ -23,6 +23,8 @@
 #include <future>
 #include <vector>
 #include <MathExtras.h>
+#include <MeshConvert.h>
+#include <cstddef>
 
 using Microsoft::WRL::ComPtr;
 
@@ -45,6 +47,15 @@ public:
 		Vertex(const Vec3& pos, const Vec3& norm)
 			: Position(pos), __one(1.f), Normal(norm), __zero(0.f)
 		{}
+
+		// Leaves everything unset - model vertices get written as raw bytes by ConvertAssimpVertices
+		//  (going by Layout()) when a model is cooked, and read straight out of the cooked file
+		Vertex() {}
+
+		static MeshVertexLayout Layout()
+		{
+			return MeshVertexLayout(sizeof(Vertex), offsetof(Vertex, Position), offsetof(Vertex, Normal));
+		}
 	};
 
 	// Both lights and materials have three color components - ambient, specular, diffuse
@@ -85,11 +96,8 @@ public:
 	//  must be called. The render call itself has no notion of any of these things.
 	// That also helps in optimizations - DX11/GL/VK all have optimizations that can be
 	//  applied by using this sort of pattern. Different optimizations, but optimizations.
-	void SetModelTransform(const Matrix& modelTransform);
-	void SetViewTransform(const Matrix& viewTransform);
-	void SetProjectionTransform(const Matrix& projTransform);
+	void SetModelTransform(const Affine3x4& modelTransform);
 	void SetObjectMaterial(const Material& objectMaterial);
-	void SetCameraPosition(const Vec3& cameraPosition);
 	void SetSunLight(const DirectionalLight& light);
 
 public:
@@ -101,6 +109,11 @@ public:
 	{
 	public:
 		RenderCall(ComPtr<ID3D11Device> device, const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices);
+		// Same, from plain arrays - for vertex data that isn't in a vector, like a memory mapped
+		//  CookedModel (see CookedModel.h)
+		RenderCall(ComPtr<ID3D11Device> device, const Vertex* vertices, std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount);
+		// 16 bit indices, drawn one range at a time - what a CookedModel mesh comes with
+		RenderCall(ComPtr<ID3D11Device> device, const Vertex* vertices, std::size_t vertexCount, const std::uint16_t* indices, std::size_t indexCount, const IndexRange* ranges, std::size_t rangeCount);
 
 	public:
 		// Here's the DirectX specific stuff
@@ -108,7 +121,12 @@ public:
 		//  too darn good to forego
 		ComPtr<ID3D11Buffer> VertexBuffer;
 		ComPtr<ID3D11Buffer> IndexBuffer;
+		DXGI_FORMAT IndexFormat; // DXGI_FORMAT_R16_UINT whenever the vertices fit, otherwise R32
 		std::uint32_t NumberOfIndices;
+		std::vector<IndexRange> Ranges; // One DrawIndexed each
+
+	protected:
+		void CreateBuffers(ComPtr<ID3D11Device> device, const Vertex* vertices, std::size_t vertexCount, const void* indices, std::size_t indexCount);
 	};
 
 public:
@@ -138,10 +156,10 @@ protected:
 	//  - Per object: Material
 	//  - Per frame: Camera position
 	//  - Per scene: Sunlight position
+	// The per frame stuff is the same for every shader, so it isn't owned by any of them -
+	//  PerFrameConstantBuffer uploads it once per frame and leaves it bound in slot 1.
 	ComPtr<ID3D11Buffer> vsc_object_;
-	ComPtr<ID3D11Buffer> vsc_frame_;
 	ComPtr<ID3D11Buffer> psc_object_;
-	ComPtr<ID3D11Buffer> psc_frame_;
 	ComPtr<ID3D11Buffer> psc_scene_;
 
 protected:
@@ -151,21 +169,11 @@ protected:
 	{
 		struct VSC_PerObject_Type
 		{
-			Matrix Model;
+			Affine3x4 Model; // float4x3 in the shader - the 0 0 0 1 column isn't uploaded
 		} VSC_PerObject;
 		bool isDirty;
 	} DVSC_PerObject;
 
-	struct // Constant buffer for the vertex shader, per frame
-	{
-		struct VSC_PerFrame_Type
-		{
-			Matrix View;
-			Matrix Proj;
-		} VSC_PerFrame;
-		bool isDirty;
-	} DVSC_PerFrame;
-
 	struct // Constant buffer for the pixel shader, per object
 	{
 		struct PSC_PerObject_Type
@@ -175,16 +183,6 @@ protected:
 		bool isDirty;
 	} DPSC_PerObject;
 
-	struct // Constant buffer for the pixel shader, per frame
-	{
-		struct PSC_PerFrame_Type
-		{
-			Vec3 CameraPosition;
-			float __extra;
-		} PSC_PerFrame;
-		bool isDirty;
-	} DPSC_PerFrame;
-
 	struct // Constant buffer for the pixel shader, per scene
 	{
 		struct PSC_PerScene_Type
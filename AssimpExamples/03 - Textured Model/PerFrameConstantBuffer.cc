@@ -0,0 +1,65 @@
+#include "PerFrameConstantBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace sess
+{
+
+static_assert(sizeof(FreeCamera::FrameBlock) % 16 == 0, "Constant buffer sizes must be a multiple of 16 bytes");
+
+PerFrameConstantBuffer::PerFrameConstantBuffer()
+	: buffer_(nullptr)
+	, uploadedRevision_(0u)
+	, hasUploaded_(false)
+{}
+
+bool PerFrameConstantBuffer::Initialize(ComPtr<ID3D11Device> device)
+{
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0x00;
+	bufferDesc.StructureByteStride = 0x00;
+	bufferDesc.ByteWidth = sizeof(FreeCamera::FrameBlock);
+
+	HRESULT hr = device->CreateBuffer(&bufferDesc, nullptr, &buffer_);
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to create per-frame constant buffer" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool PerFrameConstantBuffer::Update(ComPtr<ID3D11DeviceContext> context, FreeCamera& camera)
+{
+	const FreeCamera::FrameBlock& block = camera.GetFrameBlock();
+
+	// If the camera hasn't changed, whatever is on the GPU already is still good
+	if (!hasUploaded_ || camera.GetFrameBlockRevision() != uploadedRevision_)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT hr = context->Map(buffer_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0x00, &mapped);
+		if (FAILED(hr))
+		{
+			std::cerr << "Failed to map per-frame buffer for CPU writing" << std::endl;
+			return false;
+		}
+
+		memcpy(mapped.pData, &block, sizeof(FreeCamera::FrameBlock));
+		context->Unmap(buffer_.Get(), 0);
+
+		uploadedRevision_ = camera.GetFrameBlockRevision();
+		hasUploaded_ = true;
+	}
+
+	context->VSSetConstantBuffers(Slot, 1, buffer_.GetAddressOf());
+	context->PSSetConstantBuffers(Slot, 1, buffer_.GetAddressOf());
+
+	return true;
+}
+
+};
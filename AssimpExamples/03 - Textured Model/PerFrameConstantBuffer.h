@@ -0,0 +1,44 @@
+#pragma once
+
+// Constant buffer holding everything about the camera for one frame - the view and
+//  projection matrices, their product, the inverse view matrix and the camera position.
+// Every shader in this demo needs the same per-frame data, so instead of each shader
+//  keeping (and uploading) its own copy, this one buffer is filled once per frame and
+//  left bound to register b1 for both vertex and pixel shaders.
+// The camera's FrameBlock is already in the layout HLSL wants, so filling it is one copy.
+// The shaders see it through FrameDefs.hlsli.
+
+#include <FreeCamera.h>
+
+#include <d3d11.h>
+#include <wrl.h>
+#include <cstdint>
+
+using Microsoft::WRL::ComPtr;
+
+namespace sess
+{
+
+class PerFrameConstantBuffer
+{
+public:
+	static const UINT Slot = 1u;
+
+public:
+	PerFrameConstantBuffer();
+	PerFrameConstantBuffer(const PerFrameConstantBuffer&) = delete;
+	~PerFrameConstantBuffer() = default;
+
+	bool Initialize(ComPtr<ID3D11Device> device);
+
+	// Uploads the camera's frame block, but only if it changed since the last upload,
+	//  and binds the buffer for the vertex and pixel shader stages.
+	bool Update(ComPtr<ID3D11DeviceContext> context, FreeCamera& camera);
+
+protected:
+	ComPtr<ID3D11Buffer> buffer_;
+	std::uint32_t uploadedRevision_;
+	bool hasUploaded_;
+};
+
+};
@@ -7,25 +7,88 @@ namespace sess
 {
 
 TexturedShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const std::vector<TexturedShader::Vertex>& vertices, const std::vector<std::uint32_t>& indices)
+	: RenderCall(device, vertices.data(), vertices.size(), indices.data(), indices.size())
+{}
+
+TexturedShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const TexturedShader::Vertex* vertices, std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount)
+	: VertexBuffer(nullptr)
+	, VertexStride(sizeof(TexturedShader::Vertex))
+	, DecodeBuffer(nullptr)
+	, IndexBuffer(nullptr)
+	, IndexFormat(DXGI_FORMAT_R32_UINT)
+	, NumberOfIndices((std::uint32_t)indexCount)
+	, Ranges(1u, IndexRange{ 0u, (std::uint32_t)indexCount, 0u })
+{
+	if (vertexCount > MaxShortIndexVertices)
+	{
+		CreateBuffers(device, vertices, vertexCount, indices, indexCount);
+		return;
+	}
+
+	// Everything fits in 16 bits - half the index buffer for free
+	std::vector<std::uint16_t> shortIndices(indexCount);
+	if (indexCount > 0u)
+	{
+		NarrowIndices(indices, &shortIndices[0], indexCount);
+	}
+	IndexFormat = DXGI_FORMAT_R16_UINT;
+	CreateBuffers(device, vertices, vertexCount, shortIndices.data(), indexCount);
+}
+
+TexturedShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const TexturedShader::Vertex* vertices, std::size_t vertexCount, const std::uint16_t* indices, std::size_t indexCount, const IndexRange* ranges, std::size_t rangeCount)
 	: VertexBuffer(nullptr)
+	, VertexStride(sizeof(TexturedShader::Vertex))
+	, DecodeBuffer(nullptr)
 	, IndexBuffer(nullptr)
-	, NumberOfIndices(0u)
+	, IndexFormat(DXGI_FORMAT_R16_UINT)
+	, NumberOfIndices((std::uint32_t)indexCount)
+	, Ranges(ranges, ranges + rangeCount)
+{
+	CreateBuffers(device, vertices, vertexCount, indices, indexCount);
+}
+
+TexturedShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const CompactTexturedVertex* vertices, std::size_t vertexCount, const CompactVertexDecode& decode, const std::uint16_t* indices, std::size_t indexCount, const IndexRange* ranges, std::size_t rangeCount)
+	: VertexBuffer(nullptr)
+	, VertexStride(sizeof(CompactTexturedVertex))
+	, DecodeBuffer(nullptr)
+	, IndexBuffer(nullptr)
+	, IndexFormat(DXGI_FORMAT_R16_UINT)
+	, NumberOfIndices((std::uint32_t)indexCount)
+	, Ranges(ranges, ranges + rangeCount)
+{
+	// The decode constants never change for a mesh, so they get a tiny immutable constant
+	//  buffer of their own instead of a map/unmap every draw
+	D3D11_BUFFER_DESC cbDesc = {};
+	cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cbDesc.ByteWidth = sizeof(CompactVertexDecode);
+	cbDesc.Usage = D3D11_USAGE_IMMUTABLE;
+
+	D3D11_SUBRESOURCE_DATA decodeData = {};
+	decodeData.pSysMem = &decode;
+
+	HRESULT hr = device->CreateBuffer(&cbDesc, &decodeData, &DecodeBuffer);
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to allocate vertex decode buffer for render call! " << hr << std::endl;
+		return;
+	}
+
+	CreateBuffers(device, vertices, vertexCount, indices, indexCount);
+}
+
+void TexturedShader::RenderCall::CreateBuffers(ComPtr<ID3D11Device> device, const void* vertices, std::size_t vertexCount, const void* indices, std::size_t indexCount)
 {
 	HRESULT hr = {};
 	D3D11_BUFFER_DESC vbDesc = {};
 	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	vbDesc.CPUAccessFlags = 0x00;
 	vbDesc.MiscFlags = 0x00;
-	vbDesc.ByteWidth = sizeof(TexturedShader::Vertex) * (UINT)vertices.size();
+	vbDesc.ByteWidth = VertexStride * (UINT)vertexCount;
 	vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
 	vbDesc.StructureByteStride = 0x00;
 
-	// Vector elements must be stored contiguously. As per the C++11 standard,
-	//  they don't necessarily have to be stored as an array, but the identity
-	//  &v[n] = &v[0] + n for all 0 <= n < v.size() must hold true.
-	// http://www.open-std.org/jtc1/sc22/wg21/docs/lwg-defects.html#69
 	D3D11_SUBRESOURCE_DATA vertexData = {};
-	vertexData.pSysMem = &vertices[0];
+	vertexData.pSysMem = vertices;
 
 	hr = device->CreateBuffer(&vbDesc, &vertexData, &VertexBuffer);
 	if (FAILED(hr))
@@ -38,16 +101,19 @@ TexturedShader::RenderCall::RenderCall(ComPtr<ID3D11Device> device, const std::v
 	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	ibDesc.CPUAccessFlags = 0x00;
 	ibDesc.MiscFlags = 0x00;
-	ibDesc.ByteWidth = sizeof(std::uint32_t) * (UINT)indices.size();
+	ibDesc.ByteWidth = (IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(std::uint16_t) : sizeof(std::uint32_t)) * (UINT)indexCount;
 	ibDesc.Usage = D3D11_USAGE_IMMUTABLE;
 	ibDesc.StructureByteStride = 0x00;
 
 	D3D11_SUBRESOURCE_DATA indexData = {};
-	indexData.pSysMem = &indices[0];
+	indexData.pSysMem = indices;
 
 	hr = device->CreateBuffer(&ibDesc, &indexData, &IndexBuffer);
-
-	NumberOfIndices = (std::uint32_t)indices.size();
+	if (FAILED(hr))
+	{
+		std::cerr << "Failed to allocate index buffer for render call! " << hr << std::endl;
+		return;
+	}
 }
 
 TexturedShader::Texture::Texture(ComPtr<ID3D11Device> device, ComPtr<ID3D11DeviceContext> context, const std::vector<unsigned char>& rawData, std::uint32_t width, std::uint32_t height)
@@ -100,14 +166,12 @@ TexturedShader::TexturedShader()
 	: vertexShader_(nullptr)
 	, pixelShader_(nullptr)
 	, inputLayout_(nullptr)
+	, compactVertexShader_(nullptr)
+	, compactInputLayout_(nullptr)
 	, vsc_object_(nullptr)
-	, vsc_frame_(nullptr)
 	, psc_object_(nullptr)
-	, psc_frame_(nullptr)
 	, psc_scene_(nullptr)
-	, DVSC_PerObject({ { Matrix::Identity }, true })
-	, DVSC_PerFrame({ { Matrix::Identity, Matrix::Identity }, true })
-	, DPSC_PerFrame({ { Vec3::Zero }, true })
+	, DVSC_PerObject({ { Affine3x4::Identity }, true })
 	, DPSC_PerObject({ { { Color::Palette::Black, Color::Palette::Black, Color::Palette::Black } }, true })
 	, DPSC_PerScene({ { { Vec3::UnitY, Color::Palette::CreamIGuess, Color::Palette::CreamIGuess, Color::Palette::CreamIGuess } }, true })
 	, boundSRV(nullptr)
@@ -124,9 +188,11 @@ std::future<bool> TexturedShader::Initialize(ComPtr<ID3D11Device> device)
 	return std::async(std::launch::async, [this, device]() -> bool {
 		const char* vsFname = "./cso/TexturedShader.vs.cso";
 		const char* psFname = "./cso/TexturedShader.ps.cso";
+		const char* compactVsFname = "./cso/TexturedShaderCompact.vs.cso";
 
 		std::uint32_t vsDataLength;
 		std::uint32_t psDataLength;
+		std::uint32_t compactVsDataLength;
 
 		HRESULT hr = {};
 
@@ -138,6 +204,16 @@ std::future<bool> TexturedShader::Initialize(ComPtr<ID3D11Device> device)
 		};
 		std::uint32_t numElements = _countof(inputLayout);
 
+		// Compact vertices (CompactTexturedVertex) - the UNORM/SNORM formats do the integer to
+		//  float part of decoding for free, the vertex shader does the rest
+		D3D11_INPUT_ELEMENT_DESC compactInputLayout[] =
+		{
+			{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+		};
+		std::uint32_t numCompactElements = _countof(compactInputLayout);
+
 		// Using asynchronous programming to get the vertex and pixel bytecode from the file.
 		//  Other things can happen while this is happening, so don't join until the data is needed
 		std::future<std::vector<char>> vsData = std::async(std::launch::async, [this, &vsDataLength, vsFname] {
@@ -177,6 +253,24 @@ std::future<bool> TexturedShader::Initialize(ComPtr<ID3D11Device> device)
 			return psBytecode;
 		});
 
+		std::future<std::vector<char>> compactVsData = std::async(std::launch::async, [this, &compactVsDataLength, compactVsFname] {
+			std::vector<char> vsBytecode(0u);
+			std::ifstream vin(compactVsFname, std::ios::binary);
+			if (!vin)
+			{
+				std::cerr << "Failed to open compact vertex shader file for reading." << std::endl;
+				return vsBytecode;
+			}
+
+			vin.seekg(0, std::ios::end);
+			compactVsDataLength = (std::uint32_t)vin.tellg();
+			vin.seekg(0, std::ios::beg);
+			vsBytecode.resize(compactVsDataLength);
+			vin.read(&vsBytecode[0], compactVsDataLength);
+
+			return vsBytecode;
+		});
+
 		// We have to wait for the vertex and pixel buffers to load, so this next part is pretty much free
 		D3D11_BUFFER_DESC bufferDesc = {};
 		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
@@ -193,14 +287,6 @@ std::future<bool> TexturedShader::Initialize(ComPtr<ID3D11Device> device)
 			return false;
 		}
 
-		bufferDesc.ByteWidth = sizeof(TexturedShader::DVSC_PerFrame.VSC_PerFrame);
-		hr = device->CreateBuffer(&bufferDesc, nullptr, &vsc_frame_);
-		if (FAILED(hr))
-		{
-			std::cerr << "Failed to create vertex shader per-frame constant buffer" << std::endl;
-			return false;
-		}
-
 		bufferDesc.ByteWidth = sizeof(TexturedShader::DPSC_PerObject.PSC_PerObject);
 		hr = device->CreateBuffer(&bufferDesc, nullptr, &psc_object_);
 		if (FAILED(hr))
@@ -209,14 +295,6 @@ std::future<bool> TexturedShader::Initialize(ComPtr<ID3D11Device> device)
 			return false;
 		}
 
-		bufferDesc.ByteWidth = sizeof(TexturedShader::DPSC_PerFrame.PSC_PerFrame);
-		hr = device->CreateBuffer(&bufferDesc, nullptr, &psc_frame_);
-		if (FAILED(hr))
-		{
-			std::cerr << "Failed to create pixel shader per-frame constant buffer" << std::endl;
-			return false;
-		}
-
 		bufferDesc.ByteWidth = sizeof(TexturedShader::DPSC_PerScene.PSC_PerScene);
 		hr = device->CreateBuffer(&bufferDesc, nullptr, &psc_scene_);
 		if (FAILED(hr))
@@ -246,6 +324,26 @@ std::future<bool> TexturedShader::Initialize(ComPtr<ID3D11Device> device)
 			return false;
 		}
 
+		std::vector<char> compactVsBytecode = compactVsData.get();
+		if (compactVsBytecode.size() == 0u)
+		{
+			return false;
+		}
+
+		hr = device->CreateVertexShader(&compactVsBytecode[0], compactVsDataLength, nullptr, &compactVertexShader_);
+		if (FAILED(hr))
+		{
+			std::cerr << "Failed to create compact vertex shader: " << hr << std::endl;
+			return false;
+		}
+
+		hr = device->CreateInputLayout(compactInputLayout, numCompactElements, &compactVsBytecode[0], compactVsDataLength, &compactInputLayout_);
+		if (FAILED(hr))
+		{
+			std::cerr << "Failed to create input layout for compact vertex shader: " << hr << std::endl;
+			return false;
+		}
+
 		std::vector<char> psBytecode = psData.get();
 		if (psBytecode.size() == 0u)
 		{
@@ -272,30 +370,15 @@ bool TexturedShader::Render(ComPtr<ID3D11DeviceContext> context, const RenderCal
 {
 	HRESULT hr = {};
 
-	context->IASetInputLayout(inputLayout_.Get());
-	context->VSSetShader(vertexShader_.Get(), nullptr, 0);
+	// Compact vertices need their own vertex shader and input layout, everything else is the same
+	bool compact = call.DecodeBuffer != nullptr;
+	context->IASetInputLayout(compact ? compactInputLayout_.Get() : inputLayout_.Get());
+	context->VSSetShader(compact ? compactVertexShader_.Get() : vertexShader_.Get(), nullptr, 0);
 	context->PSSetShader(pixelShader_.Get(), nullptr, 0);
 
 	// Update constant buffers. This involves mapping a chunk of host-side (CPU) memory
 	//  to the constant buffer, writing to that memory, and then uploading the chunk
 	//  to the graphics card. Mapping is done with "map", uploading with "unmap"
-	if (DVSC_PerFrame.isDirty)
-	{
-		D3D11_MAPPED_SUBRESOURCE vscb;
-
-		hr = context->Map(vsc_frame_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0x00, &vscb);
-		if (FAILED(hr))
-		{
-			std::cerr << "Material only shader render: Failed to map vertex per-frame buffer for CPU writing" << std::endl;
-			return false;
-		}
-
-		memcpy(vscb.pData, &(DVSC_PerFrame.VSC_PerFrame), sizeof(DVSC_PerFrame.VSC_PerFrame));
-		context->Unmap(vsc_frame_.Get(), 0);
-
-		DVSC_PerFrame.isDirty = false;
-	}
-
 	if (DVSC_PerObject.isDirty)
 	{
 		D3D11_MAPPED_SUBRESOURCE vscb;
@@ -313,23 +396,6 @@ bool TexturedShader::Render(ComPtr<ID3D11DeviceContext> context, const RenderCal
 		DVSC_PerObject.isDirty = false;
 	}
 
-	if (DPSC_PerFrame.isDirty)
-	{
-		D3D11_MAPPED_SUBRESOURCE pscb;
-
-		hr = context->Map(psc_frame_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0x00, &pscb);
-		if (FAILED(hr))
-		{
-			std::cerr << "Material only shader render: Failed to map pixel per-frame buffer for CPU writing" << std::endl;
-			return false;
-		}
-
-		memcpy(pscb.pData, &(DPSC_PerFrame.PSC_PerFrame), sizeof(DPSC_PerFrame.PSC_PerFrame));
-		context->Unmap(psc_frame_.Get(), 0);
-
-		DPSC_PerFrame.isDirty = false;
-	}
-
 	if (DPSC_PerObject.isDirty)
 	{
 		D3D11_MAPPED_SUBRESOURCE pscb;
@@ -365,22 +431,25 @@ bool TexturedShader::Render(ComPtr<ID3D11DeviceContext> context, const RenderCal
 	}
 
 	// Set the constant buffers to the pipeline
-	ID3D11Buffer* vsCBuffers[] = { vsc_object_.Get(), vsc_frame_.Get() };
-	context->VSSetConstantBuffers(0, _countof(vsCBuffers), vsCBuffers);
-
-	ID3D11Buffer* psCBuffers[] = { psc_object_.Get(), psc_frame_.Get(), psc_scene_.Get() };
-	context->PSSetConstantBuffers(0, _countof(psCBuffers), psCBuffers);
+	// Slot 1 (per frame) is shared between all shaders - see PerFrameConstantBuffer
+	context->VSSetConstantBuffers(0, 1, vsc_object_.GetAddressOf());
+	context->PSSetConstantBuffers(0, 1, psc_object_.GetAddressOf());
+	context->PSSetConstantBuffers(2, 1, psc_scene_.GetAddressOf());
+	if (compact)
+	{
+		context->VSSetConstantBuffers(2, 1, call.DecodeBuffer.GetAddressOf());
+	}
 
 	// Set the input vertex buffer
-	std::uint32_t stride = sizeof(TexturedShader::Vertex);
+	std::uint32_t stride = call.VertexStride;
 	std::uint32_t offset = 0u;
 	// Set the vertex buffer as input to the graphics pipeline. Only using one.
 	context->IASetVertexBuffers(0, 1, call.VertexBuffer.GetAddressOf(), &stride, &offset);
 
-	// Set the index buffer as input to the graphics pipeline. Specify that we're using 32 bit unsigned integers
-	//  DXGI is weird about formats, R32 means "one component, having 32 bits". The "R" stands for "red"
+	// Set the index buffer as input to the graphics pipeline. Specify whether we're using 16 or 32 bit unsigned integers
+	//  DXGI is weird about formats, R16 means "one component, having 16 bits". The "R" stands for "red"
 	//  A set of three values, 32 bit uints each, would be DXGI_FORMAT_R32G32B32_UINT, for example.
-	context->IASetIndexBuffer(call.IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0u);
+	context->IASetIndexBuffer(call.IndexBuffer.Get(), call.IndexFormat, 0u);
 
 	// We're drawing triangles...
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -389,41 +458,27 @@ bool TexturedShader::Render(ComPtr<ID3D11DeviceContext> context, const RenderCal
 	context->PSSetShaderResources(0, 1, boundSRV.GetAddressOf());
 
 	// Draw! Draw! Draw!
-	context->DrawIndexed(call.NumberOfIndices, 0u, 0u);
+	// Meshes too big for 16 bit indices come in a few ranges, each one offset into the vertex buffer
+	for (const IndexRange& range : call.Ranges)
+	{
+		context->DrawIndexed(range.IndexCount, range.StartIndex, (INT)range.BaseVertex);
+	}
 
 	return true;
 }
 
-void TexturedShader::SetModelTransform(const Matrix& modelTransform)
+void TexturedShader::SetModelTransform(const Affine3x4& modelTransform)
 {
 	DVSC_PerObject.VSC_PerObject.Model = modelTransform;
 	DVSC_PerObject.isDirty = true;
 }
 
-void TexturedShader::SetViewTransform(const Matrix& viewTransform)
-{
-	DVSC_PerFrame.VSC_PerFrame.View = viewTransform.Transpose();
-	DVSC_PerFrame.isDirty = true;
-}
-
-void TexturedShader::SetProjectionTransform(const Matrix& projTransform)
-{
-	DVSC_PerFrame.VSC_PerFrame.Proj = projTransform.Transpose();
-	DVSC_PerFrame.isDirty = true;
-}
-
 void TexturedShader::SetObjectMaterial(const Material& objectMaterial)
 {
 	DPSC_PerObject.PSC_PerObject.ObjectMaterial = objectMaterial;
 	DPSC_PerObject.isDirty = true;
 }
 
-void TexturedShader::SetCameraPosition(const Vec3& cameraPosition)
-{
-	DPSC_PerFrame.PSC_PerFrame.CameraPosition = cameraPosition;
-	DPSC_PerFrame.isDirty = true;
-}
-
 void TexturedShader::SetSunLight(const DirectionalLight& light)
 {
 	DPSC_PerScene.PSC_PerScene.SunLight = light;
@@ -5,6 +5,9 @@
 #include <future>
 #include <vector>
 #include <MathExtras.h>
+#include <MeshConvert.h>
+#include <CompactVertex.h>
+#include <cstddef>
 
 using Microsoft::WRL::ComPtr;
 
@@ -37,6 +40,15 @@ public:
 		Vertex(const Vec3& pos, const Vec3& norm, float u, float v)
 			: Position(pos), __one(1.f), Normal(norm), __zero(0.f), U(u), V(v)
 		{}
+
+		// Leaves everything unset - model vertices get written as raw bytes by ConvertAssimpVertices
+		//  (going by Layout()) when a model is cooked, and read straight out of the cooked file
+		Vertex() {}
+
+		static MeshVertexLayout Layout()
+		{
+			return MeshVertexLayout(sizeof(Vertex), offsetof(Vertex, Position), offsetof(Vertex, Normal), offsetof(Vertex, U));
+		}
 	};
 
 	// Material color will be multiplied with texture color for ambient and diffuse color, specular
@@ -69,11 +81,8 @@ public:
 	// Calls used by this shader to set shader variables (would be the same in OGL/VK)
 	//  These are not included in the render call itself, because they could change less frequently
 	//  than render calls are made. The render call itself only stores geometry information.
-	void SetModelTransform(const Matrix& modelTransform);
-	void SetViewTransform(const Matrix& viewTransform);
-	void SetProjectionTransform(const Matrix& projTransform);
+	void SetModelTransform(const Affine3x4& modelTransform);
 	void SetObjectMaterial(const Material& objectMaterial);
-	void SetCameraPosition(const Vec3& cameraPosition);
 	void SetSunLight(const DirectionalLight& light);
 	void SetTexture(const Texture& texture); // Definition of texture below
 	
@@ -86,11 +95,26 @@ public:
 	{
 	public:
 		RenderCall(ComPtr<ID3D11Device> device, const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices);
+		// Same, from plain arrays - for vertex data that isn't in a vector, like a memory mapped
+		//  CookedModel (see CookedModel.h)
+		RenderCall(ComPtr<ID3D11Device> device, const Vertex* vertices, std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount);
+		// 16 bit indices, drawn one range at a time - what a CookedModel mesh comes with
+		RenderCall(ComPtr<ID3D11Device> device, const Vertex* vertices, std::size_t vertexCount, const std::uint16_t* indices, std::size_t indexCount, const IndexRange* ranges, std::size_t rangeCount);
+		// Compact vertices (see CompactVertex.h) - 16 bytes each instead of 40, drawn with the
+		//  TexturedShaderCompact vertex shader, which undoes the encoding with decode
+		RenderCall(ComPtr<ID3D11Device> device, const CompactTexturedVertex* vertices, std::size_t vertexCount, const CompactVertexDecode& decode, const std::uint16_t* indices, std::size_t indexCount, const IndexRange* ranges, std::size_t rangeCount);
 
 	public:
 		ComPtr<ID3D11Buffer> VertexBuffer;
+		std::uint32_t VertexStride;
+		ComPtr<ID3D11Buffer> DecodeBuffer; // CompactVertexDecode for compact vertices, otherwise null
 		ComPtr<ID3D11Buffer> IndexBuffer;
+		DXGI_FORMAT IndexFormat; // DXGI_FORMAT_R16_UINT whenever the vertices fit, otherwise R32
 		std::uint32_t NumberOfIndices;
+		std::vector<IndexRange> Ranges; // One DrawIndexed each
+
+	protected:
+		void CreateBuffers(ComPtr<ID3D11Device> device, const void* vertices, std::size_t vertexCount, const void* indices, std::size_t indexCount);
 	};
 
 	// Wrapper around D3D11 texture
@@ -121,11 +145,13 @@ protected:
 	ComPtr<ID3D11PixelShader> pixelShader_;
 	ComPtr<ID3D11InputLayout> inputLayout_;
 
-	// D3D11 constant buffers
+	// Same pixel shader, different vertex input - for RenderCalls with compact vertices
+	ComPtr<ID3D11VertexShader> compactVertexShader_;
+	ComPtr<ID3D11InputLayout> compactInputLayout_;
+
+	// D3D11 constant buffers. Per frame data lives in PerFrameConstantBuffer, shared with other shaders.
 	ComPtr<ID3D11Buffer> vsc_object_;
-	ComPtr<ID3D11Buffer> vsc_frame_;
 	ComPtr<ID3D11Buffer> psc_object_;
-	ComPtr<ID3D11Buffer> psc_frame_;
 	ComPtr<ID3D11Buffer> psc_scene_;
 
 protected:
@@ -135,21 +161,11 @@ protected:
 	{
 		struct VSC_PerObject_Type
 		{
-			Matrix Model;
+			Affine3x4 Model; // float4x3 in the shader - the 0 0 0 1 column isn't uploaded
 		} VSC_PerObject;
 		bool isDirty;
 	} DVSC_PerObject;
 
-	struct // Constant buffer for the vertex shader, per frame
-	{
-		struct VSC_PerFrame_Type
-		{
-			Matrix View;
-			Matrix Proj;
-		} VSC_PerFrame;
-		bool isDirty;
-	} DVSC_PerFrame;
-
 	struct // Constant buffer for the pixel shader, per object
 	{
 		struct PSC_PerObject_Type
@@ -159,16 +175,6 @@ protected:
 		bool isDirty;
 	} DPSC_PerObject;
 
-	struct // Constant buffer for the pixel shader, per frame
-	{
-		struct PSC_PerFrame_Type
-		{
-			Vec3 CameraPosition;
-			float __extra;
-		} PSC_PerFrame;
-		bool isDirty;
-	} DPSC_PerFrame;
-
 	struct // Constant buffer for the pixel shader, per scene
 	{
 		struct PSC_PerScene_Type
@@ -8,10 +8,7 @@ cbuffer PerObject : register(b0)
 	Material ObjectMaterial;
 }
 
-cbuffer PerFrame : register(b1)
-{
-	float4 CameraPosition;
-}
+#include "FrameDefs.hlsli"
 
 cbuffer PerScene : register(b2)
 {
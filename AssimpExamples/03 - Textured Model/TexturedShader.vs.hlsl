@@ -27,29 +27,25 @@ struct PixelIn
 //
 cbuffer PerObject : register(b0)
 {
-	matrix mModel;
+	// Model transforms are affine, so the last column is always 0 0 0 1 - no point in
+	//  uploading it. A column major float4x3 is three registers, one per output component.
+	float4x3 mModel;
 };
 
-cbuffer PerFrame : register(b1)
-{
-	matrix mView;
-	matrix mProj;
-};
+#include "FrameDefs.hlsli"
 
 PixelIn main(VertexIn vin)
 {
 	PixelIn vout;
 
-	// Screen space coordinate: model coord -> world coord -> view coord -> screen cord
-	vout.Position = mul(vin.Position, mModel);
-	vout.Position = mul(vout.Position, mView);
-	vout.Position = mul(vout.Position, mProj);
-
 	// World space coordinate: model coord -> world coord
-	vout.WorldPosition = mul(vin.Position, mModel);
+	vout.WorldPosition = float4(mul(vin.Position, mModel), 1.f);
+
+	// Screen space coordinate: world coord -> view coord -> screen coord, in one step
+	vout.Position = mul(vout.WorldPosition, mViewProj);
 
 	// World space normal: model normal -> world normal
-	vout.Normal = mul(vin.Normal, mModel);
+	vout.Normal = float4(mul(vin.Normal, mModel), 0.f);
 
 	vout.UV = vin.UV;
 
@@ -0,0 +1,76 @@
+// Same as TexturedShader.vs.hlsl, but for compact vertices (see CompactVertex.h in common/)
+//  The input layout has already turned the 16 bit integers into floats - all that's left
+//  here is putting them back into the mesh's bounding box, and unfolding the normal
+
+//
+// STRUCT DEFS
+//  Here I define the input and output formats of this shader
+//
+struct VertexIn
+{
+	float4 Position : POSITION; // 0...1 across the mesh's bounding box, w is already 1
+	float2 Normal : NORMAL;     // Octahedral
+	float2 UV : TEXCOORD0;      // 0...1 across the mesh's UV range
+};
+
+struct PixelIn
+{
+	float4 Position : SV_POSITION;
+	float4 WorldPosition : POSITION;
+	float4 Normal : NORMAL;
+	float2 UV : TEXCOORD0;
+};
+
+//
+// CBUFFERS
+//  Here I set up the buffers that will hold the (vertex) shader globals
+//  Transformation matrices, for example
+//
+cbuffer PerObject : register(b0)
+{
+	// Model transforms are affine, so the last column is always 0 0 0 1 - no point in
+	//  uploading it. A column major float4x3 is three registers, one per output component.
+	float4x3 mModel;
+};
+
+#include "FrameDefs.hlsli"
+
+// One per mesh - CompactVertexDecode
+cbuffer CompactDecode : register(b2)
+{
+	float4 PositionScale;
+	float4 PositionOffset;
+	float4 UVScaleOffset;
+};
+
+float3 DecodeOctahedral(float2 e)
+{
+	float3 n = float3(e.x, e.y, 1.f - abs(e.x) - abs(e.y));
+	if (n.z < 0.f)
+	{
+		// Bottom half of the octahedron was folded over the top - fold it back
+		n.xy = (1.f - abs(n.yx)) * (n.xy >= 0.f ? 1.f : -1.f);
+	}
+	return normalize(n);
+}
+
+PixelIn main(VertexIn vin)
+{
+	PixelIn vout;
+
+	// Model space position, back out of the bounding box
+	float4 position = vin.Position * PositionScale + PositionOffset;
+
+	// World space coordinate: model coord -> world coord
+	vout.WorldPosition = float4(mul(position, mModel), 1.f);
+
+	// Screen space coordinate: world coord -> view coord -> screen coord, in one step
+	vout.Position = mul(vout.WorldPosition, mViewProj);
+
+	// World space normal: model normal -> world normal
+	vout.Normal = float4(mul(float4(DecodeOctahedral(vin.Normal), 0.f), mModel), 0.f);
+
+	vout.UV = vin.UV * UVScaleOffset.xy + UVScaleOffset.zw;
+
+	return vout;
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "UVTexturedDemo.h"
 #include <Color.h>
 
+#include <cwchar>
 #include <iostream>
 
 namespace sess
@@ -11,12 +12,15 @@ UVTexturedDemo::UVTexturedDemo(HINSTANCE appHandle)
 	, materialOnlyShader_()
 	, texturedShader_()
 	, camera_(Vec3(0.f, 2.2f, 0.f), Vec3(0.f, 2.2f, 1.f), Vec3::UnitY)
+	, frameConstants_()
 	, projMatrix_(PerspectiveLH(Radians(80.f), (windowSize_.right - windowSize_.left) / (float)(windowSize_.bottom - windowSize_.top), 0.1f, 100.f))
 	, debugIcosphere_(nullptr)
 	, roadModel_(nullptr)
 	, manModel_(nullptr)
 	, inputState_({ /* Initialize to all false */ })
-{}
+{
+	camera_.SetProjection(projMatrix_);
+}
 
 UVTexturedDemo::~UVTexturedDemo()
 {}
@@ -29,6 +33,11 @@ bool UVTexturedDemo::InitializeApp()
 	std::future<bool> shaderLoaded = materialOnlyShader_.Initialize(device_);
 	std::future<bool> textureShaderLoaded = texturedShader_.Initialize(device_);
 
+	if (!frameConstants_.Initialize(device_))
+	{
+		return false;
+	}
+
 	debugIcosphere_ = std::make_shared<DebugMaterialIcosphere>
 		(
 			device_,
@@ -38,27 +47,88 @@ bool UVTexturedDemo::InitializeApp()
 			1.1f
 			);
 
-	Transform roadTransform(Vec3::Zero, Quaternion(Vec3::UnitY, Radians(-90.f)) * Quaternion(Vec3::UnitX, Radians(-90.f)), Vec3::Ones);
-	roadModel_ = AssimpRoadModel::LoadFromFile("./assets/road.fbx", device_, roadTransform);
-	if (!roadModel_)
+#if defined(_DEBUG)
+	// Break imports down step by step, to see which post-processing steps are worth their
+	//  time. Only does anything when a model actually gets imported (see ImportProfile.h).
+	SetImportStepTiming(true);
+#endif
+
+	// Everything comes out of one packed archive when there is one (see AssetArchive.h). It
+	//  gets packed at the end of the first run, after the models have been cooked, so the
+	//  cooked files go in it too. Delete it to pick up changes to anything in ./assets/.
+	const char* archivePath = "./assets.pack";
+	AssetArchive archive;
+	const AssetArchive* assets = nullptr;
+	if (archive.Open(archivePath))
 	{
-		std::cerr << "Failed to load road model, failing initialization" << std::endl;
-		return 0;
+		archive.Prefetch();
+		assets = &archive;
 	}
 
+	// Every model and texture loads at the same time (see AssetLoader.h). The man needs his
+	//  texture, but his model file can load while the image decodes - only putting the two
+	//  together waits on both. Making the texture generates its mip maps with the context,
+	//  which is the one part that has to happen here on the main thread.
+	AssetLoader loader;
+
+	Transform roadTransform(Vec3::Zero, Quaternion(Vec3::UnitY, Radians(-90.f)) * Quaternion(Vec3::UnitX, Radians(-90.f)), Vec3::Ones);
+	auto road = loader.Add("road.fbx", [this, roadTransform, &loader, assets]()
+	{
+		return AssimpRoadModel::LoadFromFile("./assets/road.fbx", device_, roadTransform, ImportProfile::Default, &loader, assets);
+	});
+
 	Transform manTransform
 	(
 		Vec3(0.f, 1.21f, 3.f),
 		Quaternion(Vec3::UnitY, Radians(180.f)) * Quaternion(Vec3::UnitX, Radians(-90.f)),
 		Vec3(0.55, 0.55, 0.55)
 	);
-	manModel_ = AssimpManModel::LoadFromFile("./assets/simpleMan2.6.fbx", "./assets/man-skin.png", device_, context_, manTransform);
+	auto manMeshes = loader.Add("simpleMan2.6.fbx", [this, manTransform, &loader, assets]()
+	{
+		return AssimpManModel::LoadMeshes("./assets/simpleMan2.6.fbx", device_, manTransform, ImportProfile::Default, &loader, assets);
+	});
+	auto manImage = loader.Add("man-skin.png", [assets]()
+	{
+		return AssimpManModel::LoadTextureImage("./assets/man-skin.png", assets);
+	});
+	auto manTexture = loader.Add("man-skin.png texture", [this, manImage]()
+	{
+		return AssimpManModel::CreateTexture(device_, context_, manImage.Get());
+	}, { manImage.Job }, AssetLoader::MainThread);
+	auto man = loader.Add("man", [manMeshes, manTexture]()
+	{
+		return AssimpManModel::Create(manMeshes.Get(), manTexture.Get());
+	}, { manMeshes.Job, manTexture.Job });
+
+	loader.WaitAll();
+	loader.Report(std::cout);
+
+	roadModel_ = road.Get();
+	if (!roadModel_)
+	{
+		std::cerr << "Failed to load road model, failing initialization" << std::endl;
+		return 0;
+	}
+
+	manModel_ = man.Get();
 	if (!manModel_)
 	{
 		std::cerr << "Failed to load man model, failing initialization" << std::endl;
 		return 0;
 	}
 
+	if (!assets)
+	{
+		PackAssetArchive(archivePath,
+		{
+			"./assets/road.fbx",
+			"./assets/road.fbx.cooked",
+			"./assets/simpleMan2.6.fbx",
+			"./assets/simpleMan2.6.fbx.cooked",
+			"./assets/man-skin.png",
+		});
+	}
+
 	if (shaderLoaded.get() == false)
 	{
 		std::cerr << "Failed to load material only shader in UV demo app" << std::endl;
@@ -116,6 +186,7 @@ bool UVTexturedDemo::Update(float dt)
 
 	debugIcosphere_->Update(dt);
 	roadModel_->Update(dt);
+	manModel_->Update(dt);
 
 	return true;
 }
@@ -129,17 +200,27 @@ bool UVTexturedDemo::Render()
 	context_->ClearDepthStencilView(depthStencilView_.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0x00);
 	context_->RSSetViewports(1, &viewport_);
 
-	materialOnlyShader_.SetCameraPosition(camera_.GetPosition());
-	materialOnlyShader_.SetViewTransform(camera_.GetViewMatrix());
-	materialOnlyShader_.SetProjectionTransform(projMatrix_);
+	// Camera matrices are worked out (at most) once, uploaded (at most) once, and shared by
+	//  every shader from here on
+	frameConstants_.Update(context_, camera_);
+
+	// Everything is culled against the same frustum the shaders are about to use
+	Frustum frustum(camera_.GetFrameBlock().ViewProj);
+	cullStats_.Reset();
 
-	texturedShader_.SetCameraPosition(camera_.GetPosition());
-	texturedShader_.SetViewTransform(camera_.GetViewMatrix());
-	texturedShader_.SetProjectionTransform(projMatrix_);
+	debugIcosphere_->Render(context_, &materialOnlyShader_, frustum, &cullStats_);
+	roadModel_->Render(context_, &materialOnlyShader_, frustum, &cullStats_);
+	manModel_->Render(context_, &texturedShader_, frustum, &cullStats_);
 
-	debugIcosphere_->Render(context_, &materialOnlyShader_);
-	roadModel_->Render(context_, &materialOnlyShader_);
-	manModel_->Render(context_, &texturedShader_);
+	// The title bar says how much culling skipped - only touched when the numbers change,
+	//  since setting the text means a round trip through the window's message handler
+	if (cullStats_.Tested != shownCullStats_.Tested || cullStats_.Rejected != shownCullStats_.Rejected)
+	{
+		wchar_t title[128];
+		swprintf_s(title, L"%s - %u of %u meshes culled", appName_, cullStats_.Rejected, cullStats_.Tested);
+		SetWindowText(hWnd_, title);
+		shownCullStats_ = cullStats_;
+	}
 
 	swapChain_->Present(1, 0x00);
 
@@ -2,10 +2,12 @@
 
 #include <DemoApp.h>
 #include <FreeCamera.h>
+#include <Frustum.h>
 
 #include "AssimpManModel.h"
 #include "AssimpRoadModel.h"
 #include "DebugIcosphere.h"
+#include "PerFrameConstantBuffer.h"
 
 namespace sess
 {
@@ -28,6 +30,7 @@ private:
 	MaterialOnlyShader materialOnlyShader_;
 	TexturedShader texturedShader_;
 	FreeCamera camera_;
+	PerFrameConstantBuffer frameConstants_;
 
 	std::shared_ptr<DebugMaterialIcosphere> debugIcosphere_;
 	std::shared_ptr<AssimpRoadModel> roadModel_;
@@ -35,6 +38,11 @@ private:
 
 	Matrix projMatrix_;
 
+	// How many meshes were skipped last frame because they were off screen, and what the
+	//  title bar is showing right now
+	CullStats cullStats_;
+	CullStats shownCullStats_;
+
 	struct
 	{
 	public:
@@ -0,0 +1,176 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace bench
+{
+
+namespace
+{
+
+std::vector<Benchmark>& Registry()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+double TimeRun(const Runner& run, std::size_t iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	run(iterations);
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+// Keeps doubling the iteration count until one run takes a decent fraction of the time
+//  budget, then scales it up to fill the whole thing
+std::size_t CalibrateIterations(const Runner& run, double minSeconds)
+{
+	std::size_t iterations = 1u;
+	for (;;)
+	{
+		double seconds = TimeRun(run, iterations);
+		if (seconds >= minSeconds * 0.1 || iterations >= (std::size_t(1u) << 40))
+		{
+			double scale = seconds > 0. ? minSeconds / seconds : 10.;
+			return std::max<std::size_t>(1u, (std::size_t)(iterations * std::max(scale, 1.)));
+		}
+		iterations *= 2u;
+	}
+}
+
+void PrintRate(double itemsPerSecond)
+{
+	if (itemsPerSecond >= 1e9)
+	{
+		printf("%8.2f G/s", itemsPerSecond * 1e-9);
+	}
+	else if (itemsPerSecond >= 1e6)
+	{
+		printf("%8.2f M/s", itemsPerSecond * 1e-6);
+	}
+	else
+	{
+		printf("%8.2f K/s", itemsPerSecond * 1e-3);
+	}
+}
+
+};
+
+void Register(const char* variant, const char* name, std::size_t itemsPerOp, RunnerFactory factory)
+{
+	Benchmark b;
+	b.Name = name;
+	b.Variant = variant;
+	b.ItemsPerOp = itemsPerOp;
+	b.Factory = factory;
+	Registry().push_back(b);
+}
+
+const std::vector<Benchmark>& GetBenchmarks()
+{
+	return Registry();
+}
+
+std::vector<Result> RunAll(const Options& options)
+{
+	std::vector<Result> results;
+	for (const Benchmark& b : Registry())
+	{
+		if (!options.Filter.empty() && b.Name.find(options.Filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		Runner run = b.Factory();
+		std::size_t iterations = CalibrateIterations(run, options.MinSeconds);
+
+		double best = 0.;
+		for (std::size_t r = 0u; r < options.Repetitions; r++)
+		{
+			double seconds = TimeRun(run, iterations);
+			best = (r == 0u) ? seconds : std::min(best, seconds);
+		}
+
+		Result result;
+		result.Name = b.Name;
+		result.Variant = b.Variant;
+		result.ItemsPerOp = b.ItemsPerOp;
+		result.NsPerOp = best * 1e9 / iterations;
+		result.ItemsPerSecond = iterations * b.ItemsPerOp / best;
+		results.push_back(result);
+
+		// Progress goes to stderr, so the table (or CSV) on stdout stays clean
+		fprintf(stderr, "  %-40s %-8s %12.2f ns/op\n", result.Name.c_str(), result.Variant.c_str(), result.NsPerOp);
+	}
+	return results;
+}
+
+void PrintTable(const std::vector<Result>& results, const std::vector<std::string>& variants)
+{
+	// Rows in the order they were first registered
+	std::vector<std::string> names;
+	for (const Result& r : results)
+	{
+		if (std::find(names.begin(), names.end(), r.Name) == names.end())
+		{
+			names.push_back(r.Name);
+		}
+	}
+
+	printf("%-40s %6s", "benchmark", "items");
+	for (const std::string& v : variants)
+	{
+		printf(" | %10s ns/op %10s", v.c_str(), "items/s");
+	}
+	printf("\n");
+
+	for (const std::string& name : names)
+	{
+		std::vector<const Result*> row(variants.size(), nullptr);
+		std::size_t items = 0u;
+		for (const Result& r : results)
+		{
+			if (r.Name != name)
+			{
+				continue;
+			}
+			items = r.ItemsPerOp;
+			for (std::size_t v = 0u; v < variants.size(); v++)
+			{
+				if (r.Variant == variants[v])
+				{
+					row[v] = &r;
+				}
+			}
+		}
+
+		printf("%-40s %6zu", name.c_str(), items);
+		for (std::size_t v = 0u; v < variants.size(); v++)
+		{
+			if (row[v])
+			{
+				printf(" | %16.2f ", row[v]->NsPerOp);
+				PrintRate(row[v]->ItemsPerSecond);
+			}
+			else
+			{
+				printf(" | %16s %10s", "-", "-");
+			}
+		}
+		printf("\n");
+	}
+}
+
+void PrintCsv(const std::vector<Result>& results)
+{
+	printf("benchmark,variant,items_per_op,ns_per_op,items_per_second\n");
+	for (const Result& r : results)
+	{
+		printf("%s,%s,%zu,%.3f,%.1f\n", r.Name.c_str(), r.Variant.c_str(), r.ItemsPerOp, r.NsPerOp, r.ItemsPerSecond);
+	}
+}
+
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+// Tiny benchmark harness for the math code in common/.
+// Each benchmark is registered once per build variant (scalar, SSE, AVX - see CMakeLists.txt),
+//  and the results come out side by side so a SIMD change always shows up next to the
+//  plain C++ numbers it's supposed to beat.
+// Deliberately not a library like Google Benchmark - the whole thing is a couple hundred
+//  lines and doesn't need anything besides the standard library.
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+// Runs the operation being measured `iterations` times
+typedef std::function<void(std::size_t iterations)> Runner;
+
+// Sets up the input data (not timed) and returns the runner that works on it
+typedef std::function<Runner()> RunnerFactory;
+
+struct Benchmark
+{
+public:
+	std::string Name;
+	std::string Variant;
+	std::size_t ItemsPerOp; // 1 for single-value benchmarks, the batch size for batched ones
+	RunnerFactory Factory;
+};
+
+struct Result
+{
+public:
+	std::string Name;
+	std::string Variant;
+	std::size_t ItemsPerOp;
+	double NsPerOp; // Fastest of the repetitions
+	double ItemsPerSecond;
+};
+
+struct Options
+{
+public:
+	double MinSeconds; // How long each repetition runs for (at least)
+	std::size_t Repetitions;
+	std::string Filter; // Only benchmarks with this in their name
+	bool Csv;
+
+public:
+	Options() : MinSeconds(0.1), Repetitions(5u), Filter(), Csv(false) {}
+};
+
+void Register(const char* variant, const char* name, std::size_t itemsPerOp, RunnerFactory factory);
+const std::vector<Benchmark>& GetBenchmarks();
+
+std::vector<Result> RunAll(const Options& options);
+
+// One row per benchmark, one column pair (ns/op and throughput) per variant
+void PrintTable(const std::vector<Result>& results, const std::vector<std::string>& variants);
+void PrintCsv(const std::vector<Result>& results);
+
+// Keeps the compiler from throwing away a result it can see is never used
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	const volatile char* sink = reinterpret_cast<const volatile char*>(&value);
+	(void)*sink;
+#endif
+}
+
+// ...and from assuming memory it already knows about hasn't changed between iterations
+inline void ClobberMemory()
+{
+#if defined(__GNUC__)
+	asm volatile("" : : : "memory");
+#endif
+}
+
+};
@@ -0,0 +1,271 @@
+// Measured error of the FastMath policy (common/MathPolicy.h), against double precision, and
+//  of the other approximations in common/ against the exact versions they stand in for.
+// Compiled once per variant like MathBenchmarks.cc - FastMath::RSqrt and the batch kernels
+//  have different implementations with and without SSE, so each one gets checked.
+// The worst cases here are the numbers quoted at the top of MathPolicy.h and Quantize.h, and
+//  next to Quaternion::SlerpApprox.
+
+#include <Transform.h>
+#include <MathPolicy.h>
+#include <QuaternionBatch.h>
+#include <Quantize.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace sess
+{
+
+namespace
+{
+
+struct ErrorStats
+{
+public:
+	double Max;
+	double Sum;
+	std::size_t Count;
+
+public:
+	ErrorStats() : Max(0.), Sum(0.), Count(0u) {}
+	void Add(double e)
+	{
+		Max = std::max(Max, e);
+		Sum += e;
+		Count++;
+	}
+};
+
+void PrintStats(const char* name, const char* kind, const ErrorStats& e)
+{
+	printf("  %-48s %-9s max %10.3g  mean %10.3g\n", name, kind, e.Max, e.Count ? e.Sum / e.Count : 0.);
+}
+
+// Angle of the rotation that takes a to b, in radians. Both are normalized first - being a
+//  little off of unit length doesn't change the rotation (everything that uses a quaternion
+//  either normalizes it or doesn't care).
+double RotationAngle(const double a[4], const double b[4])
+{
+	double lenA = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2] + a[3] * a[3]);
+	double lenB = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+	double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+	double distSq = 0.;
+	for (int k = 0; k < 4; k++)
+	{
+		double diff = a[k] / lenA - (dot < 0. ? -1. : 1.) * b[k] / lenB;
+		distSq += diff * diff;
+	}
+	// 4 asin(|a - b| / 2) rather than 2 acos(a.b), which can't resolve small angles
+	return 4. * asin(std::min(1., 0.5 * sqrt(distSq)));
+}
+
+double RotationAngle(const Quaternion& a, const Quaternion& b)
+{
+	double da[4] = { a.x, a.y, a.z, a.w };
+	double db[4] = { b.x, b.y, b.z, b.w };
+	return RotationAngle(da, db);
+}
+
+double MaxComponentError(const Quaternion& a, const Quaternion& b)
+{
+	return std::max(std::max(fabs((double)a.x - b.x), fabs((double)a.y - b.y)), std::max(fabs((double)a.z - b.z), fabs((double)a.w - b.w)));
+}
+
+// The rotation rows get a mean too. QuantizationError only keeps the worst position and scale.
+void PrintQuantizationError(const char* name, const QuantizationError& e, bool position, bool scale)
+{
+	char label[96];
+	snprintf(label, sizeof(label), "%s, radians", name);
+	printf("  %-48s %-9s max %10.3g  mean %10.3g\n", label, "absolute", e.MaxRotationError, e.MeanRotationError);
+	if (position)
+	{
+		snprintf(label, sizeof(label), "%s, position component", name);
+		printf("  %-48s %-9s max %10.3g\n", label, "absolute", e.MaxPositionError);
+	}
+	if (scale)
+	{
+		snprintf(label, sizeof(label), "%s, scale component", name);
+		printf("  %-48s %-9s max %10.3g\n", label, "absolute", e.MaxScaleError);
+	}
+}
+
+void CheckSinCos(const char* name, double range)
+{
+	const std::size_t Samples = 2000000u;
+	ErrorStats sinError, cosError;
+	for (std::size_t i = 0u; i <= Samples; i++)
+	{
+		float angle = (float)(-range + 2. * range * i / Samples);
+		float s, c;
+		FastMath::SinCos(angle, s, c);
+		sinError.Add(fabs((double)s - sin((double)angle)));
+		cosError.Add(fabs((double)c - cos((double)angle)));
+	}
+
+	char label[96];
+	snprintf(label, sizeof(label), "FastMath::Sin, %s", name);
+	PrintStats(label, "absolute", sinError);
+	snprintf(label, sizeof(label), "FastMath::Cos, %s", name);
+	PrintStats(label, "absolute", cosError);
+}
+
+void CheckRSqrt()
+{
+	// Every power of two from 2^-100 to 2^100, with a spread of mantissas
+	std::mt19937 rng(42u);
+	std::uniform_real_distribution<float> mantissa(1.f, 2.f);
+	ErrorStats e;
+	for (int exponent = -100; exponent <= 100; exponent++)
+	{
+		for (int i = 0; i < 10000; i++)
+		{
+			float x = ldexpf(mantissa(rng), exponent);
+			double exact = 1. / sqrt((double)x);
+			e.Add(fabs((double)FastMath::RSqrt(x) - exact) / exact);
+		}
+	}
+	PrintStats("FastMath::RSqrt, 2^-100 ... 2^100", "relative", e);
+}
+
+void CheckRotations()
+{
+	std::mt19937 rng(7u);
+	std::uniform_real_distribution<float> d(-1.f, 1.f);
+	std::uniform_real_distribution<float> angles(-2.f * PI, 2.f * PI);
+
+	ErrorStats rotationError, normalError;
+	for (int i = 0; i < 1000000; i++)
+	{
+		Vec3 axis(d(rng), d(rng), d(rng));
+		if (axis.Magnitude() < 0.01f)
+		{
+			continue;
+		}
+		axis = axis.Normal();
+		float angle = angles(rng);
+
+		// Angle of the rotation between the fast result and the exact one, in double
+		Quaternion fast = Quaternion::FromAxisAngle<FastMath>(axis, angle);
+		double half = angle * 0.5;
+		double a[4] = { sin(half) * axis.x, sin(half) * axis.y, sin(half) * axis.z, cos(half) };
+		double b[4] = { fast.x, fast.y, fast.z, fast.w };
+		rotationError.Add(RotationAngle(a, b));
+
+		Vec3 v(d(rng) * 100.f, d(rng) * 100.f, d(rng) * 100.f);
+		if (v.Magnitude() > 0.01f)
+		{
+			Vec3 n = v.Normal<FastMath>();
+			normalError.Add(fabs(sqrt((double)n.x * n.x + (double)n.y * n.y + (double)n.z * n.z) - 1.));
+		}
+	}
+	PrintStats("Quaternion::FromAxisAngle<FastMath>, radians", "absolute", rotationError);
+	PrintStats("Vec3::Normal<FastMath>, length - 1", "absolute", normalError);
+}
+
+Quaternion RandomRotation(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> d(-1.f, 1.f);
+	for (;;)
+	{
+		Vec3 axis(d(rng), d(rng), d(rng));
+		if (axis.Magnitude() >= 0.01f)
+		{
+			return Quaternion(axis.Normal(), d(rng) * PI);
+		}
+	}
+}
+
+// SlerpApprox, and the vectorized SlerpMany that uses it, against Quaternion::Slerp. Pairs
+//  are random rotations, so every angle between them (and so every |dot|) shows up.
+void CheckSlerpApprox()
+{
+	const std::size_t Pairs = 4096u;
+	const int Steps = 64;
+	std::mt19937 rng(11u);
+	std::uniform_real_distribution<float> jitter(0.f, 1.f / Steps);
+
+	QuaternionSoA a, b, exact, approx;
+	for (std::size_t i = 0u; i < Pairs; i++)
+	{
+		a.PushBack(RandomRotation(rng));
+		b.PushBack(RandomRotation(rng));
+	}
+
+	ErrorStats componentError, angleError, batchComponentError, batchAngleError;
+	for (int step = 0; step <= Steps; step++)
+	{
+		// Both ends exactly, and everything in between with a bit of jitter
+		float t = step == Steps ? 1.f : step == 0 ? 0.f : (float)step / Steps + jitter(rng) - 0.5f / Steps;
+		SlerpMany(a, b, t, exact, SlerpPrecision::Exact);
+		SlerpMany(a, b, t, approx, SlerpPrecision::Approximate);
+		for (std::size_t i = 0u; i < Pairs; i++)
+		{
+			Quaternion reference = Quaternion::Slerp(a.Get(i), b.Get(i), t);
+			Quaternion single = Quaternion::SlerpApprox(a.Get(i), b.Get(i), t);
+			componentError.Add(MaxComponentError(single, reference));
+			angleError.Add(RotationAngle(single, reference));
+
+			Quaternion batch = approx.Get(i);
+			batchComponentError.Add(MaxComponentError(batch, exact.Get(i)));
+			batchAngleError.Add(RotationAngle(batch, exact.Get(i)));
+		}
+	}
+	PrintStats("Quaternion::SlerpApprox, component", "absolute", componentError);
+	PrintStats("Quaternion::SlerpApprox, radians", "absolute", angleError);
+	PrintStats("SlerpMany(Approximate), component", "absolute", batchComponentError);
+	PrintStats("SlerpMany(Approximate), radians", "absolute", batchAngleError);
+}
+
+// Round trip through each packed format, measured with Quantize.h's own MeasureError. The
+//  batch packers are what the loaders use, so those are what get checked. Positions stay
+//  within +/- 10 units and scales within 0.5 ... 2 - local space sizes, which is what the
+//  half floats are meant for.
+void CheckQuantization()
+{
+	const std::size_t Count = 200000u;
+	std::mt19937 rng(13u);
+	std::uniform_real_distribution<float> position(-10.f, 10.f);
+	std::uniform_real_distribution<float> scale(0.5f, 2.f);
+
+	std::vector<Quaternion> rotations(Count);
+	std::vector<Transform> transforms(Count), rigidTransforms(Count);
+	for (std::size_t i = 0u; i < Count; i++)
+	{
+		rotations[i] = RandomRotation(rng);
+		Vec3 p(position(rng), position(rng), position(rng));
+		transforms[i] = Transform(p, rotations[i], Vec3(scale(rng), scale(rng), scale(rng)));
+		rigidTransforms[i] = Transform(p, rotations[i], Vec3(1.f, 1.f, 1.f));
+	}
+
+	std::vector<PackedQuaternion48> q48(Count);
+	std::vector<PackedQuaternion32> q32(Count);
+	std::vector<PackedTransform> packedTransforms(Count);
+	std::vector<PackedRigidTransform> packedRigid(Count);
+	PackMany(rotations.data(), q48.data(), Count);
+	PackMany(rotations.data(), q32.data(), Count);
+	PackMany(transforms.data(), packedTransforms.data(), Count);
+	PackMany(rigidTransforms.data(), packedRigid.data(), Count);
+
+	PrintQuantizationError("PackedQuaternion48", MeasureError(rotations.data(), q48.data(), Count), false, false);
+	PrintQuantizationError("PackedQuaternion32", MeasureError(rotations.data(), q32.data(), Count), false, false);
+	PrintQuantizationError("PackedTransform", MeasureError(transforms.data(), packedTransforms.data(), Count), true, true);
+	PrintQuantizationError("PackedRigidTransform", MeasureError(rigidTransforms.data(), packedRigid.data(), Count), true, false);
+}
+
+};
+
+void ReportMathAccuracy(const char* variant)
+{
+	printf("%s:\n", variant);
+	CheckSinCos("|angle| <= 100 pi", 100. * PI);
+	CheckSinCos("|angle| <= 10000", 10000.);
+	CheckRSqrt();
+	CheckRotations();
+	CheckSlerpApprox();
+	CheckQuantization();
+}
+
+};
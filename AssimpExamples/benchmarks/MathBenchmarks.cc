@@ -0,0 +1,433 @@
+// Benchmarks for the math code in common/, in single-value and batched form.
+// This file (along with common/) is compiled once per variant - the build renames the sess
+//  namespace for each one (sess_scalar, sess_sse, sess_avx), so all of them can live in one
+//  executable without stepping on each other. See CMakeLists.txt.
+
+#include <Transform.h>
+#include <TransformSoA.h>
+#include <TransformHierarchy.h>
+#include <QuaternionBatch.h>
+#include <Frustum.h>
+#include <DualQuaternion.h>
+#include <Quantize.h>
+#include <ColorConvert.h>
+#include <MeshConvert.h>
+#include <CompactVertex.h>
+
+#include <assimp/mesh.h>
+
+#include "Benchmark.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#if !defined(SESS_BENCH_VARIANT)
+#error SESS_BENCH_VARIANT should be set by the build (scalar, sse, avx)
+#endif
+
+namespace sess
+{
+
+namespace
+{
+
+using bench::DoNotOptimize;
+using bench::ClobberMemory;
+using bench::Runner;
+
+// Single-value benchmarks cycle through this many inputs, so the compiler can't fold
+//  anything away and the data stays in L1
+const std::size_t SingleInputs = 256u;
+const std::size_t SingleMask = SingleInputs - 1u;
+
+// Batched benchmarks work on this many items per call - big enough that the loop overhead
+//  doesn't matter, small enough to stay in cache (a batch of matrices is 64kB)
+const std::size_t BatchSize = 1024u;
+
+Vec3 RandomVec3(std::mt19937& rng, float range)
+{
+	std::uniform_real_distribution<float> d(-range, range);
+	return Vec3(d(rng), d(rng), d(rng));
+}
+
+Quaternion RandomRotation(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+	Vec3 axis = RandomVec3(rng, 1.f);
+	return Quaternion(axis.Magnitude() > 0.001f ? axis : Vec3::UnitY, angle(rng));
+}
+
+Transform RandomTransform(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> scale(0.5f, 2.f);
+	return Transform(RandomVec3(rng, 100.f), RandomRotation(rng), Vec3(scale(rng), scale(rng), scale(rng)));
+}
+
+// Everything the benchmarks read from. Filled the same way (same seed) for every variant.
+struct Inputs
+{
+public:
+	std::vector<Vec3> Points;
+	std::vector<Vec3> Normals;
+	std::vector<Quaternion> Rotations;
+	std::vector<Quaternion> OtherRotations;
+	std::vector<Transform> Transforms;
+	std::vector<Transform> OtherTransforms;
+	std::vector<Matrix> Matrices;
+	std::vector<Matrix> OtherMatrices;
+	std::vector<Affine3x4> Affines;
+	std::vector<Affine3x4> OtherAffines;
+	std::vector<float> Floats;
+
+public:
+	explicit Inputs(std::size_t n)
+	{
+		std::mt19937 rng(1234u);
+		for (std::size_t i = 0u; i < n; i++)
+		{
+			Points.push_back(RandomVec3(rng, 100.f));
+			Normals.push_back(RandomVec3(rng, 1.f).Normal());
+			Rotations.push_back(RandomRotation(rng));
+			OtherRotations.push_back(RandomRotation(rng));
+			Transforms.push_back(RandomTransform(rng));
+			OtherTransforms.push_back(RandomTransform(rng));
+			Matrices.push_back(Transforms.back().GetTransformMatrix());
+			OtherMatrices.push_back(OtherTransforms.back().GetTransformMatrix());
+			Affines.push_back(Transforms.back().GetAffineMatrix());
+			OtherAffines.push_back(OtherTransforms.back().GetAffineMatrix());
+			Floats.push_back(RandomVec3(rng, 1000.f).x);
+		}
+	}
+};
+
+const Inputs& SingleData()
+{
+	static Inputs inputs(SingleInputs);
+	return inputs;
+}
+
+// op(i) is one operation on input i, and its result is kept alive
+template <typename Op>
+void RegisterSingle(const char* name, Op op)
+{
+	bench::Register(SESS_BENCH_VARIANT, name, 1u, [op]() -> Runner
+	{
+		SingleData();
+		return [op](std::size_t iterations)
+		{
+			for (std::size_t i = 0u; i < iterations; i++)
+			{
+				DoNotOptimize(op(i & SingleMask));
+			}
+		};
+	});
+}
+
+// Same layout as TexturedShader::Vertex in the 03 demo
+struct MeshVertex
+{
+public:
+	Vec3 Position;
+	float __one;
+	Vec3 Normal;
+	float __zero;
+	float U, V;
+
+public:
+	MeshVertex() {}
+	MeshVertex(const Vec3& pos, const Vec3& norm, float u, float v)
+		: Position(pos), __one(1.f), Normal(norm), __zero(0.f), U(u), V(v)
+	{}
+
+	static MeshVertexLayout Layout()
+	{
+		return MeshVertexLayout(sizeof(MeshVertex), offsetof(MeshVertex, Position), offsetof(MeshVertex, Normal), offsetof(MeshVertex, U));
+	}
+};
+
+// Set up fresh for each batched benchmark, outside of the timing
+struct BatchState : public Inputs
+{
+public:
+	std::vector<Vec3> OutPoints;
+	std::vector<Vec3> OutNormals;
+	std::vector<Quaternion> OutRotations;
+	std::vector<Matrix> OutMatrices;
+	std::vector<Affine3x4> OutAffines;
+	QuaternionSoA RotationsSoA;
+	QuaternionSoA OtherRotationsSoA;
+	QuaternionSoA OutRotationsSoA;
+	TransformSoA TransformsSoA;
+	BoundingSphereSoA Spheres;
+	AABBSoA Boxes;
+	std::vector<std::uint8_t> Visible;
+	Frustum View;
+	TransformHierarchy Hierarchy;
+	std::vector<DualQuaternion> Palette;
+	std::vector<std::uint32_t> BoneIndices;
+	std::vector<float> BoneWeights;
+	std::vector<PackedQuaternion48> Packed48;
+	std::vector<PackedQuaternion32> Packed32;
+	std::vector<std::uint16_t> Halves;
+	std::vector<float> OutSin;
+	std::vector<float> OutCos;
+
+	// BatchSize RGBA pixels in each format
+	std::vector<float> Pixels;
+	std::vector<std::uint8_t> PixelBytes;
+	std::vector<std::uint16_t> PixelHalves;
+	std::vector<float> OutPixels;
+
+	// BatchSize vertices and BatchSize triangles, the way Assimp hands them over
+	std::shared_ptr<aiMesh> Mesh;
+	// ... and converted, the way a CookedModel hands them over
+	ConvertedMesh<MeshVertex> Converted;
+	std::vector<CompactTexturedVertex> Compact;
+
+public:
+	BatchState()
+		: Inputs(BatchSize)
+		, OutPoints(BatchSize)
+		, OutNormals(BatchSize)
+		, OutRotations(BatchSize)
+		, OutMatrices(BatchSize)
+		, OutAffines(BatchSize)
+		, Visible(BatchSize)
+		, View(LookAtLH(Vec3(0.f, 0.f, -150.f), Vec3::Zero, Vec3::UnitY), PerspectiveLH(1.2f, 16.f / 9.f, 0.1f, 400.f))
+		, Packed48(BatchSize)
+		, Packed32(BatchSize)
+		, Halves(BatchSize)
+		, OutSin(BatchSize)
+		, OutCos(BatchSize)
+		, PixelBytes(BatchSize * 4u)
+		, PixelHalves(BatchSize * 4u)
+		, OutPixels(BatchSize * 4u)
+	{
+		std::mt19937 rng(5678u);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		for (std::size_t i = 0u; i < BatchSize; i++)
+		{
+			RotationsSoA.PushBack(Rotations[i]);
+			OtherRotationsSoA.PushBack(OtherRotations[i]);
+			OutRotationsSoA.PushBack(Quaternion());
+			TransformsSoA.Add(Transforms[i]);
+			Spheres.PushBack(BoundingSphere(Points[i], 1.f + 10.f * unit(rng)));
+			Boxes.PushBack(AABB(Points[i] - Vec3::Ones, Points[i] + Vec3::Ones * (1.f + 10.f * unit(rng))));
+
+			// A wide, shallow tree - four children per node, like a skeleton's fingers
+			Hierarchy.Add(Transforms[i], i == 0u ? TransformHierarchy::NoParent : (std::uint32_t)((i - 1u) / 4u));
+		}
+		Hierarchy.Update();
+
+		// 64 bones, four influences per vertex
+		for (std::size_t i = 0u; i < 64u; i++)
+		{
+			Palette.push_back(DualQuaternion::FromTransform(Transforms[i]));
+		}
+		for (std::size_t i = 0u; i < BatchSize * DualQuaternion::InfluencesPerVertex; i++)
+		{
+			BoneIndices.push_back((std::uint32_t)(rng() % Palette.size()));
+			BoneWeights.push_back(0.25f);
+		}
+
+		PackMany(&Rotations[0], &Packed48[0], BatchSize);
+		PackMany(&Rotations[0], &Packed32[0], BatchSize);
+
+		// A little out of range on both ends, so the clamping gets exercised
+		std::uniform_real_distribution<float> channel(-0.1f, 1.1f);
+		for (std::size_t i = 0u; i < BatchSize * 4u; i++)
+		{
+			Pixels.push_back(channel(rng));
+		}
+		LinearToSrgb8Many(&Pixels[0], &PixelBytes[0], BatchSize);
+		Srgb8ToLinearHalfMany(&PixelBytes[0], &PixelHalves[0], BatchSize);
+
+		Mesh = std::make_shared<aiMesh>();
+		Mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		Mesh->mNumVertices = (unsigned int)BatchSize;
+		Mesh->mVertices = new aiVector3D[BatchSize];
+		Mesh->mNormals = new aiVector3D[BatchSize];
+		Mesh->mTextureCoords[0] = new aiVector3D[BatchSize];
+		Mesh->mNumUVComponents[0] = 2u;
+		Mesh->mNumFaces = (unsigned int)BatchSize;
+		Mesh->mFaces = new aiFace[BatchSize];
+		for (std::size_t i = 0u; i < BatchSize; i++)
+		{
+			Mesh->mVertices[i] = aiVector3D(Points[i].x, Points[i].y, Points[i].z);
+			Mesh->mNormals[i] = aiVector3D(Normals[i].x, Normals[i].y, Normals[i].z);
+			Mesh->mTextureCoords[0][i] = aiVector3D(unit(rng), unit(rng), 0.f);
+			Mesh->mFaces[i].mNumIndices = 3u;
+			Mesh->mFaces[i].mIndices = new unsigned int[3];
+			for (int k = 0; k < 3; k++)
+			{
+				Mesh->mFaces[i].mIndices[k] = (unsigned int)(rng() % BatchSize);
+			}
+		}
+		ConvertAssimpMesh(Mesh.get(), Converted);
+		Compact.resize(BatchSize);
+	}
+};
+
+// The per-vertex loop every Assimp loader had before MeshConvert.h, for comparison
+void ConvertMeshPushBack(const aiMesh* mesh, ConvertedMesh<MeshVertex>& out)
+{
+	out.Vertices.reserve(mesh->mNumVertices);
+	for (std::uint32_t vertIdx = 0u; vertIdx < mesh->mNumVertices; vertIdx++)
+	{
+		aiVector3D vert = mesh->mVertices[vertIdx];
+		aiVector3D norm = mesh->mNormals[vertIdx];
+		out.Bounds.Add(Vec3(vert.x, vert.y, vert.z));
+		aiVector3D uv = mesh->mTextureCoords[0][vertIdx];
+		out.Vertices.push_back(MeshVertex(Vec3(vert.x, vert.y, vert.z), Vec3(norm.x, norm.y, norm.z), uv.x, uv.y));
+	}
+
+	out.Indices.reserve(mesh->mNumFaces * 3u);
+	for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++)
+	{
+		out.Indices.push_back(mesh->mFaces[faceIdx].mIndices[0u]);
+		out.Indices.push_back(mesh->mFaces[faceIdx].mIndices[1u]);
+		out.Indices.push_back(mesh->mFaces[faceIdx].mIndices[2u]);
+	}
+}
+
+// op(state) is one batched call over BatchSize items
+template <typename Op>
+void RegisterBatch(const char* name, Op op)
+{
+	bench::Register(SESS_BENCH_VARIANT, name, BatchSize, [op]() -> Runner
+	{
+		std::shared_ptr<BatchState> state = std::make_shared<BatchState>();
+		return [op, state](std::size_t iterations)
+		{
+			for (std::size_t i = 0u; i < iterations; i++)
+			{
+				op(*state);
+				ClobberMemory();
+			}
+		};
+	});
+}
+
+};
+
+void RegisterMathBenchmarks()
+{
+	const Inputs& in = SingleData();
+
+	//
+	// Single values
+	//
+	RegisterSingle("ExactMath::SinCos", [&in](std::size_t i) { float s, c; ExactMath::SinCos(in.Floats[i] * 0.01f, s, c); return s + c; });
+	RegisterSingle("FastMath::SinCos", [&in](std::size_t i) { float s, c; FastMath::SinCos(in.Floats[i] * 0.01f, s, c); return s + c; });
+	RegisterSingle("ExactMath::RSqrt", [&in](std::size_t i) { return ExactMath::RSqrt(in.Points[i].x * in.Points[i].x + 1.f); });
+	RegisterSingle("FastMath::RSqrt", [&in](std::size_t i) { return FastMath::RSqrt(in.Points[i].x * in.Points[i].x + 1.f); });
+	RegisterSingle("Vec3::Normal", [&in](std::size_t i) { return in.Points[i].Normal(); });
+	RegisterSingle("Vec3::Normal<FastMath>", [&in](std::size_t i) { return in.Points[i].Normal<FastMath>(); });
+	RegisterSingle("Quaternion(axis, angle)", [&in](std::size_t i) { return Quaternion(in.Normals[i], in.Floats[i] * 0.01f); });
+	RegisterSingle("Quaternion::FromAxisAngle<FastMath>", [&in](std::size_t i) { return Quaternion::FromAxisAngle<FastMath>(in.Normals[i], in.Floats[i] * 0.01f); });
+	RegisterSingle("PerspectiveLH<FastMath>", [&in](std::size_t i) { return PerspectiveLH<ColumnMajor, FastMath>(1.f + in.Floats[i] * 1e-4f, 16.f / 9.f, 0.1f, 1000.f); });
+	RegisterSingle("Vec3 * Quaternion", [&in](std::size_t i) { return in.Points[i] * in.Rotations[i]; });
+	RegisterSingle("Quaternion * Quaternion", [&in](std::size_t i) { return in.Rotations[i] * in.OtherRotations[i]; });
+	RegisterSingle("Quaternion::FromMatrix", [&in](std::size_t i) { return Quaternion::FromMatrix(in.Matrices[i]); });
+	RegisterSingle("Quaternion::Slerp", [&in](std::size_t i) { return Quaternion::Slerp(in.Rotations[i], in.OtherRotations[i], 0.3f); });
+	RegisterSingle("Quaternion::SlerpApprox", [&in](std::size_t i) { return Quaternion::SlerpApprox(in.Rotations[i], in.OtherRotations[i], 0.3f); });
+	RegisterSingle("Matrix * Matrix", [&in](std::size_t i) { return in.Matrices[i] * in.OtherMatrices[i]; });
+	RegisterSingle("Matrix::Inverse", [&in](std::size_t i) { return in.Matrices[i].Inverse(); });
+	RegisterSingle("Matrix::AffineInverse", [&in](std::size_t i) { return in.Matrices[i].AffineInverse(); });
+	RegisterSingle("Affine3x4 * Affine3x4", [&in](std::size_t i) { return in.Affines[i] * in.OtherAffines[i]; });
+	RegisterSingle("Affine3x4::Inverse", [&in](std::size_t i) { return in.Affines[i].Inverse(); });
+	RegisterSingle("Affine3x4::TransformPoint", [&in](std::size_t i) { return in.Affines[i].TransformPoint(in.Points[i]); });
+	RegisterSingle("Transform * Transform", [&in](std::size_t i) { return in.Transforms[i] * in.OtherTransforms[i]; });
+	RegisterSingle("Transform::GetTransformMatrix", [&in](std::size_t i) { return in.Transforms[i].GetTransformMatrix(); });
+	RegisterSingle("Transform::GetAffineMatrix", [&in](std::size_t i) { return in.Transforms[i].GetAffineMatrix(); });
+	RegisterSingle("Transform::FromTransformMatrix", [&in](std::size_t i) { return Transform::FromTransformMatrix(in.Matrices[i]); });
+	RegisterSingle("LookAtLH", [&in](std::size_t i) { return LookAtLH(in.Points[i], in.Points[(i + 1u) & SingleMask], Vec3::UnitY); });
+	RegisterSingle("PerspectiveLH", [&in](std::size_t i) { return PerspectiveLH(1.f + in.Floats[i] * 1e-4f, 16.f / 9.f, 0.1f, 1000.f); });
+	RegisterSingle("Frustum(viewProj)", [&in](std::size_t i) { return Frustum(in.Matrices[i] * in.OtherMatrices[i]); });
+	RegisterSingle("DualQuaternion::TransformPoint", [&in](std::size_t i) { return DualQuaternion::FromTransform(in.Transforms[i]).TransformPoint(in.Points[i]); });
+	RegisterSingle("PackedQuaternion48::Pack", [&in](std::size_t i) { return PackedQuaternion48::Pack(in.Rotations[i]); });
+	RegisterSingle("FloatToHalf", [&in](std::size_t i) { return FloatToHalf(in.Floats[i]); });
+
+	//
+	// Batches
+	//
+	// Plain loops - the polynomials inline and vectorize, where sinf/cosf stay a call each
+	RegisterBatch("ExactMath::SinCos loop", [](BatchState& s)
+	{
+		const float* angles = &s.Floats[0];
+		float* sines = &s.OutSin[0];
+		float* cosines = &s.OutCos[0];
+		for (std::size_t i = 0u; i < BatchSize; i++)
+		{
+			ExactMath::SinCos(angles[i] * 0.01f, sines[i], cosines[i]);
+		}
+	});
+	RegisterBatch("FastMath::SinCos loop", [](BatchState& s)
+	{
+		const float* angles = &s.Floats[0];
+		float* sines = &s.OutSin[0];
+		float* cosines = &s.OutCos[0];
+		for (std::size_t i = 0u; i < BatchSize; i++)
+		{
+			FastMath::SinCos(angles[i] * 0.01f, sines[i], cosines[i]);
+		}
+	});
+	RegisterBatch("Quaternion::RotateMany", [](BatchState& s) { s.Rotations[0].RotateMany(&s.Points[0], &s.OutPoints[0], BatchSize); });
+	RegisterBatch("Quaternion::MultiplyMany", [](BatchState& s) { Quaternion::MultiplyMany(&s.Rotations[0], &s.OtherRotations[0], &s.OutRotations[0], BatchSize); });
+	RegisterBatch("Quaternion::FromMatrixMany", [](BatchState& s) { Quaternion::FromMatrixMany(&s.Matrices[0], &s.OutRotations[0], BatchSize); });
+	RegisterBatch("SlerpMany (exact)", [](BatchState& s) { SlerpMany(s.RotationsSoA, s.OtherRotationsSoA, 0.3f, s.OutRotationsSoA, SlerpPrecision::Exact); });
+	RegisterBatch("SlerpMany (approximate)", [](BatchState& s) { SlerpMany(s.RotationsSoA, s.OtherRotationsSoA, 0.3f, s.OutRotationsSoA, SlerpPrecision::Approximate); });
+	RegisterBatch("NlerpMany", [](BatchState& s) { NlerpMany(s.RotationsSoA, s.OtherRotationsSoA, 0.3f, s.OutRotationsSoA); });
+	RegisterBatch("Matrix::MultiplyMany", [](BatchState& s) { Matrix::MultiplyMany(&s.Matrices[0], &s.OtherMatrices[0], &s.OutMatrices[0], BatchSize); });
+	RegisterBatch("Affine3x4::MultiplyMany", [](BatchState& s) { Affine3x4::MultiplyMany(&s.Affines[0], &s.OtherAffines[0], &s.OutAffines[0], BatchSize); });
+	RegisterBatch("Affine3x4::TransformPoints", [](BatchState& s) { s.Affines[0].TransformPoints(&s.Points[0], &s.OutPoints[0], BatchSize); });
+	RegisterBatch("TransformSoA::GetTransformMatrices", [](BatchState& s) { s.TransformsSoA.GetTransformMatrices(&s.OutMatrices[0]); });
+	RegisterBatch("TransformHierarchy::Update (all dirty)", [](BatchState& s)
+	{
+		s.Hierarchy.SetLocal(0u, s.Transforms[0]);
+		s.Hierarchy.Update();
+	});
+	RegisterBatch("Frustum::Cull (spheres)", [](BatchState& s) { s.View.Cull(s.Spheres, &s.Visible[0]); });
+	RegisterBatch("Frustum::Cull (AABBs)", [](BatchState& s) { s.View.Cull(s.Boxes, &s.Visible[0]); });
+	RegisterBatch("DualQuaternion::SkinMany", [](BatchState& s)
+	{
+		DualQuaternion::SkinMany(&s.Palette[0], &s.BoneIndices[0], &s.BoneWeights[0], &s.Points[0], &s.Normals[0], &s.OutPoints[0], &s.OutNormals[0], BatchSize);
+	});
+	RegisterBatch("PackMany (quaternion 48)", [](BatchState& s) { PackMany(&s.Rotations[0], &s.Packed48[0], BatchSize); });
+	RegisterBatch("UnpackMany (quaternion 48)", [](BatchState& s) { UnpackMany(&s.Packed48[0], &s.OutRotations[0], BatchSize); });
+	RegisterBatch("PackMany (quaternion 32)", [](BatchState& s) { PackMany(&s.Rotations[0], &s.Packed32[0], BatchSize); });
+	RegisterBatch("FloatToHalfMany", [](BatchState& s) { FloatToHalfMany(&s.Floats[0], &s.Halves[0], BatchSize); });
+
+	// Colors - items are RGBA pixels
+	RegisterBatch("FloatToUnorm8Many (RGBA)", [](BatchState& s) { FloatToUnorm8Many(&s.Pixels[0], &s.PixelBytes[0], BatchSize * 4u); });
+	RegisterBatch("Unorm8ToFloatMany (RGBA)", [](BatchState& s) { Unorm8ToFloatMany(&s.PixelBytes[0], &s.OutPixels[0], BatchSize * 4u); });
+	RegisterBatch("LinearToSrgb8Many", [](BatchState& s) { LinearToSrgb8Many(&s.Pixels[0], &s.PixelBytes[0], BatchSize); });
+	RegisterBatch("Srgb8ToLinearMany", [](BatchState& s) { Srgb8ToLinearMany(&s.PixelBytes[0], &s.OutPixels[0], BatchSize); });
+	RegisterBatch("Srgb8ToLinearHalfMany", [](BatchState& s) { Srgb8ToLinearHalfMany(&s.PixelBytes[0], &s.PixelHalves[0], BatchSize); });
+	RegisterBatch("LinearHalfToSrgb8Many", [](BatchState& s) { LinearHalfToSrgb8Many(&s.PixelHalves[0], &s.PixelBytes[0], BatchSize); });
+
+	// Meshes - items are vertices (and as many triangles). Fresh output each time, like a
+	//  loader would have.
+	RegisterBatch("Mesh conversion (push_back loop)", [](BatchState& s)
+	{
+		ConvertedMesh<MeshVertex> out;
+		ConvertMeshPushBack(s.Mesh.get(), out);
+		DoNotOptimize(out.Vertices[0]);
+	});
+	RegisterBatch("ConvertAssimpMesh", [](BatchState& s)
+	{
+		ConvertedMesh<MeshVertex> out;
+		ConvertAssimpMesh(s.Mesh.get(), out);
+		DoNotOptimize(out.Vertices[0]);
+	});
+	RegisterBatch("EncodeCompactVertices (textured)", [](BatchState& s)
+	{
+		EncodeCompactVertices(&s.Converted.Vertices[0], MeshVertex::Layout(), BatchSize, s.Converted.Bounds, &s.Compact[0]);
+	});
+	RegisterBatch("NarrowIndices", [](BatchState& s) { NarrowIndices(&s.BoneIndices[0], &s.Halves[0], BatchSize); });
+}
+
+};
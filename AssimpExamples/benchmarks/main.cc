@@ -0,0 +1,132 @@
+// Headless benchmark runner for the math code in common/. No window, no D3D, no Assimp
+//  import - builds and runs anywhere with a C++11 compiler and CMake.
+//
+//  mathbench [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--csv]
+//  mathbench --accuracy    (error of FastMath and the other approximations instead of timings)
+//
+// Every benchmark runs once per variant that was built (and that the CPU can run), and
+//  the table puts them side by side:
+//  scalar - SESS_NO_SIMD, the plain C++ paths
+//  sse    - the default x64 build (SSE2)
+//  avx    - built with AVX and F16C turned on
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Each variant's copy of the math code lives in its own renamed namespace
+namespace sess_scalar { void RegisterMathBenchmarks(); void ReportMathAccuracy(const char* variant); };
+#if defined(SESS_BENCH_HAS_SSE)
+namespace sess_sse { void RegisterMathBenchmarks(); void ReportMathAccuracy(const char* variant); };
+#endif
+#if defined(SESS_BENCH_HAS_AVX)
+namespace sess_avx { void RegisterMathBenchmarks(); void ReportMathAccuracy(const char* variant); };
+#endif
+
+namespace
+{
+
+bool CpuHasAvx()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#else
+	return false;
+#endif
+}
+
+void PrintUsage()
+{
+	fprintf(stderr, "usage: mathbench [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--csv]\n");
+	fprintf(stderr, "       mathbench --accuracy\n");
+}
+
+};
+
+int main(int argc, char** argv)
+{
+	bench::Options options;
+	bool accuracy = false;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--filter") && hasValue)
+		{
+			options.Filter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--min-time") && hasValue)
+		{
+			options.MinSeconds = atof(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--repetitions") && hasValue)
+		{
+			options.Repetitions = (std::size_t)std::max(1, atoi(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--csv"))
+		{
+			options.Csv = true;
+		}
+		else if (!strcmp(argv[i], "--accuracy"))
+		{
+			accuracy = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (accuracy)
+	{
+		sess_scalar::ReportMathAccuracy("scalar");
+#if defined(SESS_BENCH_HAS_SSE)
+		sess_sse::ReportMathAccuracy("sse");
+#endif
+#if defined(SESS_BENCH_HAS_AVX)
+		if (CpuHasAvx())
+		{
+			sess_avx::ReportMathAccuracy("avx");
+		}
+#endif
+		return 0;
+	}
+
+	std::vector<std::string> variants;
+	sess_scalar::RegisterMathBenchmarks();
+	variants.push_back("scalar");
+#if defined(SESS_BENCH_HAS_SSE)
+	sess_sse::RegisterMathBenchmarks();
+	variants.push_back("sse");
+#endif
+#if defined(SESS_BENCH_HAS_AVX)
+	// Nothing from the AVX build runs (not even its setup code) unless the CPU has it
+	if (CpuHasAvx())
+	{
+		sess_avx::RegisterMathBenchmarks();
+		variants.push_back("avx");
+	}
+	else
+	{
+		fprintf(stderr, "This CPU doesn't have AVX/F16C, skipping the avx variant\n");
+	}
+#endif
+
+	std::vector<bench::Result> results = bench::RunAll(options);
+	if (options.Csv)
+	{
+		bench::PrintCsv(results);
+	}
+	else
+	{
+		bench::PrintTable(results, variants);
+	}
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include <Affine3x4.h>
+
+namespace sess
+{
+
+static_assert(sizeof(Affine3x4) == 12u * sizeof(float), "Affine3x4 is uploaded to constant buffers as a float4x3");
+
+const Affine3x4 Affine3x4::Identity = Affine3x4::FromRows(1.f, 0.f, 0.f,  0.f, 1.f, 0.f,  0.f, 0.f, 1.f,  0.f, 0.f, 0.f);
+
+#if defined(SESS_SIMD_SSE)
+namespace
+{
+
+template <int a, int b, int c, int d>
+inline __m128 Swizzle(__m128 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(d, c, b, a));
+}
+
+// a x b in the first three lanes. The fourth comes out as a.w * b.w - a.w * b.w = 0.
+inline __m128 Cross(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(
+		_mm_mul_ps(Swizzle<1, 2, 0, 3>(a), Swizzle<2, 0, 1, 3>(b)),
+		_mm_mul_ps(Swizzle<2, 0, 1, 3>(a), Swizzle<1, 2, 0, 3>(b)));
+}
+
+};
+#endif
+
+// The storage rows are the columns c0, c1, c2 of the 3x3 part A. The rows of A^-1 are then
+//  (c1 x c2, c2 x c0, c0 x c1) / det, with det = c0 . (c1 x c2) - and the translation of
+//  the inverse is -t A^-1, which is the rows of A^-1 weighted by the old translation.
+// That gives the inverse row by row, and the storage wants it column by column, so the
+//  last step is a transpose (which picks up the new translation as the fourth column).
+Affine3x4 Affine3x4::Inverse() const
+{
+	Affine3x4 inv(NoInit{});
+
+#if defined(SESS_SIMD_SSE)
+	__m128 c0 = _mm_loadu_ps(m[0]);
+	__m128 c1 = _mm_loadu_ps(m[1]);
+	__m128 c2 = _mm_loadu_ps(m[2]);
+
+	__m128 r0 = Cross(c1, c2);
+	__m128 r1 = Cross(c2, c0);
+	__m128 r2 = Cross(c0, c1);
+
+	// The w lane of r0 is 0, so the translation in c0 drops out of the dot product
+	__m128 det = _mm_mul_ps(c0, r0);
+	det = _mm_add_ps(det, Swizzle<1, 0, 3, 2>(det));
+	det = _mm_add_ps(det, Swizzle<2, 3, 0, 1>(det));
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+	r0 = _mm_mul_ps(r0, invDet);
+	r1 = _mm_mul_ps(r1, invDet);
+	r2 = _mm_mul_ps(r2, invDet);
+
+	__m128 t = _mm_mul_ps(Swizzle<3, 3, 3, 3>(c0), r0);
+	t = _mm_add_ps(t, _mm_mul_ps(Swizzle<3, 3, 3, 3>(c1), r1));
+	t = _mm_add_ps(t, _mm_mul_ps(Swizzle<3, 3, 3, 3>(c2), r2));
+	t = _mm_xor_ps(t, _mm_set1_ps(-0.f));
+
+	_MM_TRANSPOSE4_PS(r0, r1, r2, t);
+	_mm_storeu_ps(inv.m[0], r0);
+	_mm_storeu_ps(inv.m[1], r1);
+	_mm_storeu_ps(inv.m[2], r2);
+#else
+	const float* c0 = m[0];
+	const float* c1 = m[1];
+	const float* c2 = m[2];
+
+	float r[3][3] = {
+		{ c1[1] * c2[2] - c1[2] * c2[1], c1[2] * c2[0] - c1[0] * c2[2], c1[0] * c2[1] - c1[1] * c2[0] },
+		{ c2[1] * c0[2] - c2[2] * c0[1], c2[2] * c0[0] - c2[0] * c0[2], c2[0] * c0[1] - c2[1] * c0[0] },
+		{ c0[1] * c1[2] - c0[2] * c1[1], c0[2] * c1[0] - c0[0] * c1[2], c0[0] * c1[1] - c0[1] * c1[0] },
+	};
+	float invDet = 1.f / (c0[0] * r[0][0] + c0[1] * r[0][1] + c0[2] * r[0][2]);
+
+	for (int col = 0; col < 3; col++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			inv.m[col][row] = r[row][col] * invDet;
+		}
+		inv.m[col][3] = -(c0[3] * inv.m[col][0] + c1[3] * inv.m[col][1] + c2[3] * inv.m[col][2]);
+	}
+#endif
+
+	return inv;
+}
+
+void Affine3x4::MultiplyMany(const Affine3x4* a, const Affine3x4* b, Affine3x4* out, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		ComposeKernel(a[i], b[i], out[i]);
+	}
+}
+
+static_assert(sizeof(Vec3) == 3u * sizeof(float), "TransformPoints expects tightly packed Vec3 arrays");
+
+void Affine3x4::TransformPoints(const Vec3* points, Vec3* out, std::size_t n) const
+{
+	std::size_t i = 0u;
+
+#if defined(SESS_SIMD_SSE)
+	// Four points at a time, shuffled into all-x, all-y and all-z registers and back - same
+	//  as Quaternion::RotateMany. Each output component is then three multiply-adds against
+	//  broadcast matrix elements.
+	const __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]), m03 = _mm_set1_ps(m[0][3]);
+	const __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]), m13 = _mm_set1_ps(m[1][3]);
+	const __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]), m23 = _mm_set1_ps(m[2][3]);
+	for (; i + 4u <= n; i += 4u)
+	{
+		const float* src = &points[i].x;
+		__m128 p0 = _mm_loadu_ps(src); // x0 y0 z0 x1
+		__m128 p1 = _mm_loadu_ps(src + 4); // y1 z1 x2 y2
+		__m128 p2 = _mm_loadu_ps(src + 8); // z2 x3 y3 z3
+
+		__m128 vx = _mm_shuffle_ps(p0, _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		__m128 vy = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 vz = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 1, 2, 2)), p2, _MM_SHUFFLE(3, 0, 2, 0));
+
+		__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, vx), _mm_mul_ps(m01, vy)), _mm_add_ps(_mm_mul_ps(m02, vz), m03));
+		__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, vx), _mm_mul_ps(m11, vy)), _mm_add_ps(_mm_mul_ps(m12, vz), m13));
+		__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, vx), _mm_mul_ps(m21, vy)), _mm_add_ps(_mm_mul_ps(m22, vz), m23));
+
+		float* dst = &out[i].x;
+		__m128 xy = _mm_unpacklo_ps(rx, ry); // x0 y0 x1 y1
+		__m128 xyHi = _mm_unpackhi_ps(rx, ry); // x2 y2 x3 y3
+		_mm_storeu_ps(dst, _mm_shuffle_ps(xy, _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storeu_ps(dst + 4, _mm_shuffle_ps(_mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)), xyHi, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(dst + 8, _mm_shuffle_ps(_mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+#endif
+
+	for (; i < n; i++)
+	{
+		out[i] = TransformPoint(points[i]);
+	}
+}
+
+};
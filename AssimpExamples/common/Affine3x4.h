@@ -0,0 +1,178 @@
+#pragma once
+
+// Affine transform matrix - a 4x4 matrix without the constant last column.
+// Everything a Transform turns into (and everything a TransformHierarchy multiplies
+//  together) has 0 0 0 1 down the right side, so a full Matrix spends a quarter of its
+//  memory, and a quarter of every product, on numbers that are always the same.
+// This stores the other twelve, three rows of four floats:
+//  m[c] = (column c of the upper 3x3, translation c)
+// ... which is exactly the first 48 bytes of a (column major) Matrix of the same transform,
+//  and exactly how HLSL packs a float4x3. So it goes into a constant buffer as-is, and the
+//  shader does mul(float4(position, 1), mModel) the same way it would with a matrix.
+// Math conventions are the same as Matrix - row vectors, a then b is a * b.
+
+#include <Matrix.h>
+#include <Vec3.h>
+
+#include <cstddef>
+
+namespace sess
+{
+
+class SESS_MATRIX_ALIGNMENT Affine3x4
+{
+public:
+	// m[c][0..2] is column c of the rotation/scale part, m[c][3] is the translation along c
+	float m[3][4];
+
+public:
+	constexpr Affine3x4() : m{} {}
+	Affine3x4(const Affine3x4&) = default;
+	~Affine3x4() = default;
+
+	// Drops the last column of a 4x4 matrix - it had better be 0 0 0 1
+	template <typename Layout>
+	explicit constexpr Affine3x4(const MatrixT<Layout>& o)
+		: Affine3x4(FromRows(
+			o.At(0, 0), o.At(0, 1), o.At(0, 2),
+			o.At(1, 0), o.At(1, 1), o.At(1, 2),
+			o.At(2, 0), o.At(2, 1), o.At(2, 2),
+			o.At(3, 0), o.At(3, 1), o.At(3, 2)))
+	{}
+
+	// The 4x3 matrix row by row, same as MatrixT::FromRows without the last column.
+	//  The last row is the translation.
+	static constexpr Affine3x4 FromRows(float r11, float r12, float r13, float r21, float r22, float r23, float r31, float r32, float r33, float r41, float r42, float r43)
+	{
+		return Affine3x4(
+			r11, r21, r31, r41,
+			r12, r22, r32, r42,
+			r13, r23, r33, r43);
+	}
+
+	// Element at (row, col) of the math matrix, for rows 0-3 and columns 0-2
+	constexpr float At(int row, int col) const { return m[col][row]; }
+
+	Vec3 GetTranslation() const { return Vec3(m[0][3], m[1][3], m[2][3]); }
+
+	// Puts the 0 0 0 1 column back
+	template <typename Layout = ColumnMajor>
+	MatrixT<Layout> ToMatrix() const
+	{
+		return MatrixT<Layout>::FromRows(
+			m[0][0], m[1][0], m[2][0], 0.f,
+			m[0][1], m[1][1], m[2][1], 0.f,
+			m[0][2], m[1][2], m[2][2], 0.f,
+			m[0][3], m[1][3], m[2][3], 1.f);
+	}
+
+	// Inverse of the 3x3 part by cross products, and the translation rotated back. Like
+	//  Matrix::AffineInverse, but with nothing to check or fill in for the fourth column.
+	// A singular matrix (zero scale on some axis) gives back infinities/NaNs.
+	Affine3x4 Inverse() const;
+
+	// this, then o
+	Affine3x4 operator*(const Affine3x4& o) const;
+
+	// p * M, translation included
+	Vec3 TransformPoint(const Vec3& p) const;
+
+	// v * M without the translation - for directions. Normals want the inverse transpose
+	//  instead if the scale isn't uniform (see Matrix::InverseTranspose).
+	Vec3 TransformVector(const Vec3& v) const;
+
+	// out[i] = a[i] * b[i]. out may be the same array as a or b.
+	static void MultiplyMany(const Affine3x4* a, const Affine3x4* b, Affine3x4* out, std::size_t n);
+
+	// out[i] = points[i] * this, four points at a time with SSE. out may be points.
+	void TransformPoints(const Vec3* points, Vec3* out, std::size_t n) const;
+
+public:
+	static const Affine3x4 Identity;
+
+protected:
+	// Storage order, which is the transpose of FromRows
+	constexpr Affine3x4(float m11, float m12, float m13, float m14, float m21, float m22, float m23, float m24, float m31, float m32, float m33, float m34)
+		: m{ { m11, m12, m13, m14 }, { m21, m22, m23, m24 }, { m31, m32, m33, m34 } }
+	{}
+
+	// Same as MatrixT - for results that are about to be overwritten anyways
+	struct NoInit {};
+	explicit Affine3x4(NoInit) {}
+
+	// out = a, then b on the raw storage. Shared by operator* and MultiplyMany.
+	static void ComposeKernel(const Affine3x4& a, const Affine3x4& b, Affine3x4& out);
+};
+
+// Each row of the storage is the affine function for one output component. Running a first
+//  and then b makes each row of the result a mix of the rows of a, weighted by that row of b,
+//  plus b's own translation:
+//  out[i] = b[i][0] * a[0] + b[i][1] * a[1] + b[i][2] * a[2] + (0, 0, 0, b[i][3])
+// Three broadcasts and three multiply-adds per row, against four and four for a 4x4 product
+//  - and one row fewer.
+// All of a is loaded first, and each row of b is read before that row of out is written, so
+//  out may alias either input.
+inline void Affine3x4::ComposeKernel(const Affine3x4& a, const Affine3x4& b, Affine3x4& out)
+{
+#if defined(SESS_SIMD_SSE)
+	const __m128 a0 = _mm_loadu_ps(a.m[0]);
+	const __m128 a1 = _mm_loadu_ps(a.m[1]);
+	const __m128 a2 = _mm_loadu_ps(a.m[2]);
+	const __m128 translationLane = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+	for (int row = 0; row < 3; row++)
+	{
+		__m128 br = _mm_loadu_ps(b.m[row]);
+		__m128 r = _mm_and_ps(br, translationLane);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(br, br, 0x00), a0));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(br, br, 0x55), a1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(br, br, 0xaa), a2));
+		_mm_storeu_ps(out.m[row], r);
+	}
+#else
+	// a with its implied 0 0 0 1 bottom row, so b's translation gets picked up like
+	//  everything else - the same loop as the 4x4 product, which vectorizes well
+	static const float lastRow[4] = { 0.f, 0.f, 0.f, 1.f };
+	float r[3][4];
+	for (int row = 0; row < 3; row++)
+	{
+		const float* br = b.m[row];
+		for (int col = 0; col < 4; col++)
+		{
+			r[row][col] = br[0] * a.m[0][col] + br[1] * a.m[1][col] + br[2] * a.m[2][col] + br[3] * lastRow[col];
+		}
+	}
+	for (int row = 0; row < 3; row++)
+	{
+		for (int col = 0; col < 4; col++)
+		{
+			out.m[row][col] = r[row][col];
+		}
+	}
+#endif
+}
+
+inline Affine3x4 Affine3x4::operator*(const Affine3x4& o) const
+{
+	Affine3x4 r(NoInit{});
+	ComposeKernel(*this, o, r);
+	return r;
+}
+
+inline Vec3 Affine3x4::TransformPoint(const Vec3& p) const
+{
+	return Vec3(
+		m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+		m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+		m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+}
+
+inline Vec3 Affine3x4::TransformVector(const Vec3& v) const
+{
+	return Vec3(
+		m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+		m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+		m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+}
+
+};
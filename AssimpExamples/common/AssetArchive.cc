@@ -0,0 +1,381 @@
+#include <AssetArchive.h>
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace sess
+{
+
+namespace
+{
+
+//
+// File layout:
+//  FileHeader
+//  FileEntry[EntryCount], sorted by name
+//  Names, one after the other (no terminators - each entry has its length)
+//  ... then each file's bytes, each one starting on a 64 byte boundary
+// Every offset is from the start of the file. Files keep their alignment from the start of
+//  the mapping (which is page aligned), so a cooked model in an archive can be drawn from
+//  in place, the same as one mapped on its own.
+//
+
+const char Magic[4] = { 'S', 'P', 'A', 'K' };
+const std::size_t DataAlignment = 64u;
+
+struct FileHeader
+{
+public:
+	char Magic[4];
+	std::uint32_t Version;
+	std::uint32_t EntryCount;
+	std::uint32_t NameBytes;
+	std::uint64_t FileSize;
+};
+
+struct FileEntry
+{
+public:
+	std::uint64_t DataOffset;
+	std::uint64_t Size;
+	std::uint32_t NameOffset; // Into the names, which start right after the entries
+	std::uint32_t NameLength;
+};
+
+std::size_t AlignUp(std::size_t n)
+{
+	return (n + DataAlignment - 1u) & ~(DataAlignment - 1u);
+}
+
+template <typename T>
+T ReadAt(const std::uint8_t* data, std::size_t offset)
+{
+	T t;
+	memcpy(&t, data + offset, sizeof(T));
+	return t;
+}
+
+//
+// Assimp file access, straight out of the mapping
+//
+class ArchiveIOStream : public Assimp::IOStream
+{
+public:
+	ArchiveIOStream(const AssetArchive::Entry& entry)
+		: entry_(entry)
+		, position_(0u)
+	{}
+
+	size_t Read(void* pvBuffer, size_t pSize, size_t pCount) override
+	{
+		// Whole elements only, like fread
+		if (pSize == 0u)
+		{
+			return 0u;
+		}
+		size_t count = std::min(pCount, (entry_.Size - position_) / pSize);
+		memcpy(pvBuffer, entry_.Data + position_, count * pSize);
+		position_ += count * pSize;
+		return count;
+	}
+
+	size_t Write(const void*, size_t, size_t) override
+	{
+		return 0u;
+	}
+
+	aiReturn Seek(size_t pOffset, aiOrigin pOrigin) override
+	{
+		// Offsets from the current position or the end can be "negative" - they come in as a
+		//  size_t that wraps around, and adding one back in wraps the other way
+		size_t position = pOffset;
+		if (pOrigin == aiOrigin_CUR)
+		{
+			position = position_ + pOffset;
+		}
+		else if (pOrigin == aiOrigin_END)
+		{
+			position = entry_.Size + pOffset;
+		}
+
+		if (position > entry_.Size)
+		{
+			return aiReturn_FAILURE;
+		}
+		position_ = position;
+		return aiReturn_SUCCESS;
+	}
+
+	size_t Tell() const override
+	{
+		return position_;
+	}
+
+	size_t FileSize() const override
+	{
+		return entry_.Size;
+	}
+
+	void Flush() override
+	{}
+
+protected:
+	AssetArchive::Entry entry_;
+	size_t position_;
+};
+
+class ArchiveIOSystem : public Assimp::IOSystem
+{
+public:
+	ArchiveIOSystem(const AssetArchive& archive)
+		: archive_(archive)
+	{}
+
+	bool Exists(const char* pFile) const override
+	{
+		return archive_.Contains(pFile);
+	}
+
+	char getOsSeparator() const override
+	{
+		return '/';
+	}
+
+	Assimp::IOStream* Open(const char* pFile, const char* pMode) override
+	{
+		AssetArchive::Entry entry;
+		if (strchr(pMode, 'w') || strchr(pMode, 'a') || strchr(pMode, '+') || !archive_.Find(pFile, entry))
+		{
+			return nullptr;
+		}
+		return new ArchiveIOStream(entry);
+	}
+
+	void Close(Assimp::IOStream* pFile) override
+	{
+		delete pFile;
+	}
+
+	bool ComparePaths(const char* one, const char* second) const override
+	{
+		return NormalizeAssetPath(one) == NormalizeAssetPath(second);
+	}
+
+protected:
+	const AssetArchive& archive_;
+};
+
+};
+
+//
+// AssetArchive
+//
+AssetArchive::AssetArchive()
+	: file_()
+	, entries_()
+{}
+
+bool AssetArchive::Open(const char* path)
+{
+	Close();
+	if (!file_.Open(path) || !file_.Data() || file_.Size() < sizeof(FileHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const std::uint8_t* data = file_.Data();
+	std::uint64_t size = file_.Size();
+	FileHeader header = ReadAt<FileHeader>(data, 0u);
+	std::uint64_t namesOffset = sizeof(FileHeader) + (std::uint64_t)header.EntryCount * sizeof(FileEntry);
+	if (memcmp(header.Magic, Magic, sizeof(Magic)) != 0
+		|| header.Version != Version
+		|| header.FileSize != size
+		|| namesOffset + header.NameBytes > size)
+	{
+		Close();
+		return false;
+	}
+
+	entries_.reserve(header.EntryCount);
+	for (std::uint32_t i = 0u; i < header.EntryCount; i++)
+	{
+		FileEntry entry = ReadAt<FileEntry>(data, sizeof(FileHeader) + i * sizeof(FileEntry));
+		if ((std::uint64_t)entry.NameOffset + entry.NameLength > header.NameBytes
+			|| entry.DataOffset > size
+			|| entry.Size > size - entry.DataOffset)
+		{
+			Close();
+			return false;
+		}
+
+		IndexEntry indexEntry;
+		indexEntry.Name.assign(reinterpret_cast<const char*>(data + namesOffset + entry.NameOffset), entry.NameLength);
+		indexEntry.Contents.Data = data + entry.DataOffset;
+		indexEntry.Contents.Size = (std::size_t)entry.Size;
+		entries_.push_back(std::move(indexEntry));
+	}
+
+	// Find counts on the order, so don't take it on faith
+	for (std::size_t i = 1u; i < entries_.size(); i++)
+	{
+		if (!(entries_[i - 1u].Name < entries_[i].Name))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AssetArchive::Close()
+{
+	file_.Close();
+	entries_.clear();
+}
+
+bool AssetArchive::Find(const char* path, Entry& out) const
+{
+	std::string name = NormalizeAssetPath(path);
+	auto it = std::lower_bound(entries_.begin(), entries_.end(), name, [](const IndexEntry& entry, const std::string& name)
+	{
+		return entry.Name < name;
+	});
+	if (it == entries_.end() || it->Name != name)
+	{
+		return false;
+	}
+	out = it->Contents;
+	return true;
+}
+
+bool AssetArchive::Contains(const char* path) const
+{
+	Entry entry;
+	return Find(path, entry);
+}
+
+Assimp::IOSystem* AssetArchive::CreateIOSystem() const
+{
+	return new ArchiveIOSystem(*this);
+}
+
+std::string NormalizeAssetPath(const char* path)
+{
+	std::string name;
+	for (const char* c = path; *c; c++)
+	{
+		char ch = (*c == '\\') ? '/' : (char)tolower((unsigned char)*c);
+
+		// Drop leading slashes, and any "./" (at the start, or after another slash)
+		if (ch == '/' && (name.empty() || name.back() == '/'))
+		{
+			continue;
+		}
+		if (ch == '.' && (name.empty() || name.back() == '/') && (c[1] == '/' || c[1] == '\\'))
+		{
+			c++;
+			continue;
+		}
+		name.push_back(ch);
+	}
+	return name;
+}
+
+bool PackAssetArchive(const char* archivePath, const std::vector<std::string>& files)
+{
+	struct Packed
+	{
+	public:
+		std::string Name;
+		std::vector<char> Contents;
+	};
+
+	std::vector<Packed> packed;
+	for (auto&& path : files)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "Skipping " << path << " - could not read it" << std::endl;
+			continue;
+		}
+
+		Packed p;
+		p.Name = NormalizeAssetPath(path.c_str());
+		p.Contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		packed.push_back(std::move(p));
+	}
+
+	std::sort(packed.begin(), packed.end(), [](const Packed& a, const Packed& b) { return a.Name < b.Name; });
+	packed.erase(std::unique(packed.begin(), packed.end(), [](const Packed& a, const Packed& b) { return a.Name == b.Name; }), packed.end());
+
+	// Table of contents first, then everything it points to
+	FileHeader header = {};
+	memcpy(header.Magic, Magic, sizeof(Magic));
+	header.Version = AssetArchive::Version;
+	header.EntryCount = (std::uint32_t)packed.size();
+
+	std::vector<FileEntry> entries(packed.size());
+	for (std::size_t i = 0u; i < packed.size(); i++)
+	{
+		entries[i].NameOffset = header.NameBytes;
+		entries[i].NameLength = (std::uint32_t)packed[i].Name.size();
+		header.NameBytes += entries[i].NameLength;
+	}
+
+	std::size_t offset = sizeof(FileHeader) + packed.size() * sizeof(FileEntry) + header.NameBytes;
+	for (std::size_t i = 0u; i < packed.size(); i++)
+	{
+		offset = AlignUp(offset);
+		entries[i].DataOffset = offset;
+		entries[i].Size = packed[i].Contents.size();
+		offset += packed[i].Contents.size();
+	}
+	header.FileSize = offset;
+
+	std::vector<std::uint8_t> bytes(offset, 0u);
+	memcpy(bytes.data(), &header, sizeof(header));
+	if (!entries.empty())
+	{
+		memcpy(bytes.data() + sizeof(header), entries.data(), entries.size() * sizeof(FileEntry));
+	}
+	std::size_t namesOffset = sizeof(FileHeader) + packed.size() * sizeof(FileEntry);
+	for (std::size_t i = 0u; i < packed.size(); i++)
+	{
+		memcpy(bytes.data() + namesOffset + entries[i].NameOffset, packed[i].Name.data(), packed[i].Name.size());
+		if (!packed[i].Contents.empty())
+		{
+			memcpy(bytes.data() + entries[i].DataOffset, packed[i].Contents.data(), packed[i].Contents.size());
+		}
+	}
+
+	// Same as a cooked model - written to the side and then moved into place, so nobody ever
+	//  maps a half written archive
+	std::string tempPath = std::string(archivePath) + ".tmp";
+	bool written = false;
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+		written = (bool)file;
+	}
+	std::remove(archivePath);
+	if (!written || std::rename(tempPath.c_str(), archivePath) != 0)
+	{
+		std::remove(tempPath.c_str());
+		std::cerr << "Could not write asset archive " << archivePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+// Every asset file in one, mapped into memory once.
+// Loose files mean opening each one on its own - Assimp through stdio (fopen, fread in little
+//  pieces, fseek around inside the file), LodePNG with fseek/ftell/fread into a buffer of its
+//  own - a pile of system calls and copies per file, all on a cold start where the disk is
+//  the slow part anyways. An archive is one file: a table of contents, then each file's bytes
+//  as they are. Opening it is mapping it (MappedFile.h), and after that:
+//  - Find hands out pointers straight into the mapping - no reads, no copies.
+//  - Assimp reads from it through CreateIOSystem, an Assimp::IOSystem whose streams are just
+//    memcpys out of the mapping. Anything the importer opens besides the file itself (an
+//    .mtl next to an .obj, say) comes out of the archive too.
+//  - LodePNG decodes straight from the mapped bytes.
+//  - Prefetch asks the OS for the whole thing at once, which is one big sequential read
+//    instead of page faults all over the place.
+//
+// Names are paths, compared after tidying them up a bit (see NormalizeAssetPath), so
+//  "./assets/road.fbx" and "assets\road.fbx" find the same file.
+// Like a cooked model, the format is the in-memory layout of the structures in
+//  AssetArchive.cc, and it doesn't know when the files it was made from change - delete it
+//  and pack it again for that.
+
+#include <MappedFile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Assimp
+{
+class IOSystem;
+};
+
+namespace sess
+{
+
+class AssetArchive
+{
+public:
+	static const std::uint32_t Version = 1u;
+
+	struct Entry
+	{
+	public:
+		const std::uint8_t* Data; // Points into the mapping - good for as long as the archive is open
+		std::size_t Size;
+	};
+
+public:
+	AssetArchive();
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+	~AssetArchive() = default;
+
+	// False if the file isn't there, or isn't an archive this code made
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const { return file_.Data() != nullptr; }
+
+	// False if there's no file by that name
+	bool Find(const char* path, Entry& out) const;
+	bool Contains(const char* path) const;
+
+	std::size_t EntryCount() const { return entries_.size(); }
+	void Prefetch() const { file_.Prefetch(); }
+
+	// For Assimp::Importer::SetIOHandler (which takes ownership of it). Reads only - opening
+	//  anything for writing fails. The archive has to stay open for as long as it's in use.
+	Assimp::IOSystem* CreateIOSystem() const;
+
+protected:
+	struct IndexEntry
+	{
+	public:
+		std::string Name;
+		Entry Contents;
+	};
+
+	MappedFile file_;
+	std::vector<IndexEntry> entries_; // Sorted by name
+};
+
+// Lower case, forward slashes, no "./" or leading slashes - what archive names look like
+std::string NormalizeAssetPath(const char* path);
+
+// Reads each of files and writes them all into one archive at archivePath. Files that can't
+//  be read are skipped (with a warning), so a list can name things that may not be there yet.
+//  False if the archive can't be written.
+bool PackAssetArchive(const char* archivePath, const std::vector<std::string>& files);
+
+};
@@ -0,0 +1,279 @@
+#include <AssetLoader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+
+namespace sess
+{
+
+AssetLoader::AssetLoader(std::size_t threadCount)
+	: start_(Clock::now())
+	, mutex_()
+	, workReady_()
+	, mainReady_()
+	, jobs_()
+	, workerQueue_()
+	, mainQueue_()
+	, unfinished_(0u)
+	, stopping_(false)
+	, helpers_()
+	, threads_()
+{
+	if (threadCount == 0u)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for (std::size_t i = 0u; i < threadCount; i++)
+	{
+		threads_.push_back(std::thread([this]() { WorkerLoop(); }));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	// A main thread job nobody ran would leave its future waiting forever (and any job that
+	//  depends on it with it), so those get run here if WaitAll never was
+	WaitAll();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	workReady_.notify_all();
+
+	for (auto&& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+std::size_t AssetLoader::ThreadCount() const
+{
+	return threads_.size();
+}
+
+AssetLoader::JobId AssetLoader::AddJob(const char* name, std::function<void()> run, std::initializer_list<JobId> dependsOn, JobThread thread)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	JobId id = (JobId)jobs_.size();
+	jobs_.push_back({ name, std::move(run), thread, 0u, {}, false, 0.0, 0.0 });
+
+	// Jobs can only depend on jobs that were added before them, so there's no way to make a loop
+	for (JobId dependency : dependsOn)
+	{
+		assert(dependency < id);
+		if (!jobs_[dependency].Done)
+		{
+			jobs_[id].WaitingOn++;
+			jobs_[dependency].Dependents.push_back(id);
+		}
+	}
+
+	unfinished_++;
+	if (jobs_[id].WaitingOn == 0u)
+	{
+		Enqueue(id);
+	}
+
+	return id;
+}
+
+void AssetLoader::Enqueue(JobId id)
+{
+	if (jobs_[id].Thread == MainThread)
+	{
+		mainQueue_.push_back(id);
+		mainReady_.notify_all();
+	}
+	else
+	{
+		workerQueue_.push_back(id);
+		workReady_.notify_one();
+	}
+}
+
+void AssetLoader::Finish(JobId id)
+{
+	jobs_[id].Done = true;
+	jobs_[id].EndMilliseconds = MillisecondsSinceStart();
+
+	// Anything that was only waiting on this one can go now. Copied, since Enqueue doesn't add
+	//  jobs but jobs_ is a vector, and I'd rather not hold a reference into it across calls.
+	std::vector<JobId> dependents = jobs_[id].Dependents;
+	for (JobId dependent : dependents)
+	{
+		if (--jobs_[dependent].WaitingOn == 0u)
+		{
+			Enqueue(dependent);
+		}
+	}
+
+	if (--unfinished_ == 0u)
+	{
+		mainReady_.notify_all();
+	}
+}
+
+void AssetLoader::RunJob(JobId id, std::unique_lock<std::mutex>& lock)
+{
+	// Moved out, because jobs_ can get reallocated by an Add while this runs
+	std::function<void()> run = std::move(jobs_[id].Run);
+	jobs_[id].StartMilliseconds = MillisecondsSinceStart();
+
+	lock.unlock();
+	run(); // A packaged_task - whatever gets thrown ends up in the future, not out here
+	lock.lock();
+
+	Finish(id);
+}
+
+void AssetLoader::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;)
+	{
+		workReady_.wait(lock, [this]() { return stopping_ || !helpers_.empty() || !workerQueue_.empty(); });
+
+		// ForEach items first - some thread is already sitting on those
+		if (!helpers_.empty())
+		{
+			std::function<void()> helper = std::move(helpers_.front());
+			helpers_.pop_front();
+			lock.unlock();
+			helper();
+			lock.lock();
+		}
+		else if (!workerQueue_.empty())
+		{
+			JobId id = workerQueue_.front();
+			workerQueue_.pop_front();
+			RunJob(id, lock);
+		}
+		else
+		{
+			return; // stopping_, and nothing left
+		}
+	}
+}
+
+void AssetLoader::ForEach(std::size_t count, const std::function<void(std::size_t)>& fn)
+{
+	// Same idea as ParallelFor - every thread grabs the next item nobody has started on.
+	//  The helpers can start late (or after this returns, if the workers are all busy with
+	//  other jobs), so what they share lives in a shared_ptr, and the only thing this waits
+	//  for is the items getting done - not the helpers.
+	struct State
+	{
+	public:
+		std::atomic<std::size_t> Next;
+		std::size_t Count;
+		const std::function<void(std::size_t)>* Fn;
+		std::mutex Mutex;
+		std::condition_variable AllDone;
+		std::size_t Done;
+	};
+	auto state = std::make_shared<State>();
+	state->Next = 0u;
+	state->Count = count;
+	state->Fn = &fn; // Only used while there are items left, which means this hasn't returned
+	state->Done = 0u;
+
+	auto work = [state]()
+	{
+		for (std::size_t i = state->Next++; i < state->Count; i = state->Next++)
+		{
+			(*state->Fn)(i);
+
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			if (++state->Done == state->Count)
+			{
+				state->AllDone.notify_all();
+			}
+		}
+	};
+
+	std::size_t helperCount = std::min(threads_.size(), count > 0u ? count - 1u : 0u);
+	if (helperCount > 0u)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (std::size_t i = 0u; i < helperCount; i++)
+		{
+			helpers_.push_back(work);
+		}
+		workReady_.notify_all();
+	}
+
+	// This thread is one of the workers too
+	work();
+
+	std::unique_lock<std::mutex> lock(state->Mutex);
+	state->AllDone.wait(lock, [&state]() { return state->Done == state->Count; });
+}
+
+std::function<void(std::size_t, const std::function<void(std::size_t)>&)> AssetLoader::ForEachFunction()
+{
+	return [this](std::size_t count, const std::function<void(std::size_t)>& fn)
+	{
+		ForEach(count, fn);
+	};
+}
+
+void AssetLoader::WaitAll()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (unfinished_ > 0u)
+	{
+		if (!mainQueue_.empty())
+		{
+			JobId id = mainQueue_.front();
+			mainQueue_.pop_front();
+			RunJob(id, lock);
+		}
+		else
+		{
+			mainReady_.wait(lock);
+		}
+	}
+}
+
+double AssetLoader::MillisecondsSinceStart() const
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+}
+
+void AssetLoader::Report(std::ostream& o) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	double total = 0.0;
+	double work = 0.0;
+	std::size_t done = 0u;
+	for (auto&& job : jobs_)
+	{
+		if (job.Done)
+		{
+			total = std::max(total, job.EndMilliseconds);
+			work += job.EndMilliseconds - job.StartMilliseconds;
+			done++;
+		}
+	}
+
+	char buffer[128];
+	snprintf(buffer, sizeof(buffer), "%.1f ms (%.1f ms of work, %.1fx)", total, work, total > 0.0 ? work / total : 1.0);
+	o << "Loaded " << done << " assets in " << buffer << std::endl;
+
+	for (auto&& job : jobs_)
+	{
+		if (job.Done)
+		{
+			snprintf(buffer, sizeof(buffer), "%8.1f ... %8.1f ms", job.StartMilliseconds, job.EndMilliseconds);
+			o << "  " << job.Name << (job.Thread == MainThread ? " (main thread)" : "") << ": " << buffer << std::endl;
+		}
+	}
+}
+
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+// Loading everything a demo needs at start up, all at once.
+// The demos used to load one thing after another on the main thread - import road.fbx, then
+//  import the man, then decode his texture - so start up took the sum of all of them, with
+//  every core but one sitting around. None of those depend on each other, so there's no
+//  reason for that. An AssetLoader runs each load as a job on a few worker threads:
+//  - Every job hands back a std::shared_future with whatever it made, same as the shaders'
+//    Initialize functions do.
+//  - A job can list other jobs it needs first (a model needs its texture), and it doesn't
+//    start until those are done - no worker thread ever sits blocked waiting on another job.
+//    By the time the job runs, .get() on any of their futures returns right away.
+//  - Some things can only happen on the thread that owns the device context (generating a
+//    texture's mip maps, for one). Jobs marked MainThread wait for WaitAll, and run on
+//    whichever thread calls it.
+//  - WaitAll waits for everything together, so start up takes as long as the longest chain
+//    of jobs that depend on each other, not the sum of everything.
+//
+//  AssetLoader loader;
+//  auto image = loader.Add("man-skin.png", [] { return DecodeImage("man-skin.png"); });
+//  auto texture = loader.Add("man-skin texture", [=] { return MakeTexture(image.Get()); }, { image.Job }, AssetLoader::MainThread);
+//  auto model = loader.Add("man", [=] { return LoadMan(texture.Get()); }, { texture.Job });
+//  loader.WaitAll();
+//  loader.Report(std::cout);
+//
+// Creating D3D buffers and textures on a worker is fine - ID3D11Device is free threaded
+//  (DemoApp doesn't create it with D3D11_CREATE_DEVICE_SINGLETHREADED). Only the
+//  ID3D11DeviceContext isn't.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sess
+{
+
+class AssetLoader
+{
+public:
+	typedef std::uint32_t JobId;
+
+	enum JobThread
+	{
+		Worker,     // Any of the worker threads
+		MainThread, // Whichever thread calls WaitAll
+	};
+
+	// The result of a job, and which job it is (for listing it as a dependency)
+	template <typename T>
+	struct Asset
+	{
+	public:
+		JobId Job;
+		std::shared_future<T> Future;
+
+	public:
+		const T& Get() const { return Future.get(); }
+	};
+
+public:
+	// 0 threads picks one per core
+	explicit AssetLoader(std::size_t threadCount = 0u);
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// Finishes every job that was added (main thread ones included) before stopping the workers
+	~AssetLoader();
+
+	// Starts work() once every job in dependsOn is done. Anything it throws comes back out of
+	//  .get() on its future, the same as std::async.
+	template <typename Fn>
+	auto Add(const char* name, Fn work, std::initializer_list<JobId> dependsOn = {}, JobThread thread = Worker)
+		-> Asset<decltype(work())>
+	{
+		typedef decltype(work()) T;
+		auto task = std::make_shared<std::packaged_task<T()>>(std::move(work));
+		Asset<T> asset;
+		asset.Future = task->get_future().share();
+		asset.Job = AddJob(name, [task]() { (*task)(); }, dependsOn, thread);
+		return asset;
+	}
+
+	// Runs fn(0) ... fn(count - 1) across the worker threads, with the calling thread helping,
+	//  and returns when they're all done. Fine to call from inside a job - the calling thread
+	//  can do every item itself if the other workers are busy, so it never waits on them to
+	//  get around to it. For things like converting each mesh of a scene. fn can't throw.
+	void ForEach(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+	// ForEach as a plain function, for code that takes a ForEachFn (see MeshConvert.h) and
+	//  shouldn't need to know about loaders. The loader has to outlive it.
+	std::function<void(std::size_t, const std::function<void(std::size_t)>&)> ForEachFunction();
+
+	// Runs main thread jobs as they come up until every job added so far is done
+	void WaitAll();
+
+	std::size_t ThreadCount() const;
+
+	// When each job ran, relative to when the loader was made, and how the total compares with
+	//  running everything one after the other:
+	//  "Loaded 5 assets in 412.3 ms (1180.6 ms of work, 2.9x)"
+	//  "  road.fbx:      0.2 ...    380.1 ms"
+	void Report(std::ostream& o) const;
+
+protected:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Job
+	{
+	public:
+		std::string Name;
+		std::function<void()> Run;
+		JobThread Thread;
+		std::size_t WaitingOn; // Dependencies that aren't done yet
+		std::vector<JobId> Dependents;
+		bool Done;
+		double StartMilliseconds;
+		double EndMilliseconds;
+	};
+
+	JobId AddJob(const char* name, std::function<void()> run, std::initializer_list<JobId> dependsOn, JobThread thread);
+
+	// Both with mutex_ held
+	void Enqueue(JobId id);
+	void Finish(JobId id);
+
+	void RunJob(JobId id, std::unique_lock<std::mutex>& lock);
+	void WorkerLoop();
+	double MillisecondsSinceStart() const;
+
+	Clock::time_point start_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable workReady_;   // Workers wait on this
+	std::condition_variable mainReady_;   // WaitAll waits on this - for main thread jobs, or everything being done
+	std::vector<Job> jobs_;
+	std::deque<JobId> workerQueue_;
+	std::deque<JobId> mainQueue_;
+	std::size_t unfinished_;
+	bool stopping_;
+
+	// Plain functions (ForEach's items) waiting for a worker - they don't go in jobs_
+	std::deque<std::function<void()>> helpers_;
+
+	std::vector<std::thread> threads_;
+};
+
+};
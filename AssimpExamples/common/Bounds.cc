@@ -0,0 +1,173 @@
+#include <Bounds.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace sess
+{
+
+//
+// AABB
+//
+AABB::AABB()
+	: Min(FLT_MAX, FLT_MAX, FLT_MAX)
+	, Max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+{}
+
+AABB::AABB(const Vec3& min, const Vec3& max)
+	: Min(min)
+	, Max(max)
+{}
+
+void AABB::Add(const Vec3& point)
+{
+	Min = Vec3(std::min(Min.x, point.x), std::min(Min.y, point.y), std::min(Min.z, point.z));
+	Max = Vec3(std::max(Max.x, point.x), std::max(Max.y, point.y), std::max(Max.z, point.z));
+}
+
+bool AABB::IsEmpty() const
+{
+	return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z;
+}
+
+Vec3 AABB::Center() const
+{
+	return (Min + Max) * 0.5f;
+}
+
+Vec3 AABB::Extent() const
+{
+	return (Max - Min) * 0.5f;
+}
+
+// Jim Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems (1990)
+// The center transforms like any other point. The new extent along each axis is how far
+//  the old extents reach along it, which is just the absolute values of the matrix.
+AABB AABB::Transformed(const Affine3x4& m) const
+{
+	if (IsEmpty())
+	{
+		return *this;
+	}
+
+	Vec3 c = Center();
+	Vec3 e = Extent();
+
+	Vec3 center = m.TransformPoint(c);
+	Vec3 extent(
+		fabsf(m.m[0][0]) * e.x + fabsf(m.m[0][1]) * e.y + fabsf(m.m[0][2]) * e.z,
+		fabsf(m.m[1][0]) * e.x + fabsf(m.m[1][1]) * e.y + fabsf(m.m[1][2]) * e.z,
+		fabsf(m.m[2][0]) * e.x + fabsf(m.m[2][1]) * e.y + fabsf(m.m[2][2]) * e.z);
+
+	return AABB(center - extent, center + extent);
+}
+
+// The first three storage rows of a column major matrix are an Affine3x4 already
+AABB AABB::Transformed(const Matrix& m) const
+{
+	return Transformed(Affine3x4(m));
+}
+
+//
+// BoundingSphere
+//
+BoundingSphere::BoundingSphere()
+	: Center(0.f, 0.f, 0.f)
+	, Radius(0.f)
+{}
+
+BoundingSphere::BoundingSphere(const Vec3& center, float radius)
+	: Center(center)
+	, Radius(radius)
+{}
+
+BoundingSphere BoundingSphere::FromAABB(const AABB& box)
+{
+	return BoundingSphere(box.Center(), box.Extent().Magnitude());
+}
+
+BoundingSphere BoundingSphere::Transformed(const Affine3x4& m) const
+{
+	Vec3 center = m.TransformPoint(Center);
+
+	// Rows of the 3x3 part are the scaled axes - the longest one is the biggest stretch
+	float scaleSq = std::max(
+		std::max(
+			m.At(0, 0) * m.At(0, 0) + m.At(0, 1) * m.At(0, 1) + m.At(0, 2) * m.At(0, 2),
+			m.At(1, 0) * m.At(1, 0) + m.At(1, 1) * m.At(1, 1) + m.At(1, 2) * m.At(1, 2)),
+		m.At(2, 0) * m.At(2, 0) + m.At(2, 1) * m.At(2, 1) + m.At(2, 2) * m.At(2, 2));
+
+	return BoundingSphere(center, Radius * sqrtf(scaleSq));
+}
+
+BoundingSphere BoundingSphere::Transformed(const Matrix& m) const
+{
+	return Transformed(Affine3x4(m));
+}
+
+//
+// AABBSoA
+//
+std::size_t AABBSoA::Size() const
+{
+	return Center.Size();
+}
+
+void AABBSoA::Reserve(std::size_t n)
+{
+	Center.Reserve(n);
+	Extent.Reserve(n);
+}
+
+void AABBSoA::Clear()
+{
+	Center.Clear();
+	Extent.Clear();
+}
+
+void AABBSoA::PushBack(const AABB& box)
+{
+	Center.PushBack(box.Center());
+	Extent.PushBack(box.Extent());
+}
+
+void AABBSoA::Set(std::size_t idx, const AABB& box)
+{
+	Center.Set(idx, box.Center());
+	Extent.Set(idx, box.Extent());
+}
+
+//
+// BoundingSphereSoA
+//
+std::size_t BoundingSphereSoA::Size() const
+{
+	return Radius.size();
+}
+
+void BoundingSphereSoA::Reserve(std::size_t n)
+{
+	Center.Reserve(n);
+	Radius.reserve(n);
+}
+
+void BoundingSphereSoA::Clear()
+{
+	Center.Clear();
+	Radius.clear();
+}
+
+void BoundingSphereSoA::PushBack(const BoundingSphere& sphere)
+{
+	Center.PushBack(sphere.Center);
+	Radius.push_back(sphere.Radius);
+}
+
+void BoundingSphereSoA::Set(std::size_t idx, const BoundingSphere& sphere)
+{
+	Center.Set(idx, sphere.Center);
+	Radius[idx] = sphere.Radius;
+}
+
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+// Bounding volumes - cheap shapes that are guaranteed to contain a whole mesh.
+// Testing a box or a sphere against the camera is a handful of multiplies, and if the
+//  box can't be seen then nothing inside of it can be either, so the mesh can be skipped.
+// Both come in a plain version and a structure-of-arrays version (see TransformSoA.h)
+//  for testing lots of them at once - see Frustum.h.
+
+#include <TransformSoA.h>
+#include <Affine3x4.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace sess
+{
+
+// Axis aligned bounding box
+struct AABB
+{
+public:
+	Vec3 Min, Max;
+
+public:
+	// Empty box (Min > Max), adding any point to it gives a box around just that point
+	AABB();
+	AABB(const Vec3& min, const Vec3& max);
+	AABB(const AABB&) = default;
+	~AABB() = default;
+
+	// Grow the box to contain the given point
+	void Add(const Vec3& point);
+
+	bool IsEmpty() const;
+	Vec3 Center() const;
+	Vec3 Extent() const; // Half size along each axis
+
+	// Box around this box after transforming it by m, a model matrix - either an affine one
+	//  (Transform::GetAffineMatrix, TransformHierarchy world matrices) or a full one in the
+	//  default (column major) layout, with 0 0 0 1 as the last column.
+	// The result is usually a bit bigger than it needs to be once rotation is involved,
+	//  but it's always big enough.
+	AABB Transformed(const Affine3x4& m) const;
+	AABB Transformed(const Matrix& m) const;
+};
+
+struct BoundingSphere
+{
+public:
+	Vec3 Center;
+	float Radius;
+
+public:
+	BoundingSphere();
+	BoundingSphere(const Vec3& center, float radius);
+	BoundingSphere(const BoundingSphere&) = default;
+	~BoundingSphere() = default;
+
+	static BoundingSphere FromAABB(const AABB& box);
+
+	// Same matrices as AABB::Transformed. The radius grows by the largest scale in m.
+	BoundingSphere Transformed(const Affine3x4& m) const;
+	BoundingSphere Transformed(const Matrix& m) const;
+};
+
+// Boxes are stored as center/extent instead of min/max - that's the form the frustum
+//  test wants, so it doesn't have to be recomputed every frame.
+struct AABBSoA
+{
+public:
+	Vec3SoA Center;
+	Vec3SoA Extent;
+
+public:
+	std::size_t Size() const;
+	void Reserve(std::size_t n);
+	void Clear();
+	void PushBack(const AABB& box);
+	void Set(std::size_t idx, const AABB& box);
+};
+
+struct BoundingSphereSoA
+{
+public:
+	Vec3SoA Center;
+	std::vector<float> Radius;
+
+public:
+	std::size_t Size() const;
+	void Reserve(std::size_t n);
+	void Clear();
+	void PushBack(const BoundingSphere& sphere);
+	void Set(std::size_t idx, const BoundingSphere& sphere);
+};
+
+};
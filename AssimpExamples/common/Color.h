@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cmath>
 #include <cstdint>
 
 // Utility class for dealing with colors
 // Simplified down version of what I've taken to using in demos/games - only includes
 //  methods that are used in this tutorial series
+// This is for one color at a time (materials, lights) - for whole arrays of pixels, see
+//  the batch conversions in ColorConvert.h
 
 namespace sess
 {
@@ -12,21 +15,24 @@ namespace sess
 class Color
 {
 public:
-	Color(float r, float g, float b, float a);
+	constexpr Color(float r, float g, float b, float a) : _r(r), _g(g), _b(b), _a(a) {}
 	Color(const Color&) = default;
 	~Color() = default;
 
 	// Two reasons for using std::uint8_t instead of the alternative (unsigned char):
 	//  (1) Avoid association (especially with beginners) to strings
 	//  (2) More clear that I'm using the type for number of bits instead of other properties
-	static Color fromHex(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a);
+	static constexpr Color fromHex(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a)
+	{
+		return Color(r / 255.f, g / 255.f, b / 255.f, a / 255.f);
+	}
 
 	void packAsFloatArray(float* out) const;
 
 	// Scale the color by a given factor, but clamp at 1.0 max and 0.0 min
 	Color clampAndScale(float factor) const;
 
-	Color withAlpha(float alpha) const;
+	constexpr Color withAlpha(float alpha) const { return Color(_r, _g, _b, alpha); }
 
 	// Color palette: I just messed with values on https://coolors.co
 	//  until I found https://coolors.co/151515-4b0082-a63d40-402e2a-e9b872
@@ -48,4 +54,24 @@ protected:
 	float _r, _g, _b, _a;
 };
 
+// Take advantage of the packing of class data
+inline void Color::packAsFloatArray(float* out) const
+{
+	out[0] = _r;
+	out[1] = _g;
+	out[2] = _b;
+	out[3] = _a;
+}
+
+inline Color Color::clampAndScale(float factor) const
+{
+	return Color
+	(
+		fmaxf(fminf(_r * factor, 1.f), 0.f),
+		fmaxf(fminf(_g * factor, 1.f), 0.f),
+		fmaxf(fminf(_b * factor, 1.f), 0.f),
+		fmaxf(fminf(_a * factor, 1.f), 0.f)
+	);
+}
+
 };
\ No newline at end of file
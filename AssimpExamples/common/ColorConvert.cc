@@ -0,0 +1,305 @@
+#include <ColorConvert.h>
+#include <Quantize.h>
+#include <Simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sess
+{
+
+namespace
+{
+
+//
+// sRGB tables
+//
+// Decoding is easy - there are only 256 possible bytes, so look up all of them.
+// Encoding goes the other way, from a float, which is harder to index. The trick is that
+//  the bits of a positive float sort the same way as its value, and the top bits are the
+//  exponent and the first few bits of the mantissa. So
+//   (bits(x) - bits(smallest x worth encoding)) >> 15
+//  splits 2^-13 ... 1 into buckets, 256 per power of two, and each bucket is narrow enough
+//  that the sRGB byte changes at most once inside of it. The table holds the byte at the
+//  bottom of each bucket, and where in the bucket (the low 15 bits) it goes up by one - so
+//  one lookup and one integer compare per channel. Exact, and 13kB of table.
+// Anything below 2^-13 encodes to 0 anyways (12.92 * 2^-13 * 255 = 0.4).
+const std::uint32_t MinLinearBits = 0x39000000u; // 2^-13
+const std::uint32_t MaxLinearBits = 0x3F7FFFFFu; // The largest float below 1
+const int BucketShift = 15; // Keeps 8 bits of mantissa
+const std::uint32_t InBucketMask = (1u << BucketShift) - 1u;
+const std::size_t BucketCount = ((0x3F800000u - MinLinearBits) >> BucketShift);
+
+float FromBits(std::uint32_t bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// The reference curves, in double precision
+double SrgbToLinearExact(double s)
+{
+	return s <= 0.04045 ? s / 12.92 : pow((s + 0.055) / 1.055, 2.4);
+}
+
+double LinearToSrgbExact(double l)
+{
+	return l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1. / 2.4) - 0.055;
+}
+
+int EncodeExact(float linear)
+{
+	double s = LinearToSrgbExact(std::min(std::max((double)linear, 0.), 1.));
+	return (int)floor(s * 255. + 0.5);
+}
+
+struct SrgbTables
+{
+public:
+	float ToLinear[256];
+	float UnormToFloat[256];
+	std::uint16_t ToLinearHalf[256];
+	std::uint16_t UnormToHalf[256];
+
+	// (byte at the bottom of the bucket << 16) | (low bits of the first float that encodes
+	//  to one more than that). If the byte doesn't change in the bucket, the low part is
+	//  1 << BucketShift, which no float in the bucket reaches.
+	std::uint32_t Buckets[BucketCount];
+
+public:
+	SrgbTables()
+	{
+		for (int b = 0; b < 256; b++)
+		{
+			ToLinear[b] = (float)SrgbToLinearExact(b / 255.);
+			UnormToFloat[b] = b / 255.f;
+			ToLinearHalf[b] = FloatToHalf(ToLinear[b]);
+			UnormToHalf[b] = FloatToHalf(UnormToFloat[b]);
+		}
+
+		// Start from the inverse of the curve halfway between two bytes, then walk to the
+		//  exact float where the encoded byte changes, one float at a time
+		std::uint32_t roundUpAt[256];
+		for (int b = 0; b < 255; b++)
+		{
+			float f = (float)SrgbToLinearExact((b + 0.5) / 255.);
+			while (EncodeExact(f) > b)
+			{
+				f = nextafterf(f, 0.f);
+			}
+			while (EncodeExact(f) <= b)
+			{
+				f = nextafterf(f, 2.f);
+			}
+			memcpy(&roundUpAt[b], &f, sizeof(f));
+		}
+		roundUpAt[255] = 0x7F800000u; // Nothing after 255, and everything is clamped below 1
+
+		std::uint32_t b = 0u;
+		for (std::size_t i = 0u; i < BucketCount; i++)
+		{
+			std::uint32_t bottom = MinLinearBits + ((std::uint32_t)i << BucketShift);
+			while (bottom >= roundUpAt[b])
+			{
+				b++;
+			}
+			std::uint32_t next = roundUpAt[b] - bottom;
+			Buckets[i] = (b << 16) | (next <= InBucketMask ? next : InBucketMask + 1u);
+		}
+	}
+};
+
+const SrgbTables& Tables()
+{
+	static const SrgbTables tables;
+	return tables;
+}
+
+// bits is a float already clamped to [MinLinear, MaxLinear], minus MinLinearBits
+inline std::uint8_t EncodeOffset(const SrgbTables& t, std::uint32_t bits)
+{
+	std::uint32_t bucket = t.Buckets[bits >> BucketShift];
+	return (std::uint8_t)((bucket >> 16) + ((bits & InBucketMask) >= (bucket & 0xFFFFu) ? 1u : 0u));
+}
+
+inline std::uint8_t Encode(const SrgbTables& t, float linear)
+{
+	// Written so that NaN fails both compares and ends up at the bottom
+	const float minLinear = FromBits(MinLinearBits), maxLinear = FromBits(MaxLinearBits);
+	float x = linear > minLinear ? linear : minLinear;
+	x = x < maxLinear ? x : maxLinear;
+
+	std::uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	return EncodeOffset(t, bits - MinLinearBits);
+}
+
+#if defined(SESS_SIMD_SSE)
+// Clamp to 0-1 (max before min, so NaN becomes 0 like the scalar version), then
+//  x * 255 + 0.5 truncated - round to nearest, done the same way as the scalar code
+inline __m128i ToUnorm8Lanes(__m128 v)
+{
+	v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+	return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+}
+#endif
+
+};
+
+std::uint8_t FloatToUnorm8(float f)
+{
+	f = f > 0.f ? f : 0.f;
+	f = f < 1.f ? f : 1.f;
+	return (std::uint8_t)(f * 255.f + 0.5f);
+}
+
+float Unorm8ToFloat(std::uint8_t b)
+{
+	return b / 255.f;
+}
+
+std::uint8_t LinearToSrgb8(float linear)
+{
+	return Encode(Tables(), linear);
+}
+
+float Srgb8ToLinear(std::uint8_t b)
+{
+	return Tables().ToLinear[b];
+}
+
+void FloatToUnorm8Many(const float* in, std::uint8_t* out, std::size_t n)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	// Sixteen channels at a time - four registers of floats pack down into one of bytes
+	for (; i + 16u <= n; i += 16u)
+	{
+		__m128i c0 = ToUnorm8Lanes(_mm_loadu_ps(in + i));
+		__m128i c1 = ToUnorm8Lanes(_mm_loadu_ps(in + i + 4u));
+		__m128i c2 = ToUnorm8Lanes(_mm_loadu_ps(in + i + 8u));
+		__m128i c3 = ToUnorm8Lanes(_mm_loadu_ps(in + i + 12u));
+		__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		out[i] = FloatToUnorm8(in[i]);
+	}
+}
+
+void Unorm8ToFloatMany(const std::uint8_t* in, float* out, std::size_t n)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	// Widen 16 bytes to four registers of ints, then convert. A real divide rather than
+	//  multiplying by 1/255, so the results are the same as b / 255.f.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(255.f);
+	for (; i + 16u <= n; i += 16u)
+	{
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+		__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+		_mm_storeu_ps(out + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+		_mm_storeu_ps(out + i + 4u, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+		_mm_storeu_ps(out + i + 8u, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+		_mm_storeu_ps(out + i + 12u, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		out[i] = Unorm8ToFloat(in[i]);
+	}
+}
+
+void LinearToSrgb8Many(const float* rgba, std::uint8_t* out, std::size_t n)
+{
+	const SrgbTables& t = Tables();
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	// SSE2 can't do the table lookups (no gathers), but it can do everything around them.
+	//  Four pixels at a time: clamping and offsets for all sixteen channels, and the alpha
+	//  channels as plain unorm - then the lookups one channel at a time.
+	const __m128 minLinear = _mm_set1_ps(FromBits(MinLinearBits));
+	const __m128 maxLinear = _mm_set1_ps(FromBits(MaxLinearBits));
+	const __m128i minBits = _mm_set1_epi32((int)MinLinearBits);
+	for (; i + 4u <= n; i += 4u)
+	{
+		std::uint32_t offsets[16];
+		std::int32_t alpha[4];
+		for (int p = 0; p < 4; p++)
+		{
+			__m128 v = _mm_loadu_ps(rgba + (i + p) * 4u);
+			__m128 clamped = _mm_min_ps(_mm_max_ps(v, minLinear), maxLinear);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(offsets + p * 4), _mm_sub_epi32(_mm_castps_si128(clamped), minBits));
+			alpha[p] = _mm_cvtsi128_si32(_mm_shuffle_epi32(ToUnorm8Lanes(v), _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+
+		std::uint8_t* o = out + i * 4u;
+		for (int p = 0; p < 4; p++)
+		{
+			o[p * 4 + 0] = EncodeOffset(t, offsets[p * 4 + 0]);
+			o[p * 4 + 1] = EncodeOffset(t, offsets[p * 4 + 1]);
+			o[p * 4 + 2] = EncodeOffset(t, offsets[p * 4 + 2]);
+			o[p * 4 + 3] = (std::uint8_t)alpha[p];
+		}
+	}
+#endif
+	for (; i < n; i++)
+	{
+		const float* p = rgba + i * 4u;
+		std::uint8_t* o = out + i * 4u;
+		o[0] = Encode(t, p[0]);
+		o[1] = Encode(t, p[1]);
+		o[2] = Encode(t, p[2]);
+		o[3] = FloatToUnorm8(p[3]);
+	}
+}
+
+void Srgb8ToLinearMany(const std::uint8_t* rgba, float* out, std::size_t n)
+{
+	const SrgbTables& t = Tables();
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		const std::uint8_t* p = rgba + i * 4u;
+		float* o = out + i * 4u;
+		o[0] = t.ToLinear[p[0]];
+		o[1] = t.ToLinear[p[1]];
+		o[2] = t.ToLinear[p[2]];
+		o[3] = t.UnormToFloat[p[3]];
+	}
+}
+
+void Srgb8ToLinearHalfMany(const std::uint8_t* rgba, std::uint16_t* out, std::size_t n)
+{
+	// Straight from the bytes to halves - there's never a float in between
+	const SrgbTables& t = Tables();
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		const std::uint8_t* p = rgba + i * 4u;
+		std::uint16_t* o = out + i * 4u;
+		o[0] = t.ToLinearHalf[p[0]];
+		o[1] = t.ToLinearHalf[p[1]];
+		o[2] = t.ToLinearHalf[p[2]];
+		o[3] = t.UnormToHalf[p[3]];
+	}
+}
+
+void LinearHalfToSrgb8Many(const std::uint16_t* rgba, std::uint8_t* out, std::size_t n)
+{
+	// Through floats, a chunk at a time so the floats never leave L1
+	const std::size_t Chunk = 256u;
+	float linear[Chunk * 4u];
+	for (std::size_t i = 0u; i < n; i += Chunk)
+	{
+		std::size_t count = std::min(Chunk, n - i);
+		HalfToFloatMany(rgba + i * 4u, linear, count * 4u);
+		LinearToSrgb8Many(linear, out + i * 4u, count);
+	}
+}
+
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+// Batch conversions between the usual ways of storing a color channel:
+//  float   - linear, 0 to 1 (what Color holds, and what lighting math wants)
+//  unorm8  - one byte, 0 to 255 standing for 0 to 1 (DXGI_FORMAT_R8G8B8A8_UNORM, PNGs)
+//  srgb8   - one byte, but gamma encoded - the byte is sRGB(linear) * 255. Most textures
+//            that are meant to be looked at (colors, not normals) are stored like this,
+//            and DXGI_FORMAT_R8G8B8A8_UNORM_SRGB decodes it on the GPU.
+//  half    - 16 bit float (see Quantize.h), linear. For HDR and for cooked textures.
+// Color::fromHex is fine for a palette, but one call at a time is no way to get through a
+//  2048x2048 texture - these work on whole arrays.
+//
+// Component functions work on n channels of any layout. Pixel functions work on n RGBA
+//  pixels (4n channels) - sRGB only encodes red, green and blue, alpha is always linear.
+//
+// Rounding: float -> byte rounds to nearest and clamps to 0-1 first (NaN turns into 0).
+//  LinearToSrgb8Many gives exactly the byte that rounding sRGB(x) * 255 in double precision
+//  gives - it's a table lookup, not an approximation of the curve.
+// The SIMD paths give the same results as the scalar ones.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sess
+{
+
+// Single channels
+std::uint8_t FloatToUnorm8(float f);
+float Unorm8ToFloat(std::uint8_t b);
+std::uint8_t LinearToSrgb8(float linear);
+float Srgb8ToLinear(std::uint8_t b);
+
+// Any number of channels
+void FloatToUnorm8Many(const float* in, std::uint8_t* out, std::size_t n);
+void Unorm8ToFloatMany(const std::uint8_t* in, float* out, std::size_t n);
+
+// n RGBA pixels
+void LinearToSrgb8Many(const float* rgba, std::uint8_t* out, std::size_t n);
+void Srgb8ToLinearMany(const std::uint8_t* rgba, float* out, std::size_t n);
+
+// n RGBA pixels, sRGB bytes straight to linear half floats and back - texture cooking
+//  (an sRGB PNG into an R16G16B16A16_FLOAT texture) and HDR render output
+void Srgb8ToLinearHalfMany(const std::uint8_t* rgba, std::uint16_t* out, std::size_t n);
+void LinearHalfToSrgb8Many(const std::uint16_t* rgba, std::uint8_t* out, std::size_t n);
+
+};
@@ -0,0 +1,451 @@
+#include <CompactVertex.h>
+#include <Simd.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace sess
+{
+
+static_assert(sizeof(CompactVertex) == 12u, "CompactVertex should have no padding");
+static_assert(sizeof(CompactTexturedVertex) == 16u, "CompactTexturedVertex should have no padding");
+static_assert(sizeof(CompactVertexDecode) == 48u, "CompactVertexDecode goes into a constant buffer as three float4s");
+
+namespace
+{
+
+const float UnormMax = 65535.f;
+const float SnormMax = 32767.f;
+
+// Everything the encoder needs to know about one mesh, worked out once up front
+struct EncodeParams
+{
+public:
+	float PositionMin[3];
+	float PositionToUnorm[3]; // 65535 / box size, or 0 for a box that's flat on that axis
+	float UVMin[2];
+	float UVToUnorm[2];
+};
+
+const float* FloatsAt(const std::uint8_t* vertex, std::size_t offset)
+{
+	return reinterpret_cast<const float*>(vertex + offset);
+}
+
+float ToUnorm(float v, float min, float toUnorm)
+{
+	return std::min(std::max((v - min) * toUnorm, 0.f), UnormMax);
+}
+
+// Rounds to nearest even, like _mm_cvtps_epi32 does by default - so both paths agree exactly
+std::int32_t Round(float v)
+{
+	return (std::int32_t)std::nearbyint(v);
+}
+
+// Onto the octahedron, bottom half folded over the top. A zero vector (a mesh without
+//  normals) comes out as 0, 0, which decodes as +Z.
+void OctahedralEncode(float x, float y, float z, float& ox, float& oy)
+{
+	float l1 = fabsf(x) + fabsf(y) + fabsf(z);
+	float inv = l1 > 0.f ? 1.f / l1 : 0.f;
+	ox = x * inv;
+	oy = y * inv;
+	if (z < 0.f)
+	{
+		float fx = (1.f - fabsf(oy)) * copysignf(1.f, ox);
+		float fy = (1.f - fabsf(ox)) * copysignf(1.f, oy);
+		ox = fx;
+		oy = fy;
+	}
+}
+
+float ToSnorm(float v)
+{
+	return std::min(std::max(v, -1.f), 1.f) * SnormMax;
+}
+
+void SetPosition(std::uint16_t* out, std::int32_t x, std::int32_t y, std::int32_t z)
+{
+	out[0] = (std::uint16_t)x;
+	out[1] = (std::uint16_t)y;
+	out[2] = (std::uint16_t)z;
+	out[3] = 0xFFFFu;
+}
+
+void SetUV(CompactVertex&, std::int32_t, std::int32_t) {}
+void SetUV(CompactTexturedVertex& v, std::int32_t u, std::int32_t w)
+{
+	v.UV[0] = (std::uint16_t)u;
+	v.UV[1] = (std::uint16_t)w;
+}
+
+bool HasUV(const CompactVertex*) { return false; }
+bool HasUV(const CompactTexturedVertex*) { return true; }
+
+const std::uint16_t* UVOf(const CompactVertex&) { return nullptr; }
+const std::uint16_t* UVOf(const CompactTexturedVertex& v) { return v.UV; }
+
+template <typename Compact>
+void EncodeOne(const std::uint8_t* in, const MeshVertexLayout& layout, const EncodeParams& p, bool uvs, Compact& out)
+{
+	const float* position = FloatsAt(in, layout.PositionOffset);
+	SetPosition(out.Position,
+		Round(ToUnorm(position[0], p.PositionMin[0], p.PositionToUnorm[0])),
+		Round(ToUnorm(position[1], p.PositionMin[1], p.PositionToUnorm[1])),
+		Round(ToUnorm(position[2], p.PositionMin[2], p.PositionToUnorm[2])));
+
+	float ox = 0.f, oy = 0.f;
+	if (layout.NormalOffset != MeshVertexLayout::NoAttribute)
+	{
+		const float* normal = FloatsAt(in, layout.NormalOffset);
+		OctahedralEncode(normal[0], normal[1], normal[2], ox, oy);
+	}
+	out.Normal[0] = (std::int16_t)Round(ToSnorm(ox));
+	out.Normal[1] = (std::int16_t)Round(ToSnorm(oy));
+
+	if (uvs)
+	{
+		const float* uv = FloatsAt(in, layout.UVOffset);
+		SetUV(out, Round(ToUnorm(uv[0], p.UVMin[0], p.UVToUnorm[0])), Round(ToUnorm(uv[1], p.UVMin[1], p.UVToUnorm[1])));
+	}
+	else
+	{
+		SetUV(out, 0, 0);
+	}
+}
+
+#if defined(SESS_SIMD_SSE)
+// x y z into the first three lanes, without reading the float after them
+__m128 Load3(const float* p)
+{
+	return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)), _mm_load_ss(p + 2));
+}
+
+__m128 Load2(const float* p)
+{
+	return _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p));
+}
+
+__m128 ToUnorm4(__m128 v, float min, float toUnorm)
+{
+	__m128 t = _mm_mul_ps(_mm_sub_ps(v, _mm_set1_ps(min)), _mm_set1_ps(toUnorm));
+	return _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(UnormMax));
+}
+
+// copysignf(1, v) for four lanes
+__m128 Sign4(__m128 v)
+{
+	return _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.f)), _mm_set1_ps(1.f));
+}
+
+__m128 Abs4(__m128 v)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+}
+
+// Two int32x4 of 0...65535 into one uint16x8. SSE2's only 32 -> 16 pack saturates to signed,
+//  so shift down into the signed range and back up afterwards (like NarrowIndices).
+__m128i PackUnorm(__m128i a, __m128i b)
+{
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), _mm_set1_epi16((short)0x8000));
+}
+
+// a0 a1 a2 a3 b0 b1 b2 b3 -> a0 b0 a1 b1 a2 b2 a3 b3
+__m128i Interleave(__m128i ab)
+{
+	return _mm_unpacklo_epi16(ab, _mm_srli_si128(ab, 8));
+}
+
+// One whole vertex is in the low 12 bytes - the last four (UV) don't belong to it
+void StoreVertex(CompactVertex* out, __m128i v)
+{
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(out->Position), v);
+	std::int32_t normal = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+	memcpy(out->Normal, &normal, sizeof(normal));
+}
+
+void StoreVertex(CompactTexturedVertex* out, __m128i v)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+}
+
+// Four vertices at a time - gathered and transposed so each register holds one component of
+//  all four, then the same math as the scalar path, lane for lane
+template <typename Compact>
+std::size_t EncodeSse(const std::uint8_t* in, const MeshVertexLayout& layout, const EncodeParams& p, std::size_t n, Compact* out)
+{
+	const bool normals = layout.NormalOffset != MeshVertexLayout::NoAttribute;
+	const bool uvs = HasUV(out) && layout.UVOffset != MeshVertexLayout::NoAttribute;
+	const std::size_t stride = layout.Stride;
+
+	std::size_t i = 0u;
+	for (; i + 4u <= n; i += 4u)
+	{
+		const std::uint8_t* v = in + i * stride;
+
+		__m128 px = Load3(FloatsAt(v, layout.PositionOffset));
+		__m128 py = Load3(FloatsAt(v + stride, layout.PositionOffset));
+		__m128 pz = Load3(FloatsAt(v + 2u * stride, layout.PositionOffset));
+		__m128 pw = Load3(FloatsAt(v + 3u * stride, layout.PositionOffset));
+		_MM_TRANSPOSE4_PS(px, py, pz, pw);
+		__m128i qx = _mm_cvtps_epi32(ToUnorm4(px, p.PositionMin[0], p.PositionToUnorm[0]));
+		__m128i qy = _mm_cvtps_epi32(ToUnorm4(py, p.PositionMin[1], p.PositionToUnorm[1]));
+		__m128i qz = _mm_cvtps_epi32(ToUnorm4(pz, p.PositionMin[2], p.PositionToUnorm[2]));
+
+		__m128 ox = _mm_setzero_ps();
+		__m128 oy = _mm_setzero_ps();
+		if (normals)
+		{
+			__m128 nx = Load3(FloatsAt(v, layout.NormalOffset));
+			__m128 ny = Load3(FloatsAt(v + stride, layout.NormalOffset));
+			__m128 nz = Load3(FloatsAt(v + 2u * stride, layout.NormalOffset));
+			__m128 nw = Load3(FloatsAt(v + 3u * stride, layout.NormalOffset));
+			_MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+
+			__m128 l1 = _mm_add_ps(_mm_add_ps(Abs4(nx), Abs4(ny)), Abs4(nz));
+			__m128 inv = _mm_and_ps(_mm_cmpgt_ps(l1, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1.f), l1));
+			ox = _mm_mul_ps(nx, inv);
+			oy = _mm_mul_ps(ny, inv);
+			__m128 fx = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.f), Abs4(oy)), Sign4(ox));
+			__m128 fy = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.f), Abs4(ox)), Sign4(oy));
+			__m128 below = _mm_cmplt_ps(nz, _mm_setzero_ps());
+			ox = _mm_or_ps(_mm_and_ps(below, fx), _mm_andnot_ps(below, ox));
+			oy = _mm_or_ps(_mm_and_ps(below, fy), _mm_andnot_ps(below, oy));
+		}
+		__m128 one = _mm_set1_ps(1.f);
+		__m128 minusOne = _mm_set1_ps(-1.f);
+		__m128 snorm = _mm_set1_ps(SnormMax);
+		__m128i qnx = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(ox, minusOne), one), snorm));
+		__m128i qny = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(oy, minusOne), one), snorm));
+
+		__m128i qu = _mm_setzero_si128();
+		__m128i qv = _mm_setzero_si128();
+
+		if (uvs)
+		{
+			__m128 a = _mm_movelh_ps(Load2(FloatsAt(v, layout.UVOffset)), Load2(FloatsAt(v + stride, layout.UVOffset)));
+			__m128 b = _mm_movelh_ps(Load2(FloatsAt(v + 2u * stride, layout.UVOffset)), Load2(FloatsAt(v + 3u * stride, layout.UVOffset)));
+			__m128 u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 w = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+			qu = _mm_cvtps_epi32(ToUnorm4(u, p.UVMin[0], p.UVToUnorm[0]));
+			qv = _mm_cvtps_epi32(ToUnorm4(w, p.UVMin[1], p.UVToUnorm[1]));
+		}
+
+		// Back from one component per register to one vertex per register: pairs of
+		//  components first (x y, z 65535, normal, u v), then pairs of pairs
+		__m128i xy = Interleave(PackUnorm(qx, qy));
+		__m128i zw = Interleave(PackUnorm(qz, _mm_set1_epi32(0xFFFF)));
+		__m128i normal = Interleave(_mm_packs_epi32(qnx, qny));
+		__m128i uv = Interleave(PackUnorm(qu, qv));
+		__m128i position01 = _mm_unpacklo_epi32(xy, zw);
+		__m128i position23 = _mm_unpackhi_epi32(xy, zw);
+		__m128i rest01 = _mm_unpacklo_epi32(normal, uv);
+		__m128i rest23 = _mm_unpackhi_epi32(normal, uv);
+		StoreVertex(out + i, _mm_unpacklo_epi64(position01, rest01));
+		StoreVertex(out + i + 1u, _mm_unpackhi_epi64(position01, rest01));
+		StoreVertex(out + i + 2u, _mm_unpacklo_epi64(position23, rest23));
+		StoreVertex(out + i + 3u, _mm_unpackhi_epi64(position23, rest23));
+	}
+	return i;
+}
+#endif
+
+template <typename Compact>
+CompactVertexDecode Encode(const void* vertices, const MeshVertexLayout& layout, std::size_t n, const AABB& bounds, Compact* out)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(vertices);
+	const bool uvs = HasUV(out) && layout.UVOffset != MeshVertexLayout::NoAttribute;
+
+	CompactVertexDecode decode = {};
+	decode.PositionScale[3] = 1.f;
+	decode.UVScaleOffset[0] = 1.f;
+	decode.UVScaleOffset[1] = 1.f;
+	if (n == 0u)
+	{
+		return decode;
+	}
+
+	EncodeParams p = {};
+	const float min[3] = { bounds.Min.x, bounds.Min.y, bounds.Min.z };
+	const float max[3] = { bounds.Max.x, bounds.Max.y, bounds.Max.z };
+	for (std::size_t c = 0u; c < 3u; c++)
+	{
+		float size = max[c] - min[c];
+		p.PositionMin[c] = min[c];
+		p.PositionToUnorm[c] = size > 0.f ? UnormMax / size : 0.f;
+		decode.PositionScale[c] = size / UnormMax;
+		decode.PositionOffset[c] = min[c];
+	}
+
+	// UVs don't come with a box of their own
+	if (uvs)
+	{
+		float uvMin[2] = { FLT_MAX, FLT_MAX };
+		float uvMax[2] = { -FLT_MAX, -FLT_MAX };
+#if defined(SESS_SIMD_SSE)
+		__m128 lo = _mm_set1_ps(FLT_MAX);
+		__m128 hi = _mm_set1_ps(-FLT_MAX);
+		for (std::size_t i = 0u; i < n; i++)
+		{
+			__m128 uv = Load2(FloatsAt(in + i * layout.Stride, layout.UVOffset));
+			lo = _mm_min_ps(lo, uv);
+			hi = _mm_max_ps(hi, uv);
+		}
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, lo);
+		uvMin[0] = lanes[0];
+		uvMin[1] = lanes[1];
+		_mm_store_ps(lanes, hi);
+		uvMax[0] = lanes[0];
+		uvMax[1] = lanes[1];
+#else
+		for (std::size_t i = 0u; i < n; i++)
+		{
+			const float* uv = FloatsAt(in + i * layout.Stride, layout.UVOffset);
+			uvMin[0] = std::min(uvMin[0], uv[0]);
+			uvMin[1] = std::min(uvMin[1], uv[1]);
+			uvMax[0] = std::max(uvMax[0], uv[0]);
+			uvMax[1] = std::max(uvMax[1], uv[1]);
+		}
+#endif
+		for (std::size_t c = 0u; c < 2u; c++)
+		{
+			float size = uvMax[c] - uvMin[c];
+			p.UVMin[c] = uvMin[c];
+			p.UVToUnorm[c] = size > 0.f ? UnormMax / size : 0.f;
+			decode.UVScaleOffset[c] = size / UnormMax;
+			decode.UVScaleOffset[c + 2u] = uvMin[c];
+		}
+	}
+
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	i = EncodeSse(in, layout, p, n, out);
+#endif
+	for (; i < n; i++)
+	{
+		EncodeOne(in + i * layout.Stride, layout, p, uvs, out[i]);
+	}
+	return decode;
+}
+
+float AngleBetween(const Vec3& a, const Vec3& b)
+{
+	float la = a.Magnitude();
+	float lb = b.Magnitude();
+	if (la == 0.f || lb == 0.f)
+	{
+		return 0.f;
+	}
+	float c = std::min(std::max(Vec3::Dot(a, b) / (la * lb), -1.f), 1.f);
+	return acosf(c);
+}
+
+template <typename Compact>
+CompactVertexError Measure(const void* vertices, const MeshVertexLayout& layout, const Compact* packed, const CompactVertexDecode& decode, std::size_t n)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(vertices);
+	const bool uvs = HasUV(packed) && layout.UVOffset != MeshVertexLayout::NoAttribute;
+
+	CompactVertexError error;
+	error.Count = n;
+	error.VertexSize = layout.Stride;
+	error.CompactSize = sizeof(Compact);
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		const std::uint8_t* v = in + i * layout.Stride;
+		const float* position = FloatsAt(v, layout.PositionOffset);
+		Vec3 difference = DecodeCompactPosition(packed[i].Position, decode) - Vec3(position[0], position[1], position[2]);
+		error.MaxPositionError = std::max(error.MaxPositionError, difference.Magnitude());
+
+		if (layout.NormalOffset != MeshVertexLayout::NoAttribute)
+		{
+			const float* normal = FloatsAt(v, layout.NormalOffset);
+			error.MaxNormalError = std::max(error.MaxNormalError, AngleBetween(DecodeOctahedralNormal(packed[i].Normal), Vec3(normal[0], normal[1], normal[2])));
+		}
+
+		if (uvs)
+		{
+			const float* uv = FloatsAt(v, layout.UVOffset);
+			const std::uint16_t* q = UVOf(packed[i]);
+			float u = (float)q[0] * decode.UVScaleOffset[0] + decode.UVScaleOffset[2];
+			float w = (float)q[1] * decode.UVScaleOffset[1] + decode.UVScaleOffset[3];
+			error.MaxUVError = std::max(error.MaxUVError, std::max(fabsf(u - uv[0]), fabsf(w - uv[1])));
+		}
+	}
+	return error;
+}
+
+};
+
+CompactVertexDecode EncodeCompactVertices(const void* vertices, const MeshVertexLayout& layout, std::size_t n, const AABB& bounds, CompactVertex* out)
+{
+	return Encode(vertices, layout, n, bounds, out);
+}
+
+CompactVertexDecode EncodeCompactVertices(const void* vertices, const MeshVertexLayout& layout, std::size_t n, const AABB& bounds, CompactTexturedVertex* out)
+{
+	return Encode(vertices, layout, n, bounds, out);
+}
+
+Vec3 DecodeCompactPosition(const std::uint16_t* position, const CompactVertexDecode& decode)
+{
+	return Vec3(
+		(float)position[0] * decode.PositionScale[0] + decode.PositionOffset[0],
+		(float)position[1] * decode.PositionScale[1] + decode.PositionOffset[1],
+		(float)position[2] * decode.PositionScale[2] + decode.PositionOffset[2]);
+}
+
+Vec3 DecodeOctahedralNormal(const std::int16_t* normal)
+{
+	// SNORM reads -32768 as -1 too
+	float x = std::max((float)normal[0] / SnormMax, -1.f);
+	float y = std::max((float)normal[1] / SnormMax, -1.f);
+	float z = 1.f - fabsf(x) - fabsf(y);
+	if (z < 0.f)
+	{
+		float fx = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+		float fy = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = fx;
+		y = fy;
+	}
+	return Vec3(x, y, z).Normal();
+}
+
+//
+// Round trip error
+//
+
+CompactVertexError::CompactVertexError()
+	: Count(0u)
+	, VertexSize(0u)
+	, CompactSize(0u)
+	, MaxPositionError(0.f)
+	, MaxNormalError(0.f)
+	, MaxUVError(0.f)
+{}
+
+void CompactVertexError::Report(std::ostream& o, const char* what) const
+{
+	char line[256];
+	snprintf(line, sizeof(line), "%s: %zu vertices, %zu bytes each (was %zu), position error %.5f, normal error %.4f degrees, UV error %.6f",
+		what, Count, CompactSize, VertexSize, MaxPositionError, MaxNormalError * (180.f / 3.14159265f), MaxUVError);
+	o << line << std::endl;
+}
+
+CompactVertexError MeasureError(const void* vertices, const MeshVertexLayout& layout, const CompactVertex* packed, const CompactVertexDecode& decode, std::size_t n)
+{
+	return Measure(vertices, layout, packed, decode, n);
+}
+
+CompactVertexError MeasureError(const void* vertices, const MeshVertexLayout& layout, const CompactTexturedVertex* packed, const CompactVertexDecode& decode, std::size_t n)
+{
+	return Measure(vertices, layout, packed, decode, n);
+}
+
+};
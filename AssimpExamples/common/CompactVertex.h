@@ -0,0 +1,100 @@
+#pragma once
+
+// Smaller vertices for the GPU.
+// The shaders' own vertices are all 32 bit floats, padded out so position and normal can be
+//  read as float4s (the __one and __zero fields). That's simple, but every vertex the GPU
+//  fetches is 32 or 40 bytes of memory traffic, a good chunk of which is padding or
+//  precision nobody can see. These formats keep just enough:
+//  - Positions are unorm16, within the mesh's bounding box - 1/65535th of the box per step.
+//    The fourth one is always 65535, which reads as 1.0 out of R16G16B16A16_UNORM (the same
+//    job __one does).
+//  - Normals are octahedral: project the unit vector onto an octahedron (|x|+|y|+|z| = 1),
+//    fold the bottom half over the top, and what's left is two numbers in -1...1. Two
+//    snorm16s, read as R16G16_SNORM.
+//  - UVs are unorm16, within the mesh's UV range (which can go past 0...1 for a texture
+//    that tiles), read as R16G16_UNORM.
+// The vertex shader turns them back into floats with a scale and an offset per mesh
+//  (CompactVertexDecode), plus a few instructions to unfold the normal.
+//
+//                          Size        vs. float vertices
+//  CompactVertex           12 bytes    32 -> 2.7x smaller
+//  CompactTexturedVertex   16 bytes    40 -> 2.5x smaller
+//
+// Worst errors are half a step: position is the box size / 131070 on each axis, UV the UV
+//  range / 131070, and normals come out within ~0.03 degrees (measured over 100k random
+//  unit vectors). None of which shows up on screen.
+//
+// Encoding runs at load time, straight from the float vertices a CookedModel maps (see
+//  CookedModel.h), four vertices at a time with SSE. MeasureError says how much was lost,
+//  mesh by mesh.
+
+#include <MeshConvert.h>
+#include <Bounds.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace sess
+{
+
+struct CompactVertex
+{
+public:
+	std::uint16_t Position[4]; // x y z, then 65535
+	std::int16_t Normal[2];    // Octahedral
+};
+
+struct CompactTexturedVertex
+{
+public:
+	std::uint16_t Position[4]; // x y z, then 65535
+	std::int16_t Normal[2];    // Octahedral
+	std::uint16_t UV[2];
+};
+
+// What the vertex shader needs to get floats back, for one mesh. Three float4s, ready to go
+//  into a constant buffer as they are.
+struct CompactVertexDecode
+{
+public:
+	float PositionScale[4];  // position = unorm * scale + offset (w comes out as 1)
+	float PositionOffset[4];
+	float UVScaleOffset[4];  // u scale, v scale, u offset, v offset
+};
+
+// Encodes n vertices laid out as layout says (float vertices, like the shaders' Vertex types).
+//  bounds has to contain every position - CookedModel meshes come with one.
+// A layout without normals encodes them as straight up +Z, one without UVs encodes them as 0.
+CompactVertexDecode EncodeCompactVertices(const void* vertices, const MeshVertexLayout& layout, std::size_t n, const AABB& bounds, CompactVertex* out);
+CompactVertexDecode EncodeCompactVertices(const void* vertices, const MeshVertexLayout& layout, std::size_t n, const AABB& bounds, CompactTexturedVertex* out);
+
+// The same thing the vertex shader does - for checking, the GPU doesn't need these
+Vec3 DecodeCompactPosition(const std::uint16_t* position, const CompactVertexDecode& decode);
+Vec3 DecodeOctahedralNormal(const std::int16_t* normal);
+
+//
+// Round trip error
+//
+struct CompactVertexError
+{
+public:
+	std::size_t Count;
+	std::size_t VertexSize;   // Bytes per vertex, before and after
+	std::size_t CompactSize;
+	float MaxPositionError;   // Distance between original and decoded, in model units
+	float MaxNormalError;     // Radians
+	float MaxUVError;         // Largest difference in either coordinate
+
+public:
+	CompactVertexError();
+
+	// "road.fbx mesh 3: 1200 vertices, 16 bytes each (was 40), position error 0.0003, ..."
+	void Report(std::ostream& o, const char* what) const;
+};
+
+// Decodes each packed vertex and compares it against the original it was encoded from
+CompactVertexError MeasureError(const void* vertices, const MeshVertexLayout& layout, const CompactVertex* packed, const CompactVertexDecode& decode, std::size_t n);
+CompactVertexError MeasureError(const void* vertices, const MeshVertexLayout& layout, const CompactTexturedVertex* packed, const CompactVertexDecode& decode, std::size_t n);
+
+};
@@ -0,0 +1,840 @@
+#include <CookedModel.h>
+#include <AssetArchive.h>
+#include <ImportProfile.h>
+#include <ImportedScene.h>
+#include <ProcessMemory.h>
+
+#include <assimp/scene.h>
+#include <assimp/material.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace sess
+{
+
+namespace
+{
+
+//
+// File layout:
+//  FileHeader
+//  FileMesh[MeshCount]
+//  FileNode[NodeCount]
+//  std::uint32_t[NodeMeshCount] - every node's mesh list, one after the other
+//  IndexRange[RangeCount] - every mesh's draw ranges, one after the other
+//  ... then each mesh's vertices and 16 bit indices, each block starting on a 16 byte boundary
+// Every offset is from the start of the file.
+//
+
+const char Magic[4] = { 'S', 'C', 'K', 'D' };
+const std::uint32_t NoAttribute32 = 0xFFFFFFFFu;
+const std::size_t BlockAlignment = 16u;
+
+struct FileHeader
+{
+public:
+	char Magic[4];
+	std::uint32_t Version;
+	std::uint64_t SourceHash;
+	std::uint32_t ImportFlags;
+	std::uint32_t VertexStride;
+	std::uint32_t PositionOffset;
+	std::uint32_t NormalOffset; // NoAttribute32 if the layout doesn't have one
+	std::uint32_t UVOffset;
+	std::uint32_t MeshCount;
+	std::uint32_t NodeCount;
+	std::uint32_t NodeMeshCount;
+	std::uint32_t RangeCount;
+	std::uint64_t FileSize;
+};
+
+struct FileMesh
+{
+public:
+	std::uint64_t VertexOffset;
+	std::uint64_t IndexOffset;
+	std::uint32_t VertexCount;
+	std::uint32_t IndexCount;
+	std::uint32_t FirstRange; // Into the range table
+	std::uint32_t RangeCount;
+	float Specular[4];
+	float Diffuse[4];
+	float Ambient[4];
+	float BoundsMin[3];
+	float BoundsMax[3];
+};
+
+struct FileNode
+{
+public:
+	std::uint32_t Parent;
+	std::uint32_t FirstMesh; // Into the node mesh list
+	std::uint32_t MeshCount;
+	float Position[3];
+	float Rotation[4]; // x y z w
+	float Scale[3];
+};
+
+std::uint32_t ToFileOffset(std::size_t offset)
+{
+	return offset == MeshVertexLayout::NoAttribute ? NoAttribute32 : (std::uint32_t)offset;
+}
+
+std::size_t AlignUp(std::size_t n)
+{
+	return (n + BlockAlignment - 1u) & ~(BlockAlignment - 1u);
+}
+
+// The tables get copied in and out with memcpy rather than cast in place - the mapping is
+//  page aligned, but a file that's gone wrong could put anything anywhere
+template <typename T>
+T ReadAt(const std::uint8_t* data, std::size_t offset)
+{
+	T t;
+	memcpy(&t, data + offset, sizeof(T));
+	return t;
+}
+
+const std::size_t MeshTableOffset = sizeof(FileHeader);
+
+std::size_t NodeTableOffset(std::uint32_t meshCount)
+{
+	return MeshTableOffset + meshCount * sizeof(FileMesh);
+}
+
+std::size_t NodeMeshListOffset(std::uint32_t meshCount, std::uint32_t nodeCount)
+{
+	return NodeTableOffset(meshCount) + nodeCount * sizeof(FileNode);
+}
+
+std::size_t RangeTableOffset(std::uint32_t meshCount, std::uint32_t nodeCount, std::uint32_t nodeMeshCount)
+{
+	return NodeMeshListOffset(meshCount, nodeCount) + nodeMeshCount * sizeof(std::uint32_t);
+}
+
+void CopyColor(const aiColor4D& c, float* out)
+{
+	out[0] = c.r;
+	out[1] = c.g;
+	out[2] = c.b;
+	out[3] = c.a;
+}
+
+// 64 bit FNV-1a, eight bytes at a time instead of one - an FBX is a few megabytes, and this
+//  runs every start up. Not the same numbers as byte-at-a-time FNV, but it doesn't need to be.
+std::uint64_t HashBytes(const std::uint8_t* data, std::size_t size)
+{
+	const std::uint64_t Prime = 1099511628211ull;
+	std::uint64_t h = 14695981039346656037ull;
+
+	std::size_t i = 0u;
+	for (; i + 8u <= size; i += 8u)
+	{
+		std::uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		h = (h ^ word) * Prime;
+	}
+	for (; i < size; i++)
+	{
+		h = (h ^ data[i]) * Prime;
+	}
+
+	// Mixed with the size, so trailing zeros still change the hash
+	return (h ^ (std::uint64_t)size) * Prime;
+}
+
+};
+
+//
+// CookedModel
+//
+
+CookedModel::CookedModel()
+	: file_()
+	, memory_()
+	, data_(nullptr)
+	, size_(0u)
+{}
+
+CookedModel::CookedModel(CookedModel&& o)
+	: CookedModel()
+{
+	*this = std::move(o);
+}
+
+CookedModel& CookedModel::operator=(CookedModel&& o)
+{
+	if (this != &o)
+	{
+		// A moved vector keeps its buffer and a moved mapping keeps its view, so data_
+		//  stays valid
+		file_ = std::move(o.file_);
+		memory_ = std::move(o.memory_);
+		data_ = o.data_;
+		size_ = o.size_;
+		o.data_ = nullptr;
+		o.size_ = 0u;
+	}
+	return *this;
+}
+
+bool CookedModel::Open(const char* path, const CookedModelKey& key)
+{
+	Close();
+	if (!file_.Open(path))
+	{
+		return false;
+	}
+
+	data_ = file_.Data();
+	size_ = file_.Size();
+	if (!data_ || !Validate(key))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool CookedModel::Open(std::vector<std::uint8_t> bytes, const CookedModelKey& key)
+{
+	Close();
+	memory_ = std::move(bytes);
+	data_ = memory_.empty() ? nullptr : memory_.data();
+	size_ = memory_.size();
+	if (!data_ || !Validate(key))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool CookedModel::Open(const std::uint8_t* data, std::size_t size, const CookedModelKey& key)
+{
+	Close();
+	data_ = data;
+	size_ = size;
+	if (!data_ || !Validate(key))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void CookedModel::Close()
+{
+	file_.Close();
+	memory_.clear();
+	memory_.shrink_to_fit();
+	data_ = nullptr;
+	size_ = 0u;
+}
+
+bool CookedModel::Validate(const CookedModelKey& key) const
+{
+	if (size_ < sizeof(FileHeader))
+	{
+		return false;
+	}
+
+	FileHeader header = ReadAt<FileHeader>(data_, 0u);
+	if (memcmp(header.Magic, Magic, sizeof(Magic)) != 0
+		|| header.Version != Version
+		|| header.FileSize != size_
+		|| header.SourceHash != key.SourceHash
+		|| header.ImportFlags != key.ImportFlags
+		|| header.VertexStride != key.Layout.Stride
+		|| header.PositionOffset != ToFileOffset(key.Layout.PositionOffset)
+		|| header.NormalOffset != ToFileOffset(key.Layout.NormalOffset)
+		|| header.UVOffset != ToFileOffset(key.Layout.UVOffset))
+	{
+		return false;
+	}
+
+	// Tables first (in 64 bits, so silly counts can't wrap around), then everything they point at
+	std::uint64_t tablesEnd = (std::uint64_t)NodeMeshListOffset(0u, 0u)
+		+ (std::uint64_t)header.MeshCount * sizeof(FileMesh)
+		+ (std::uint64_t)header.NodeCount * sizeof(FileNode)
+		+ (std::uint64_t)header.NodeMeshCount * sizeof(std::uint32_t)
+		+ (std::uint64_t)header.RangeCount * sizeof(IndexRange);
+	if (tablesEnd > size_)
+	{
+		return false;
+	}
+
+	std::size_t rangeTable = RangeTableOffset(header.MeshCount, header.NodeCount, header.NodeMeshCount);
+	for (std::uint32_t meshIdx = 0u; meshIdx < header.MeshCount; meshIdx++)
+	{
+		FileMesh mesh = ReadAt<FileMesh>(data_, MeshTableOffset + meshIdx * sizeof(FileMesh));
+		std::uint64_t vertexBytes = (std::uint64_t)mesh.VertexCount * header.VertexStride;
+		std::uint64_t indexBytes = (std::uint64_t)mesh.IndexCount * sizeof(std::uint16_t);
+		if (mesh.VertexOffset > size_ || vertexBytes > size_ - mesh.VertexOffset
+			|| mesh.IndexOffset > size_ || indexBytes > size_ - mesh.IndexOffset
+			|| mesh.IndexOffset % sizeof(std::uint16_t) != 0u
+			|| (std::uint64_t)mesh.FirstRange + mesh.RangeCount > header.RangeCount)
+		{
+			return false;
+		}
+
+		// An index past the end of the vertex buffer is undefined behavior on some drivers -
+		//  and with ranges, "past the end" is after the range's base vertex gets added on
+		const std::uint16_t* indices = reinterpret_cast<const std::uint16_t*>(data_ + mesh.IndexOffset);
+		for (std::uint32_t rangeIdx = 0u; rangeIdx < mesh.RangeCount; rangeIdx++)
+		{
+			IndexRange range = ReadAt<IndexRange>(data_, rangeTable + (mesh.FirstRange + rangeIdx) * sizeof(IndexRange));
+			if ((std::uint64_t)range.StartIndex + range.IndexCount > mesh.IndexCount)
+			{
+				return false;
+			}
+			for (std::uint32_t i = range.StartIndex; i < range.StartIndex + range.IndexCount; i++)
+			{
+				if ((std::uint64_t)indices[i] + range.BaseVertex >= mesh.VertexCount)
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	std::size_t nodeMeshList = NodeMeshListOffset(header.MeshCount, header.NodeCount);
+	for (std::uint32_t nodeIdx = 0u; nodeIdx < header.NodeCount; nodeIdx++)
+	{
+		FileNode node = ReadAt<FileNode>(data_, NodeTableOffset(header.MeshCount) + nodeIdx * sizeof(FileNode));
+		if ((node.Parent != TransformHierarchy::NoParent && node.Parent >= nodeIdx)
+			|| (std::uint64_t)node.FirstMesh + node.MeshCount > header.NodeMeshCount)
+		{
+			return false;
+		}
+		for (std::uint32_t i = 0u; i < node.MeshCount; i++)
+		{
+			if (ReadAt<std::uint32_t>(data_, nodeMeshList + (node.FirstMesh + i) * sizeof(std::uint32_t)) >= header.MeshCount)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+std::uint32_t CookedModel::MeshCount() const
+{
+	return ReadAt<FileHeader>(data_, 0u).MeshCount;
+}
+
+CookedModel::MeshView CookedModel::GetMesh(std::uint32_t meshIdx) const
+{
+	FileHeader header = ReadAt<FileHeader>(data_, 0u);
+	FileMesh mesh = ReadAt<FileMesh>(data_, MeshTableOffset + meshIdx * sizeof(FileMesh));
+	std::size_t ranges = RangeTableOffset(header.MeshCount, header.NodeCount, header.NodeMeshCount) + mesh.FirstRange * sizeof(IndexRange);
+	return MeshView
+	{
+		data_ + mesh.VertexOffset,
+		mesh.VertexCount,
+		reinterpret_cast<const std::uint16_t*>(data_ + mesh.IndexOffset),
+		mesh.IndexCount,
+		reinterpret_cast<const IndexRange*>(data_ + ranges),
+		mesh.RangeCount,
+		Color(mesh.Specular[0], mesh.Specular[1], mesh.Specular[2], mesh.Specular[3]),
+		Color(mesh.Diffuse[0], mesh.Diffuse[1], mesh.Diffuse[2], mesh.Diffuse[3]),
+		Color(mesh.Ambient[0], mesh.Ambient[1], mesh.Ambient[2], mesh.Ambient[3]),
+		AABB(Vec3(mesh.BoundsMin[0], mesh.BoundsMin[1], mesh.BoundsMin[2]), Vec3(mesh.BoundsMax[0], mesh.BoundsMax[1], mesh.BoundsMax[2]))
+	};
+}
+
+std::uint32_t CookedModel::NodeCount() const
+{
+	return ReadAt<FileHeader>(data_, 0u).NodeCount;
+}
+
+CookedModel::NodeView CookedModel::GetNode(std::uint32_t nodeIdx) const
+{
+	FileHeader header = ReadAt<FileHeader>(data_, 0u);
+	FileNode node = ReadAt<FileNode>(data_, NodeTableOffset(header.MeshCount) + nodeIdx * sizeof(FileNode));
+	std::size_t meshList = NodeMeshListOffset(header.MeshCount, header.NodeCount) + node.FirstMesh * sizeof(std::uint32_t);
+	return NodeView
+	{
+		node.Parent,
+		Transform(
+			Vec3(node.Position[0], node.Position[1], node.Position[2]),
+			Quaternion(node.Rotation[3], node.Rotation[0], node.Rotation[1], node.Rotation[2]),
+			Vec3(node.Scale[0], node.Scale[1], node.Scale[2])),
+		reinterpret_cast<const std::uint32_t*>(data_ + meshList),
+		node.MeshCount
+	};
+}
+
+std::uint32_t CookedModel::AddNodes(TransformHierarchy& hierarchy, std::uint32_t parent) const
+{
+	std::uint32_t first = (std::uint32_t)hierarchy.Size();
+	std::uint32_t nodeCount = NodeCount();
+	hierarchy.Reserve(first + nodeCount);
+	for (std::uint32_t nodeIdx = 0u; nodeIdx < nodeCount; nodeIdx++)
+	{
+		NodeView node = GetNode(nodeIdx);
+		hierarchy.Add(node.Local, node.Parent == TransformHierarchy::NoParent ? parent : first + node.Parent);
+	}
+	return first;
+}
+
+//
+// Cooking
+//
+
+bool HashFileContents(const char* path, std::uint64_t& hash)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		return false;
+	}
+	hash = HashBytes(file.Data(), file.Size());
+	return true;
+}
+
+namespace
+{
+
+// Everything about a cook that's known before any mesh gets converted: where each block goes,
+//  and the tables at the front of the file (which get bounds and ranges filled in as meshes
+//  are converted, and go in last)
+struct CookPlan
+{
+public:
+	FileHeader Header;
+	std::vector<FileMesh> Meshes;
+	std::vector<std::size_t> Scratch; // Memory converting each mesh needs besides its own blocks
+	std::size_t PlanningScratch; // Most memory working out the splits needed at once
+	std::size_t RangeTable;
+	std::size_t DataStart;
+	std::vector<std::uint8_t> Tables; // The first DataStart bytes of the file
+};
+
+// A mesh too big for 16 bit indices gets converted as it is before it's split, which takes its
+//  vertices in the cooked layout, 32 bit indices and the split's own bookkeeping, all at once
+std::size_t SplitScratchBytes(std::size_t vertexCount, std::size_t indexCount, std::size_t stride)
+{
+	return vertexCount * (stride + sizeof(std::uint32_t) + sizeof(std::uint16_t)) + indexCount * sizeof(std::uint32_t);
+}
+
+void PlanCook(const aiScene* scene, const CookedModelKey& key, CookPlan& plan)
+{
+	// The node tree, flattened the same way the loaders used to do it on every start up
+	TransformHierarchy nodes;
+	std::vector<const aiNode*> sourceNodes;
+	if (scene->mRootNode)
+	{
+		nodes.AddAssimpNodes(scene->mRootNode, TransformHierarchy::NoParent, &sourceNodes);
+	}
+
+	FileHeader& header = plan.Header;
+	header = FileHeader();
+	memcpy(header.Magic, Magic, sizeof(Magic));
+	header.Version = CookedModel::Version;
+	header.SourceHash = key.SourceHash;
+	header.ImportFlags = key.ImportFlags;
+	header.VertexStride = (std::uint32_t)key.Layout.Stride;
+	header.PositionOffset = ToFileOffset(key.Layout.PositionOffset);
+	header.NormalOffset = ToFileOffset(key.Layout.NormalOffset);
+	header.UVOffset = ToFileOffset(key.Layout.UVOffset);
+	header.MeshCount = scene->mNumMeshes;
+	header.NodeCount = (std::uint32_t)nodes.Size();
+	for (const aiNode* node : sourceNodes)
+	{
+		header.NodeMeshCount += node->mNumMeshes;
+	}
+
+	// Meshes too big for 16 bit indices come out bigger than they went in (vertices used on
+	//  both sides of a split get duplicated), and nobody knows by how much until the split's
+	//  been worked out. That only takes the indices, and goes one mesh at a time so there's
+	//  only ever one mesh's worth of them around - the vertices get converted and split for
+	//  real when the mesh's batch comes up. There usually aren't any of these.
+	std::vector<FileMesh>& meshes = plan.Meshes;
+	meshes.assign(header.MeshCount, FileMesh());
+	plan.Scratch.assign(header.MeshCount, 0u);
+	plan.PlanningScratch = 0u;
+	for (std::uint32_t meshIdx = 0u; meshIdx < header.MeshCount; meshIdx++)
+	{
+		const aiMesh* mesh = scene->mMeshes[meshIdx];
+		if (mesh->mNumVertices <= MaxShortIndexVertices)
+		{
+			continue;
+		}
+
+		std::vector<std::uint32_t> indices(CountAssimpTriangleIndices(mesh));
+		if (!indices.empty())
+		{
+			ConvertAssimpIndices(mesh, indices.data());
+		}
+		std::size_t splitVertexCount = 0u, rangeCount = 0u;
+		CountShortIndexSplit(mesh->mNumVertices, indices.data(), indices.size(), splitVertexCount, rangeCount);
+		meshes[meshIdx].VertexCount = (std::uint32_t)splitVertexCount;
+		meshes[meshIdx].RangeCount = (std::uint32_t)rangeCount;
+
+		plan.Scratch[meshIdx] = SplitScratchBytes(mesh->mNumVertices, indices.size(), key.Layout.Stride);
+		plan.PlanningScratch = std::max(plan.PlanningScratch, plan.Scratch[meshIdx]);
+	}
+
+	// Work out where everything goes, so each mesh can be converted straight into its place
+	for (std::uint32_t meshIdx = 0u; meshIdx < header.MeshCount; meshIdx++)
+	{
+		const aiMesh* mesh = scene->mMeshes[meshIdx];
+		FileMesh& m = meshes[meshIdx];
+		if (mesh->mNumVertices <= MaxShortIndexVertices)
+		{
+			m.VertexCount = mesh->mNumVertices;
+			m.RangeCount = 1u;
+		}
+		m.IndexCount = (std::uint32_t)CountAssimpTriangleIndices(mesh);
+		m.FirstRange = header.RangeCount;
+		header.RangeCount += m.RangeCount;
+	}
+	plan.RangeTable = RangeTableOffset(header.MeshCount, header.NodeCount, header.NodeMeshCount);
+	plan.DataStart = AlignUp(plan.RangeTable + header.RangeCount * sizeof(IndexRange));
+	std::size_t size = plan.DataStart;
+	for (std::uint32_t meshIdx = 0u; meshIdx < header.MeshCount; meshIdx++)
+	{
+		const aiMesh* mesh = scene->mMeshes[meshIdx];
+		FileMesh& m = meshes[meshIdx];
+		m.VertexOffset = size;
+		size = AlignUp(size + m.VertexCount * key.Layout.Stride);
+		m.IndexOffset = size;
+		size = AlignUp(size + m.IndexCount * sizeof(std::uint16_t));
+
+		// Same colors the loaders used to pull out themselves. Anything missing stays black
+		//  (Assimp leaves the output alone if the key isn't there).
+		const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+		aiColor4D specularColor(0.f, 0.f, 0.f, 0.f);
+		aiColor4D diffuseColor(0.f, 0.f, 0.f, 1.f);
+		aiColor4D ambientColor(0.f, 0.f, 0.f, 1.f);
+		float shininess = 0.f;
+		aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specularColor);
+		aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuseColor);
+		aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &ambientColor);
+		aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
+		specularColor.a = shininess;
+		CopyColor(specularColor, m.Specular);
+		CopyColor(diffuseColor, m.Diffuse);
+		CopyColor(ambientColor, m.Ambient);
+	}
+	header.FileSize = size;
+
+	// Zero filled, so the padding doesn't make the file different every time
+	plan.Tables.assign(plan.DataStart, 0u);
+	std::uint8_t* out = plan.Tables.data();
+
+	std::uint32_t nodeMeshCount = 0u;
+	std::size_t nodeMeshList = NodeMeshListOffset(header.MeshCount, header.NodeCount);
+	for (std::uint32_t nodeIdx = 0u; nodeIdx < header.NodeCount; nodeIdx++)
+	{
+		const aiNode* source = sourceNodes[nodeIdx];
+		const Transform& local = nodes.GetLocal(nodeIdx);
+
+		FileNode node = {};
+		node.Parent = nodes.GetParent(nodeIdx);
+		node.FirstMesh = nodeMeshCount;
+		node.MeshCount = source->mNumMeshes;
+		memcpy(node.Position, &local.Position.x, sizeof(node.Position));
+		node.Rotation[0] = local.Rotation.x;
+		node.Rotation[1] = local.Rotation.y;
+		node.Rotation[2] = local.Rotation.z;
+		node.Rotation[3] = local.Rotation.w;
+		memcpy(node.Scale, &local.Scale.x, sizeof(node.Scale));
+		memcpy(out + NodeTableOffset(header.MeshCount) + nodeIdx * sizeof(FileNode), &node, sizeof(node));
+
+		for (std::uint32_t i = 0u; i < source->mNumMeshes; i++)
+		{
+			memcpy(out + nodeMeshList + nodeMeshCount * sizeof(std::uint32_t), &source->mMeshes[i], sizeof(std::uint32_t));
+			nodeMeshCount++;
+		}
+	}
+}
+
+// End of the last block of a mesh, padding included - where the next mesh starts
+std::uint64_t MeshBlocksEnd(const CookPlan& plan, std::uint32_t meshIdx)
+{
+	return meshIdx + 1u < plan.Header.MeshCount ? plan.Meshes[meshIdx + 1u].VertexOffset : plan.Header.FileSize;
+}
+
+// Everything converting one mesh needs at once - its blocks in the output, plus any scratch
+std::size_t MeshCookBytes(const CookPlan& plan, std::uint32_t meshIdx)
+{
+	return (std::size_t)(MeshBlocksEnd(plan, meshIdx) - plan.Meshes[meshIdx].VertexOffset) + plan.Scratch[meshIdx];
+}
+
+// Converts meshes first...last-1 into out, which holds the file from offset base onwards (and
+//  at least up to the end of the last one's blocks). Bounds and ranges go into the plan.
+void ConvertPlannedMeshes(const aiScene* scene, const CookedModelKey& key, CookPlan& plan, std::uint32_t first, std::uint32_t last, std::uint8_t* out, std::uint64_t base, const ForEachFn& forEach)
+{
+	ForEachIndex(forEach, last - first, [scene, &key, &plan, first, out, base](std::size_t i)
+	{
+		std::uint32_t meshIdx = first + (std::uint32_t)i;
+		const aiMesh* mesh = scene->mMeshes[meshIdx];
+		FileMesh& m = plan.Meshes[meshIdx];
+		std::uint8_t* ranges = plan.Tables.data() + plan.RangeTable + m.FirstRange * sizeof(IndexRange);
+
+		AABB bounds;
+		if (mesh->mNumVertices > MaxShortIndexVertices)
+		{
+			// Converted as it is first, then split straight into place. The unsplit copy is
+			//  gone again as soon as that's done.
+			std::vector<std::uint8_t> vertices(mesh->mNumVertices * key.Layout.Stride);
+			std::vector<std::uint32_t> indices(m.IndexCount);
+			std::vector<IndexRange> splitRanges(m.RangeCount);
+			bounds = ConvertAssimpVertices(mesh, key.Layout, vertices.data());
+			if (!indices.empty())
+			{
+				ConvertAssimpIndices(mesh, indices.data());
+			}
+			SplitForShortIndices(vertices.data(), mesh->mNumVertices, key.Layout.Stride, indices.data(), indices.size(),
+				out + (m.VertexOffset - base), reinterpret_cast<std::uint16_t*>(out + (m.IndexOffset - base)), splitRanges.data());
+			memcpy(ranges, splitRanges.data(), splitRanges.size() * sizeof(IndexRange));
+		}
+		else
+		{
+			if (m.VertexCount > 0u)
+			{
+				bounds = ConvertAssimpVertices(mesh, key.Layout, out + (m.VertexOffset - base));
+			}
+			if (m.IndexCount > 0u)
+			{
+				ConvertAssimpIndices(mesh, reinterpret_cast<std::uint16_t*>(out + (m.IndexOffset - base)));
+			}
+
+			IndexRange whole = { 0u, m.IndexCount, 0u };
+			memcpy(ranges, &whole, sizeof(whole));
+		}
+		memcpy(m.BoundsMin, &bounds.Min.x, sizeof(m.BoundsMin));
+		memcpy(m.BoundsMax, &bounds.Max.x, sizeof(m.BoundsMax));
+	});
+}
+
+// The header and mesh table, now that every mesh's bounds are in
+void FinishPlannedTables(CookPlan& plan)
+{
+	memcpy(plan.Tables.data(), &plan.Header, sizeof(plan.Header));
+	if (!plan.Meshes.empty())
+	{
+		memcpy(plan.Tables.data() + MeshTableOffset, plan.Meshes.data(), plan.Meshes.size() * sizeof(FileMesh));
+	}
+}
+
+std::size_t cookMemoryBudget = 32u * 1024u * 1024u;
+
+};
+
+void CookAssimpScene(const aiScene* scene, const CookedModelKey& key, std::vector<std::uint8_t>& bytes, const ForEachFn& forEach)
+{
+	CookPlan plan;
+	PlanCook(scene, key, plan);
+
+	// The whole file at once, with every mesh converted straight into its place in it
+	bytes.assign((std::size_t)plan.Header.FileSize, 0u);
+	ConvertPlannedMeshes(scene, key, plan, 0u, plan.Header.MeshCount, bytes.data(), 0u, forEach);
+	FinishPlannedTables(plan);
+	memcpy(bytes.data(), plan.Tables.data(), plan.Tables.size());
+}
+
+bool CookAssimpSceneToFile(const aiScene* scene, const CookedModelKey& key, const char* path, std::size_t memoryBudget, const ForEachFn& forEach, std::size_t* workingBytes)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	CookPlan plan;
+	PlanCook(scene, key, plan);
+
+	// Room for the tables, which get written over once the meshes are done
+	file.write(reinterpret_cast<const char*>(plan.Tables.data()), (std::streamsize)plan.Tables.size());
+
+	// The meshes go out a batch at a time, in file order. A batch is as many meshes in a row as
+	//  fit in the budget, scratch for splitting included - or just the one, if one mesh is
+	//  bigger than the whole budget. The meshes in a batch still get converted in parallel.
+	std::size_t largestBatch = 0u;
+	std::vector<std::uint8_t> staging;
+	std::uint32_t first = 0u;
+	while (first < plan.Header.MeshCount && file)
+	{
+		std::uint64_t base = plan.Meshes[first].VertexOffset;
+		std::uint32_t last = first + 1u;
+		std::size_t batchBytes = MeshCookBytes(plan, first);
+		while (last < plan.Header.MeshCount && batchBytes + MeshCookBytes(plan, last) <= memoryBudget)
+		{
+			batchBytes += MeshCookBytes(plan, last);
+			last++;
+		}
+		largestBatch = std::max(largestBatch, batchBytes);
+
+		// Zero filled again every time, for the padding
+		staging.assign((std::size_t)(MeshBlocksEnd(plan, last - 1u) - base), 0u);
+		ConvertPlannedMeshes(scene, key, plan, first, last, staging.data(), base, forEach);
+		file.write(reinterpret_cast<const char*>(staging.data()), (std::streamsize)staging.size());
+		first = last;
+	}
+
+	if (workingBytes)
+	{
+		*workingBytes = plan.Tables.size() + std::max(plan.PlanningScratch, largestBatch);
+	}
+
+	FinishPlannedTables(plan);
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(plan.Tables.data()), (std::streamsize)plan.Tables.size());
+	file.close();
+	return (bool)file;
+}
+
+void SetCookMemoryBudget(std::size_t bytes)
+{
+	cookMemoryBudget = bytes;
+}
+
+std::size_t CookMemoryBudget()
+{
+	return cookMemoryBudget;
+}
+
+bool LoadCookedModel(const char* sourceFile, unsigned int importFlags, const MeshVertexLayout& layout, CookedModel& out, LoadTimer* timer, const AssetArchive* archive, const ForEachFn& forEach)
+{
+	auto endStage = [timer](const char* name)
+	{
+		if (timer)
+		{
+			timer->EndStage(name);
+		}
+	};
+
+	AssetArchive::Entry source;
+	bool fromArchive = archive && archive->Find(sourceFile, source);
+
+	std::uint64_t sourceHash = 0u;
+	if (fromArchive)
+	{
+		sourceHash = HashBytes(source.Data, source.Size);
+	}
+	else if (!HashFileContents(sourceFile, sourceHash))
+	{
+		return false;
+	}
+	CookedModelKey key(sourceHash, importFlags, layout);
+	std::string cookedPath = std::string(sourceFile) + ".cooked";
+	endStage("hash");
+
+	AssetArchive::Entry cooked;
+	if (fromArchive && archive->Find(cookedPath.c_str(), cooked) && out.Open(cooked.Data, cooked.Size, key))
+	{
+		endStage("map");
+		return true;
+	}
+
+	if (out.Open(cookedPath.c_str(), key))
+	{
+		endStage("map");
+		return true;
+	}
+
+	// Cache miss - the slow way, once
+	std::size_t residentBefore = CurrentResidentBytes();
+	ImportTiming importTiming;
+	ImportedScene scene;
+	if (!scene.Read(sourceFile, importFlags, fromArchive ? archive->CreateIOSystem() : nullptr, &importTiming))
+	{
+		std::cerr << "Could not import " << sourceFile << ": " << scene.ErrorString() << std::endl;
+		return false;
+	}
+	endStage("import");
+	if (ImportStepTimingEnabled())
+	{
+		importTiming.Report(std::cout, sourceFile);
+	}
+
+	// Written to the side and then moved into place, so a crash halfway through never leaves
+	//  a half written file where the next start up would look for it (not that Validate
+	//  would accept one)
+	std::string tempPath = cookedPath + ".tmp";
+	std::size_t budget = CookMemoryBudget();
+	std::size_t workingBytes = 0u;
+	bool loaded = false;
+	if (budget > 0u && CookAssimpSceneToFile(scene.Get(), key, tempPath.c_str(), budget, forEach, &workingBytes))
+	{
+		// Everything's on disk now - the scene can go before the cooked file gets mapped
+		scene.Release();
+		endStage("convert");
+
+		std::remove(cookedPath.c_str());
+		if (std::rename(tempPath.c_str(), cookedPath.c_str()) == 0)
+		{
+			loaded = out.Open(cookedPath.c_str(), key);
+		}
+		else
+		{
+			// It'll get cooked again next time, but there's no reason not to use it now
+			std::cerr << "Could not write cooked model " << cookedPath << std::endl;
+			loaded = out.Open(tempPath.c_str(), key);
+		}
+		endStage("write");
+	}
+	else
+	{
+		// No budget, or the file couldn't be streamed out - the whole thing in memory, then
+		std::vector<std::uint8_t> bytes;
+		CookAssimpScene(scene.Get(), key, bytes, forEach);
+		workingBytes = bytes.size();
+		scene.Release();
+		endStage("convert");
+
+		bool written = false;
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+			written = (bool)file;
+		}
+		std::remove(cookedPath.c_str());
+		if (!written || std::rename(tempPath.c_str(), cookedPath.c_str()) != 0)
+		{
+			// Still fine to draw from - it just gets cooked again next time
+			std::remove(tempPath.c_str());
+			std::cerr << "Could not write cooked model " << cookedPath << std::endl;
+		}
+		endStage("write");
+
+		loaded = out.Open(std::move(bytes), key);
+	}
+
+	// Every cook says how it did against the budget, since that's the whole point of having
+	//  one. The peak is for the whole process, so it only says something about this import if
+	//  nothing before it went higher - good enough for the one big model that matters.
+	const double MB = 1024.0 * 1024.0;
+	char buffer[192];
+	char budgetText[48];
+	if (budget > 0u)
+	{
+		snprintf(budgetText, sizeof(budgetText), "budget %.1f MB", budget / MB);
+	}
+	else
+	{
+		snprintf(budgetText, sizeof(budgetText), "no budget, cooked in memory");
+	}
+	snprintf(buffer, sizeof(buffer), "conversion held %.1f MB (%s), peak resident %.1f MB (%.1f MB before import)",
+		workingBytes / MB, budgetText, PeakResidentBytes() / MB, residentBefore / MB);
+	std::cout << "Cooked " << sourceFile << ": " << buffer << std::endl;
+	if (budget > 0u && workingBytes > budget)
+	{
+		// Only happens when one mesh (or the tables) can't be broken up any further
+		std::cerr << "Cooking " << sourceFile << " went over the conversion budget - a single mesh needs more than that" << std::endl;
+	}
+
+	return loaded;
+}
+
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+// Cooked models - an Assimp import, converted for the demos (see MeshConvert.h) and saved to
+//  disk in a form that can be drawn straight from.
+// Importing road.fbx means parsing FBX and then running every post-processing step its import
+//  profile asks for (generating normals, joining identical vertices, reordering triangles for
+//  the vertex cache... see ImportProfile.h) on every single start up, for a result that comes
+//  out the same every time. LoadCookedModel does all of that once, and saves what came
+//  out next to the source file (road.fbx.cooked):
+//  - each mesh's vertices, already in the shader's layout, and its triangle indices - 16 bit
+//    ones, with meshes too big for that split into ranges (SplitForShortIndices)
+//  - each mesh's material colors and bounding box
+//  - the node tree, and which meshes hang off of each node
+// After that, loading is mapping the file into memory (MappedFile.h) and pointing the GPU
+//  buffer creation at it - no parsing, and no copying on our side.
+//
+// A cooked file only gets used if it was made from the same source file (going by a hash of
+//  its contents), with the same import flags, for the same vertex layout, by the same version
+//  of this code. Anything else and it gets cooked again and overwritten - delete it to force
+//  that. The format is just the in-memory layout of the structures in CookedModel.cc (little
+//  endian, native alignment) - it's a cache, not something to copy between machines.
+
+#include <MappedFile.h>
+#include <MeshConvert.h>
+#include <TransformHierarchy.h>
+#include <Color.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct aiScene;
+
+namespace sess
+{
+
+class AssetArchive;
+
+// What a cooked file has to have been made from to be used
+struct CookedModelKey
+{
+public:
+	std::uint64_t SourceHash;
+	std::uint32_t ImportFlags;
+	MeshVertexLayout Layout;
+
+public:
+	CookedModelKey(std::uint64_t sourceHash, std::uint32_t importFlags, const MeshVertexLayout& layout)
+		: SourceHash(sourceHash), ImportFlags(importFlags), Layout(layout)
+	{}
+};
+
+class CookedModel
+{
+public:
+	// Format version - bump this whenever the file layout, or what goes into it, changes
+	static const std::uint32_t Version = 2u;
+
+	struct MeshView
+	{
+	public:
+		const void* Vertices; // In the layout the model was cooked for - see GetVertices
+		std::uint32_t VertexCount;
+		const std::uint16_t* Indices; // Triangle list, 16 bit whatever the mesh's size
+		std::uint32_t IndexCount;
+		const IndexRange* Ranges; // One DrawIndexed each. Only meshes with more than
+		std::uint32_t RangeCount; //  MaxShortIndexVertices vertices have more than one.
+		Color Specular; // Alpha is the shininess, like the shaders' Material
+		Color Diffuse;
+		Color Ambient;
+		AABB Bounds;
+	};
+
+	struct NodeView
+	{
+	public:
+		std::uint32_t Parent; // Index of another node, or TransformHierarchy::NoParent
+		Transform Local;
+		const std::uint32_t* Meshes;
+		std::uint32_t MeshCount;
+	};
+
+public:
+	CookedModel();
+	CookedModel(CookedModel&& o);
+	CookedModel& operator=(CookedModel&& o);
+	CookedModel(const CookedModel&) = delete;
+	~CookedModel() = default;
+
+	// Maps the cooked file at path. False if it isn't there, is broken, or doesn't match key.
+	bool Open(const char* path, const CookedModelKey& key);
+
+	// Uses cooked bytes that are already in memory (see CookAssimpScene)
+	bool Open(std::vector<std::uint8_t> bytes, const CookedModelKey& key);
+
+	// Uses cooked bytes somebody else owns, without copying them - an entry in an AssetArchive,
+	//  say. They have to stay put for as long as this is open.
+	bool Open(const std::uint8_t* data, std::size_t size, const CookedModelKey& key);
+
+	void Close();
+	bool IsOpen() const { return data_ != nullptr; }
+
+	std::uint32_t MeshCount() const;
+	MeshView GetMesh(std::uint32_t meshIdx) const;
+
+	// Mesh vertices as the vertex type the model was cooked for. Open already checked that the
+	//  layout matches Vertex::Layout() (if that's what went into the key).
+	template <typename Vertex>
+	const Vertex* GetVertices(std::uint32_t meshIdx) const
+	{
+		return static_cast<const Vertex*>(GetMesh(meshIdx).Vertices);
+	}
+
+	// Nodes are in topological order - a parent always comes before its children
+	std::uint32_t NodeCount() const;
+	NodeView GetNode(std::uint32_t nodeIdx) const;
+
+	// Adds every node to hierarchy, with the top level ones under parent (like
+	//  TransformHierarchy::AddAssimpNodes). Node i ends up at (returned index + i).
+	std::uint32_t AddNodes(TransformHierarchy& hierarchy, std::uint32_t parent = TransformHierarchy::NoParent) const;
+
+protected:
+	// Checks everything in the file against key and against its own size before anything
+	//  gets to look at it - a truncated or stale file is just a cache miss, not a crash
+	bool Validate(const CookedModelKey& key) const;
+
+protected:
+	MappedFile file_;
+	std::vector<std::uint8_t> memory_;
+	const std::uint8_t* data_;
+	std::size_t size_;
+};
+
+// Hash of a file's contents, for CookedModelKey::SourceHash. False if it can't be read.
+bool HashFileContents(const char* path, std::uint64_t& hash);
+
+// Converts scene into a cooked model for key.Layout, into bytes. Meshes are converted in
+//  parallel, straight into their place in the output - through forEach if there is one (an
+//  AssetLoader's threads, say), or ParallelFor if not.
+void CookAssimpScene(const aiScene* scene, const CookedModelKey& key, std::vector<std::uint8_t>& bytes, const ForEachFn& forEach = ForEachFn());
+
+// Same file as CookAssimpScene, but written out to path a few meshes at a time instead of
+//  being put together in memory. Meshes go in batches of however many in a row fit in
+//  memoryBudget bytes, counting the scratch it takes to split meshes too big for 16 bit
+//  indices - those get split inside their batch, not ahead of time. There's always at least
+//  one mesh in a batch, so the cook holds whichever is bigger of the budget and the biggest
+//  single mesh (plus the header and tables) on top of the scene. That goes in workingBytes,
+//  if it's there. False if path couldn't be written.
+bool CookAssimpSceneToFile(const aiScene* scene, const CookedModelKey& key, const char* path, std::size_t memoryBudget, const ForEachFn& forEach = ForEachFn(), std::size_t* workingBytes = nullptr);
+
+// How much memory LoadCookedModel can use for converted meshes while the imported scene is
+//  still around (see CookAssimpSceneToFile). 0 puts the whole cooked file together in memory
+//  first, which is a little quicker and uses as much memory again as the model takes.
+//  32MB to start with.
+void SetCookMemoryBudget(std::size_t bytes);
+std::size_t CookMemoryBudget();
+
+// What the loaders call. Opens "<sourceFile>.cooked" if it's up to date, otherwise imports
+//  sourceFile with Assimp, cooks it, saves it for next time, and uses that.
+// With an archive that has sourceFile in it (see AssetArchive.h), everything comes from there
+//  instead - the source gets hashed and imported straight out of the mapping, and the cooked
+//  file is used in place if the archive has an up to date one too. A fresh cook still gets
+//  saved next to the source on disk, for the next time the archive is packed.
+// The imported scene is freed as soon as it's converted, and the cook streams to disk within
+//  CookMemoryBudget() (see CookAssimpSceneToFile for when it can't). Every cook prints how
+//  much it held against the budget and where the process's memory peaked, and warns if it
+//  went over.
+// Stages ("hash", then "map" or "import", "convert", "write") go on timer if there is one.
+// A cook's meshes get converted through forEach, if there is one (see CookAssimpScene).
+// False if sourceFile can't be read or imported.
+bool LoadCookedModel(const char* sourceFile, unsigned int importFlags, const MeshVertexLayout& layout, CookedModel& out, LoadTimer* timer = nullptr, const AssetArchive* archive = nullptr, const ForEachFn& forEach = ForEachFn());
+
+};
@@ -0,0 +1,196 @@
+#include <DualQuaternion.h>
+#include <MathExtras.h>
+
+#include <cmath>
+
+namespace sess
+{
+
+// Constant-initialized through the constexpr constructor
+const DualQuaternion DualQuaternion::Identity = DualQuaternion();
+
+static_assert(sizeof(DualQuaternion) == 8u * sizeof(float), "Blending loads a whole DualQuaternion as eight packed floats");
+
+namespace
+{
+
+// The conjugate (w, -x, -y, -z). Not the same as Quaternion::Inverse, which is the
+//  conjugate negated - that's the same rotation, but not the same number.
+constexpr Quaternion Conjugate(const Quaternion& q)
+{
+	return Quaternion::Unchecked(q.w, -q.x, -q.y, -q.z);
+}
+
+// Blend of one vertex's influences, normalized
+DualQuaternion BlendInfluences(const DualQuaternion* palette, const std::uint32_t* indices, const float* weights)
+{
+	const Quaternion& pivot = palette[indices[0]].Real;
+
+	// Signs are worked out up front - it's a 4-wide dot product per bone, and it keeps
+	//  the blend itself down to a multiply-add per register
+	float w[DualQuaternion::InfluencesPerVertex];
+	for (std::size_t k = 0u; k < DualQuaternion::InfluencesPerVertex; k++)
+	{
+		w[k] = Quaternion::Dot(pivot, palette[indices[k]].Real) < 0.f ? -weights[k] : weights[k];
+	}
+
+	DualQuaternion result;
+#if defined(SESS_SIMD_AVX)
+	// Real and Dual are next to each other, so a whole bone is one register
+	__m256 acc = _mm256_mul_ps(_mm256_set1_ps(w[0]), _mm256_loadu_ps(&palette[indices[0]].Real.x));
+	for (std::size_t k = 1u; k < DualQuaternion::InfluencesPerVertex; k++)
+	{
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(w[k]), _mm256_loadu_ps(&palette[indices[k]].Real.x)));
+	}
+
+	__m128 real = _mm256_castps256_ps128(acc);
+	__m128 lenSq = _mm_mul_ps(real, real);
+	lenSq = _mm_add_ps(lenSq, _mm_shuffle_ps(lenSq, lenSq, _MM_SHUFFLE(2, 3, 0, 1)));
+	lenSq = _mm_add_ps(lenSq, _mm_shuffle_ps(lenSq, lenSq, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 invLen = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(lenSq));
+	_mm256_storeu_ps(&result.Real.x, _mm256_mul_ps(acc, _mm256_insertf128_ps(_mm256_castps128_ps256(invLen), invLen, 1)));
+#elif defined(SESS_SIMD_SSE)
+	__m128 real = _mm_mul_ps(_mm_set1_ps(w[0]), _mm_loadu_ps(&palette[indices[0]].Real.x));
+	__m128 dual = _mm_mul_ps(_mm_set1_ps(w[0]), _mm_loadu_ps(&palette[indices[0]].Dual.x));
+	for (std::size_t k = 1u; k < DualQuaternion::InfluencesPerVertex; k++)
+	{
+		__m128 wk = _mm_set1_ps(w[k]);
+		real = _mm_add_ps(real, _mm_mul_ps(wk, _mm_loadu_ps(&palette[indices[k]].Real.x)));
+		dual = _mm_add_ps(dual, _mm_mul_ps(wk, _mm_loadu_ps(&palette[indices[k]].Dual.x)));
+	}
+
+	__m128 lenSq = _mm_mul_ps(real, real);
+	lenSq = _mm_add_ps(lenSq, _mm_shuffle_ps(lenSq, lenSq, _MM_SHUFFLE(2, 3, 0, 1)));
+	lenSq = _mm_add_ps(lenSq, _mm_shuffle_ps(lenSq, lenSq, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 invLen = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(lenSq));
+	_mm_storeu_ps(&result.Real.x, _mm_mul_ps(real, invLen));
+	_mm_storeu_ps(&result.Dual.x, _mm_mul_ps(dual, invLen));
+#else
+	float acc[8] = {};
+	for (std::size_t k = 0u; k < DualQuaternion::InfluencesPerVertex; k++)
+	{
+		const DualQuaternion& dq = palette[indices[k]];
+		acc[0] += w[k] * dq.Real.x; acc[1] += w[k] * dq.Real.y; acc[2] += w[k] * dq.Real.z; acc[3] += w[k] * dq.Real.w;
+		acc[4] += w[k] * dq.Dual.x; acc[5] += w[k] * dq.Dual.y; acc[6] += w[k] * dq.Dual.z; acc[7] += w[k] * dq.Dual.w;
+	}
+
+	float invLen = 1.f / sqrtf(acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2] + acc[3] * acc[3]);
+	result.Real = Quaternion::Unchecked(acc[3] * invLen, acc[0] * invLen, acc[1] * invLen, acc[2] * invLen);
+	result.Dual = Quaternion::Unchecked(acc[7] * invLen, acc[4] * invLen, acc[5] * invLen, acc[6] * invLen);
+#endif
+
+	return result;
+}
+
+};
+
+// dual = 1/2 t r, with t as a pure quaternion (0, t)
+DualQuaternion::DualQuaternion(const Quaternion& rotation, const Vec3& translation)
+	: Real(rotation)
+	, Dual(Quaternion::Unchecked(0.f, 0.5f * translation.x, 0.5f * translation.y, 0.5f * translation.z) * rotation)
+{}
+
+DualQuaternion DualQuaternion::FromTransform(const Transform& transform)
+{
+	return DualQuaternion(transform.Rotation, transform.Position);
+}
+
+Transform DualQuaternion::ToTransform() const
+{
+	return Transform(GetTranslation(), Real, Vec3::Ones);
+}
+
+Quaternion DualQuaternion::GetRotation() const
+{
+	return Real;
+}
+
+// t = 2 dual r*
+Vec3 DualQuaternion::GetTranslation() const
+{
+	Quaternion t = Dual * Conjugate(Real);
+	return Vec3(2.f * t.x, 2.f * t.y, 2.f * t.z);
+}
+
+// (r1 + e d1)(r2 + e d2) = r1 r2 + e (r1 d2 + d1 r2), since e^2 = 0
+DualQuaternion DualQuaternion::operator*(const DualQuaternion& o) const
+{
+	DualQuaternion result;
+	result.Real = Real * o.Real;
+	Quaternion a = Real * o.Dual;
+	Quaternion b = Dual * o.Real;
+	result.Dual = Quaternion::Unchecked(a.w + b.w, a.x + b.x, a.y + b.y, a.z + b.z);
+	return result;
+}
+
+Vec3 DualQuaternion::TransformPoint(const Vec3& p) const
+{
+	return p * Real + GetTranslation();
+}
+
+Vec3 DualQuaternion::TransformVector(const Vec3& v) const
+{
+	return v * Real;
+}
+
+DualQuaternion DualQuaternion::Normal() const
+{
+	float invLen = 1.f / sqrtf(Quaternion::Dot(Real, Real));
+
+	DualQuaternion result;
+	result.Real = Quaternion::Unchecked(Real.w * invLen, Real.x * invLen, Real.y * invLen, Real.z * invLen);
+	result.Dual = Quaternion::Unchecked(Dual.w * invLen, Dual.x * invLen, Dual.y * invLen, Dual.z * invLen);
+	return result;
+}
+
+void DualQuaternion::TransformPoints(const Vec3* points, Vec3* out, std::size_t n) const
+{
+	// Rotating is the expensive bit, and Quaternion already has a vectorized kernel for it
+	Real.RotateMany(points, out, n);
+
+	Vec3 t = GetTranslation();
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		out[i] += t;
+	}
+}
+
+DualQuaternion DualQuaternion::Blend(const DualQuaternion* dq, const float* weights, std::size_t count)
+{
+	float acc[8] = {};
+	for (std::size_t i = 0u; i < count; i++)
+	{
+		float w = Quaternion::Dot(dq[0].Real, dq[i].Real) < 0.f ? -weights[i] : weights[i];
+		acc[0] += w * dq[i].Real.x; acc[1] += w * dq[i].Real.y; acc[2] += w * dq[i].Real.z; acc[3] += w * dq[i].Real.w;
+		acc[4] += w * dq[i].Dual.x; acc[5] += w * dq[i].Dual.y; acc[6] += w * dq[i].Dual.z; acc[7] += w * dq[i].Dual.w;
+	}
+
+	DualQuaternion result;
+	result.Real = Quaternion::Unchecked(acc[3], acc[0], acc[1], acc[2]);
+	result.Dual = Quaternion::Unchecked(acc[7], acc[4], acc[5], acc[6]);
+	return result.Normal();
+}
+
+void DualQuaternion::BlendMany(const DualQuaternion* palette, const std::uint32_t* boneIndices, const float* boneWeights, DualQuaternion* out, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		out[i] = BlendInfluences(palette, boneIndices + i * InfluencesPerVertex, boneWeights + i * InfluencesPerVertex);
+	}
+}
+
+void DualQuaternion::SkinMany(const DualQuaternion* palette, const std::uint32_t* boneIndices, const float* boneWeights,
+	const Vec3* points, const Vec3* normals, Vec3* outPoints, Vec3* outNormals, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		DualQuaternion dq = BlendInfluences(palette, boneIndices + i * InfluencesPerVertex, boneWeights + i * InfluencesPerVertex);
+		outPoints[i] = dq.TransformPoint(points[i]);
+		if (normals)
+		{
+			outNormals[i] = dq.TransformVector(normals[i]);
+		}
+	}
+}
+
+};
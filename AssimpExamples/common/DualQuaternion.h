@@ -0,0 +1,82 @@
+#pragma once
+
+// Dual quaternions - a rotation and a translation, packed together into eight floats.
+// Matrices are the usual way to skin a mesh (blend each vertex's bone matrices by weight,
+//  then transform), but a weighted average of rotation matrices isn't a rotation any more.
+//  Twist a joint far enough and the mesh collapses in on itself - the "candy wrapper".
+// Dual quaternions blend much more gracefully: add them up by weight, normalize, and the
+//  result is always a proper rigid transform. It's also half the numbers to blend
+//  (eight floats instead of twelve or sixteen per bone).
+// Kavan et al, "Skinning with Dual Quaternions" (2007)
+// https://www.cs.utah.edu/~ladislav/kavan07skinning/kavan07skinning.pdf
+
+#include <Transform.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sess
+{
+
+struct DualQuaternion
+{
+public:
+	Quaternion Real; // The rotation
+	Quaternion Dual; // Half of the translation (as a quaternion with w = 0) times the rotation
+
+public:
+	// No rotation, no translation
+	constexpr DualQuaternion() : Real(), Dual(Quaternion::Unchecked(0.f, 0.f, 0.f, 0.f)) {}
+	DualQuaternion(const Quaternion& rotation, const Vec3& translation);
+	DualQuaternion(const DualQuaternion&) = default;
+	~DualQuaternion() = default;
+
+	// Dual quaternions can only hold rigid transforms, so scale is dropped on the way in,
+	//  and comes back out as 1. Skeletons with scaled bones need matrices (or to bake the
+	//  scale into the bind pose).
+	static DualQuaternion FromTransform(const Transform& transform);
+	Transform ToTransform() const;
+
+	Quaternion GetRotation() const;
+	Vec3 GetTranslation() const;
+
+	// Same order as Transform::operator* - o is applied first, then this
+	DualQuaternion operator*(const DualQuaternion& o) const;
+
+	Vec3 TransformPoint(const Vec3& p) const;
+	Vec3 TransformVector(const Vec3& v) const; // Rotation only - for normals and directions
+
+	// Blending leaves the result a little off of unit length, this puts it back
+	DualQuaternion Normal() const;
+
+	// out[i] = TransformPoint(points[i]). out may be the same array as points.
+	void TransformPoints(const Vec3* points, Vec3* out, std::size_t n) const;
+
+	// Weighted blend of count dual quaternions, normalized (dual quaternion linear blending).
+	// q and -q are the same rotation, so each one is flipped to the same side as the first
+	//  before adding - otherwise the blend can take the long way around.
+	// The weights need to add up to something other than 0.
+	static DualQuaternion Blend(const DualQuaternion* dq, const float* weights, std::size_t count);
+
+	//
+	// Skinning - every vertex has InfluencesPerVertex bones, given as indices into palette
+	//  and matching weights (boneIndices[4 * i + k] and boneWeights[4 * i + k] for vertex i).
+	//  Unused influences can point at any bone with a weight of 0.
+	//
+	static const std::size_t InfluencesPerVertex = 4u;
+
+	// out[i] = the blend of vertex i's influences. One bone is one AVX register (or two
+	//  SSE ones), so the blend is a handful of multiply-adds per vertex.
+	static void BlendMany(const DualQuaternion* palette, const std::uint32_t* boneIndices, const float* boneWeights, DualQuaternion* out, std::size_t n);
+
+	// Blends each vertex's influences and transforms its position (and normal, if normals
+	//  isn't null) in one pass, without storing the blended dual quaternions anywhere.
+	// outPoints/outNormals may be the same arrays as points/normals.
+	static void SkinMany(const DualQuaternion* palette, const std::uint32_t* boneIndices, const float* boneWeights,
+		const Vec3* points, const Vec3* normals, Vec3* outPoints, Vec3* outNormals, std::size_t n);
+
+public:
+	static const DualQuaternion Identity;
+};
+
+};
@@ -12,18 +12,44 @@ FreeCamera::FreeCamera(const Vec3& position, const Vec3& lookAt, const Vec3& up)
 	, forward_((lookAt - position).Normal())
 	, up_(up.Normal())
 	, right_(Vec3::Cross(up, lookAt - position).Normal())
-	, dViewMatrix_({ Matrix::Identity, true })
+	, proj_(Matrix::Identity)
+	, dFrameBlock_({ { Matrix::Identity, Matrix::Identity, Matrix::Identity, Matrix::Identity, Vec3::Zero, 1.f }, true, 0u })
 {}
 
-Matrix FreeCamera::GetViewMatrix()
+const FreeCamera::FrameBlock& FreeCamera::GetFrameBlock()
 {
-	if (dViewMatrix_.isDirty)
+	if (dFrameBlock_.isDirty)
 	{
-		dViewMatrix_.viewMatrix = LookAtLH(position_, position_ + forward_, up_);
-		dViewMatrix_.isDirty = false;
+		FrameBlock& block = dFrameBlock_.frameBlock;
+		block.View = LookAtLH(position_, position_ + forward_, up_);
+		block.Proj = proj_;
+		block.ViewProj = block.View * block.Proj;
+		block.InverseView = block.View.AffineInverse();
+		block.Position = position_;
+		block.__one = 1.f;
+
+		dFrameBlock_.isDirty = false;
+		dFrameBlock_.revision++;
 	}
 
-	return dViewMatrix_.viewMatrix;
+	return dFrameBlock_.frameBlock;
+}
+
+Matrix FreeCamera::GetViewMatrix()
+{
+	return GetFrameBlock().View;
+}
+
+std::uint32_t FreeCamera::GetFrameBlockRevision() const
+{
+	return dFrameBlock_.revision;
+}
+
+void FreeCamera::SetProjection(const Matrix& proj)
+{
+	proj_ = proj;
+
+	dFrameBlock_.isDirty = true;
 }
 
 Vec3 FreeCamera::GetPosition() const
@@ -38,39 +64,41 @@ void FreeCamera::MoveForward(float distance)
 	// At least, it did for me. Move the position in the direction of forward by some distance "distance"
 	position_ += forward_ * distance;
 
-	dViewMatrix_.isDirty = true;
+	dFrameBlock_.isDirty = true;
 }
 
 void FreeCamera::MoveRight(float distance)
 {
 	position_ += right_ * distance;
 
-	dViewMatrix_.isDirty = true;
+	dFrameBlock_.isDirty = true;
 }
 
 void FreeCamera::MoveUp(float distance)
 {
 	position_ += up_ * distance;
 
-	dViewMatrix_.isDirty = true;
+	dFrameBlock_.isDirty = true;
 }
 
 void FreeCamera::RotateRight(float angle)
 {
-	// The up axis doesn't change, so just rotate about that
-	Quaternion rotation(up_, angle);
-	forward_ = (forward_ * rotation).Normal();
+	// The up axis doesn't change, so just rotate about that.
+	// This runs every frame the mouse moves, and forward_/right_ get renormalized every
+	//  time anyways, so the fast trig/rsqrt is plenty (MathPolicy.h).
+	Quaternion rotation = Quaternion::FromAxisAngle<FastMath>(up_, angle);
+	forward_ = (forward_ * rotation).Normal<FastMath>();
 
-	right_ = Vec3::Cross(up_, forward_).Normal();
+	right_ = Vec3::Cross(up_, forward_).Normal<FastMath>();
 
-	dViewMatrix_.isDirty = true;
+	dFrameBlock_.isDirty = true;
 }
 
 void FreeCamera::RotateUp(float angle)
 {
 	// The right axis should be parallel to the ground, so it can safely be used.
-	Quaternion rotation(right_, angle);
-	Vec3 newForward = (forward_ * rotation).Normal();
+	Quaternion rotation = Quaternion::FromAxisAngle<FastMath>(right_, angle);
+	Vec3 newForward = (forward_ * rotation).Normal<FastMath>();
 
 	if (Vec3::Cross(newForward, up_).Magnitude() < 0.01f)
 	{
@@ -78,9 +106,9 @@ void FreeCamera::RotateUp(float angle)
 		return;
 	}
 	forward_ = newForward;
-	right_ = Vec3::Cross(up_, forward_).Normal();
+	right_ = Vec3::Cross(up_, forward_).Normal<FastMath>();
 
-	dViewMatrix_.isDirty = true;
+	dFrameBlock_.isDirty = true;
 }
 
 };
\ No newline at end of file
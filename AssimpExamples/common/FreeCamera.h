@@ -8,6 +8,8 @@
 #include <Vec3.h>
 #include <Matrix.h>
 
+#include <cstdint>
+
 namespace sess
 {
 
@@ -21,9 +23,33 @@ public:
 	FreeCamera(const FreeCamera&) = delete;
 	~FreeCamera() = default;
 
-	Matrix GetViewMatrix(); // May invalidate a cache, so cannot be const
+	// Everything the shaders need to know about the camera for a frame, in one place.
+	// This is worked out once, the first time it's asked for after the camera moves, and
+	//  then every shader can share it instead of each one redoing the same work.
+	// Matrices are in the default (column major) layout, and Position is followed by a 1,
+	//  so the whole block can be copied straight into a constant buffer.
+	struct FrameBlock
+	{
+		Matrix View;
+		Matrix Proj;
+		Matrix ViewProj;
+		Matrix InverseView;
+		Vec3 Position;
+		float __one; // Pads the block out to 16 bytes, and makes Position a proper point
+	};
+
+	// Same as before, the getters may regenerate a cache, so they cannot be const
+	const FrameBlock& GetFrameBlock();
+	Matrix GetViewMatrix();
 	Vec3 GetPosition() const;
 
+	// Goes up by one every time the frame block is regenerated, so things that copy it
+	//  somewhere (like a GPU constant buffer) can tell if their copy is out of date.
+	std::uint32_t GetFrameBlockRevision() const;
+
+	// The camera doesn't pick a projection itself (Identity until set)
+	void SetProjection(const Matrix& proj);
+
 	void MoveForward(float distance);
 	void MoveRight(float distance);
 	void MoveUp(float distance);
@@ -37,15 +63,18 @@ private:
 	Vec3 up_;
 	Vec3 right_;
 
+	Matrix proj_;
+
 	// I like the dirtyable pattern here. This struct stores information
-	//  both about the view matrix and a flag indicating if the view matrix
-	//  is up to date or not - isDirty will be true if the view matrix needs re-generation
+	//  both about the frame block and a flag indicating if the frame block
+	//  is up to date or not - isDirty will be true if the block needs re-generation
 	// Anonymous structs are fine for that :-)
 	struct
 	{
-		Matrix viewMatrix;
+		FrameBlock frameBlock;
 		bool isDirty;
-	} dViewMatrix_;
+		std::uint32_t revision;
+	} dFrameBlock_;
 };
 
 };
\ No newline at end of file
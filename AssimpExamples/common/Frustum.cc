@@ -0,0 +1,241 @@
+#include <Frustum.h>
+
+#include <cmath>
+
+namespace sess
+{
+
+namespace
+{
+
+Plane MakePlane(float a, float b, float c, float d)
+{
+	float invLength = 1.f / sqrtf(a * a + b * b + c * c);
+	return Plane(Vec3(a * invLength, b * invLength, c * invLength), d * invLength);
+}
+
+// Row vectors: clip = (x, y, z, 1) * M, so clip.x is the dot product with column 1 of M,
+//  clip.w with column 4, etc. A point is inside when -w <= x <= w, -w <= y <= w and
+//  0 <= z <= w (Direct3D depth range), and each of those inequalities is one plane.
+// Column j is (M._1j, M._2j, M._3j, M._4j) - the first three are the plane normal.
+template <typename Layout>
+Plane ColumnPlane(const MatrixT<Layout>& m, int col, float sign)
+{
+	return MakePlane(
+		m.At(0, 3) + sign * m.At(0, col),
+		m.At(1, 3) + sign * m.At(1, col),
+		m.At(2, 3) + sign * m.At(2, col),
+		m.At(3, 3) + sign * m.At(3, col));
+}
+
+template <typename Layout>
+void ExtractPlanes(const MatrixT<Layout>& m, Plane* planes)
+{
+	planes[Frustum::Left] = ColumnPlane(m, 0, 1.f);
+	planes[Frustum::Right] = ColumnPlane(m, 0, -1.f);
+	planes[Frustum::Bottom] = ColumnPlane(m, 1, 1.f);
+	planes[Frustum::Top] = ColumnPlane(m, 1, -1.f);
+	planes[Frustum::Near] = MakePlane(m.At(0, 2), m.At(1, 2), m.At(2, 2), m.At(3, 2));
+	planes[Frustum::Far] = ColumnPlane(m, 2, -1.f);
+}
+
+// Scalar tests, also used for the leftovers after the SIMD loops
+bool SphereVisible(const Plane* planes, float x, float y, float z, float r)
+{
+	for (int p = 0; p < Frustum::PlaneCount; p++)
+	{
+		const Vec3& n = planes[p].Normal;
+		if (n.x * x + n.y * y + n.z * z + planes[p].D + r < 0.f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// The box corner furthest along the plane normal is |n| . extent away from the center,
+//  so a box is outside if that corner is.
+bool BoxVisible(const Plane* planes, float cx, float cy, float cz, float ex, float ey, float ez)
+{
+	for (int p = 0; p < Frustum::PlaneCount; p++)
+	{
+		const Vec3& n = planes[p].Normal;
+		float r = fabsf(n.x) * ex + fabsf(n.y) * ey + fabsf(n.z) * ez;
+		if (n.x * cx + n.y * cy + n.z * cz + planes[p].D + r < 0.f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+#if defined(SESS_SIMD_SSE)
+// Returns a bitmask with a bit set for every lane that is outside of at least one plane.
+// Volumes are the SoA streams starting at i - one lane per volume, so every plane is
+//  tested against Lanes::Width volumes at once. Same math as SphereVisible/BoxVisible.
+template <typename Lanes>
+int OutsideSpheres(const Plane* planes, const BoundingSphereSoA& s, std::size_t i)
+{
+	typedef typename Lanes::V V;
+
+	V x = Lanes::Load(&s.Center.X[i]);
+	V y = Lanes::Load(&s.Center.Y[i]);
+	V z = Lanes::Load(&s.Center.Z[i]);
+	V r = Lanes::Load(&s.Radius[i]);
+	V zero = Lanes::Set(0.f);
+
+	V outside = zero;
+	for (int p = 0; p < Frustum::PlaneCount; p++)
+	{
+		V d = Lanes::Add(
+			Lanes::Add(Lanes::Mul(Lanes::Set(planes[p].Normal.x), x), Lanes::Mul(Lanes::Set(planes[p].Normal.y), y)),
+			Lanes::Add(Lanes::Mul(Lanes::Set(planes[p].Normal.z), z), Lanes::Set(planes[p].D)));
+		outside = Lanes::Or(outside, Lanes::CmpLt(Lanes::Add(d, r), zero));
+	}
+
+	return Lanes::MoveMask(outside);
+}
+
+template <typename Lanes>
+int OutsideBoxes(const Plane* planes, const AABBSoA& b, std::size_t i)
+{
+	typedef typename Lanes::V V;
+
+	V cx = Lanes::Load(&b.Center.X[i]);
+	V cy = Lanes::Load(&b.Center.Y[i]);
+	V cz = Lanes::Load(&b.Center.Z[i]);
+	V ex = Lanes::Load(&b.Extent.X[i]);
+	V ey = Lanes::Load(&b.Extent.Y[i]);
+	V ez = Lanes::Load(&b.Extent.Z[i]);
+	V zero = Lanes::Set(0.f);
+
+	V outside = zero;
+	for (int p = 0; p < Frustum::PlaneCount; p++)
+	{
+		const Vec3& n = planes[p].Normal;
+		V d = Lanes::Add(
+			Lanes::Add(Lanes::Mul(Lanes::Set(n.x), cx), Lanes::Mul(Lanes::Set(n.y), cy)),
+			Lanes::Add(Lanes::Mul(Lanes::Set(n.z), cz), Lanes::Set(planes[p].D)));
+		V r = Lanes::Add(
+			Lanes::Add(Lanes::Mul(Lanes::Set(fabsf(n.x)), ex), Lanes::Mul(Lanes::Set(fabsf(n.y)), ey)),
+			Lanes::Mul(Lanes::Set(fabsf(n.z)), ez));
+		outside = Lanes::Or(outside, Lanes::CmpLt(Lanes::Add(d, r), zero));
+	}
+
+	return Lanes::MoveMask(outside);
+}
+
+// Expands an "outside" bitmask into visible bytes, returns how many were visible
+template <typename Lanes>
+std::size_t WriteVisible(int outsideMask, std::uint8_t* visible)
+{
+	std::size_t count = 0u;
+	for (std::size_t lane = 0u; lane < Lanes::Width; lane++)
+	{
+		std::uint8_t v = ((outsideMask >> lane) & 1) ? 0u : 1u;
+		visible[lane] = v;
+		count += v;
+	}
+	return count;
+}
+#endif
+
+void AddStats(CullStats* stats, std::size_t tested, std::size_t visible)
+{
+	if (stats)
+	{
+		stats->Tested += (std::uint32_t)tested;
+		stats->Rejected += (std::uint32_t)(tested - visible);
+	}
+}
+
+};
+
+Frustum::Frustum(const MatrixT<RowMajor>& viewProj)
+{
+	ExtractPlanes(viewProj, Planes);
+}
+
+Frustum::Frustum(const MatrixT<ColumnMajor>& viewProj)
+{
+	ExtractPlanes(viewProj, Planes);
+}
+
+Frustum::Frustum(const Matrix& view, const Matrix& proj)
+	: Frustum(view * proj)
+{}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const
+{
+	return SphereVisible(Planes, sphere.Center.x, sphere.Center.y, sphere.Center.z, sphere.Radius);
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+	if (box.IsEmpty())
+	{
+		return false;
+	}
+
+	Vec3 c = box.Center();
+	Vec3 e = box.Extent();
+	return BoxVisible(Planes, c.x, c.y, c.z, e.x, e.y, e.z);
+}
+
+std::size_t Frustum::Cull(const BoundingSphereSoA& spheres, std::uint8_t* visible, CullStats* stats) const
+{
+	std::size_t n = spheres.Size();
+	std::size_t count = 0u;
+	std::size_t i = 0u;
+
+#if defined(SESS_SIMD_AVX)
+	for (; i + AvxLanes::Width <= n; i += AvxLanes::Width)
+	{
+		count += WriteVisible<AvxLanes>(OutsideSpheres<AvxLanes>(Planes, spheres, i), visible + i);
+	}
+#endif
+#if defined(SESS_SIMD_SSE)
+	for (; i + SseLanes::Width <= n; i += SseLanes::Width)
+	{
+		count += WriteVisible<SseLanes>(OutsideSpheres<SseLanes>(Planes, spheres, i), visible + i);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		visible[i] = SphereVisible(Planes, spheres.Center.X[i], spheres.Center.Y[i], spheres.Center.Z[i], spheres.Radius[i]) ? 1u : 0u;
+		count += visible[i];
+	}
+
+	AddStats(stats, n, count);
+	return count;
+}
+
+std::size_t Frustum::Cull(const AABBSoA& boxes, std::uint8_t* visible, CullStats* stats) const
+{
+	std::size_t n = boxes.Size();
+	std::size_t count = 0u;
+	std::size_t i = 0u;
+
+#if defined(SESS_SIMD_AVX)
+	for (; i + AvxLanes::Width <= n; i += AvxLanes::Width)
+	{
+		count += WriteVisible<AvxLanes>(OutsideBoxes<AvxLanes>(Planes, boxes, i), visible + i);
+	}
+#endif
+#if defined(SESS_SIMD_SSE)
+	for (; i + SseLanes::Width <= n; i += SseLanes::Width)
+	{
+		count += WriteVisible<SseLanes>(OutsideBoxes<SseLanes>(Planes, boxes, i), visible + i);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		visible[i] = BoxVisible(Planes, boxes.Center.X[i], boxes.Center.Y[i], boxes.Center.Z[i], boxes.Extent.X[i], boxes.Extent.Y[i], boxes.Extent.Z[i]) ? 1u : 0u;
+		count += visible[i];
+	}
+
+	AddStats(stats, n, count);
+	return count;
+}
+
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+// View frustum - the chunk of space that the camera can actually see, bounded by six planes.
+// Anything completely outside of any one of those planes is off screen, and doesn't need
+//  to be sent to the GPU at all. That's frustum culling, and it's the cheapest way there
+//  is to draw less stuff.
+// https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+
+#include <Bounds.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sess
+{
+
+// Running totals for culling, so the demos can show how much work was skipped.
+// Reset it once per frame (or don't, and get totals since startup)
+struct CullStats
+{
+public:
+	std::uint32_t Tested;
+	std::uint32_t Rejected;
+
+public:
+	CullStats() : Tested(0u), Rejected(0u) {}
+	void Reset() { Tested = 0u; Rejected = 0u; }
+};
+
+// Plane in the form Normal . p + D = 0. The normal points towards the inside of the frustum.
+struct Plane
+{
+public:
+	Vec3 Normal;
+	float D;
+
+public:
+	Plane() : Normal(0.f, 0.f, 0.f), D(0.f) {}
+	Plane(const Vec3& normal, float d) : Normal(normal), D(d) {}
+
+	// Signed distance - positive on the side the normal points to. Only a true
+	//  distance if the normal is unit length (Frustum normalizes its planes).
+	float Distance(const Vec3& p) const { return Vec3::Dot(Normal, p) + D; }
+};
+
+class Frustum
+{
+public:
+	enum PlaneIndex
+	{
+		Left = 0,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		PlaneCount
+	};
+
+	Plane Planes[PlaneCount];
+
+public:
+	// Extracts the planes from a combined view * projection matrix (i.e. the ViewProj in
+	//  FreeCamera's frame block). Either layout works - the planes are read out through At().
+	// The planes end up in world space, so world space bounds can be tested against them.
+	explicit Frustum(const MatrixT<RowMajor>& viewProj);
+	explicit Frustum(const MatrixT<ColumnMajor>& viewProj);
+	Frustum(const Matrix& view, const Matrix& proj);
+	Frustum(const Frustum&) = default;
+	~Frustum() = default;
+
+	// Single volume tests - true if any part of the volume might be visible
+	bool Intersects(const BoundingSphere& sphere) const;
+	bool Intersects(const AABB& box) const;
+
+	// Batch tests - four (SSE) or eight (AVX) volumes against each plane per instruction.
+	// visible[i] is set to 1 if volume i might be visible, 0 if it definitely isn't.
+	//  visible must have room for Size() entries. Returns the number of visible volumes.
+	// If stats is given, the results are added to it.
+	std::size_t Cull(const BoundingSphereSoA& spheres, std::uint8_t* visible, CullStats* stats = nullptr) const;
+	std::size_t Cull(const AABBSoA& boxes, std::uint8_t* visible, CullStats* stats = nullptr) const;
+};
+
+};
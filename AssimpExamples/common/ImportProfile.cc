@@ -0,0 +1,297 @@
+#include <ImportProfile.h>
+
+#include <assimp/DefaultLogger.hpp>
+#include <assimp/Importer.hpp>
+#include <assimp/LogStream.hpp>
+#include <assimp/ProgressHandler.hpp>
+#include <assimp/postprocess.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace sess
+{
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+double Milliseconds(Clock::time_point from, Clock::time_point to)
+{
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+//
+// Where the time goes during one import. Everything here happens on the importing thread.
+//
+class StepRecorder
+{
+public:
+	StepRecorder()
+		: thread_(std::this_thread::get_id())
+		, start_(Clock::now())
+		, firstStep_(start_)
+		, stepStart_(start_)
+		, openStep_()
+		, anySteps_(false)
+		, steps_()
+	{}
+
+	std::thread::id Thread() const { return thread_; }
+	const std::string& OpenStep() const { return openStep_; }
+
+	void Begin(const std::string& name)
+	{
+		End();
+
+		Clock::time_point now = Clock::now();
+		if (!anySteps_)
+		{
+			firstStep_ = now;
+			anySteps_ = true;
+		}
+		openStep_ = name;
+		stepStart_ = now;
+	}
+
+	void End()
+	{
+		if (!openStep_.empty())
+		{
+			steps_.push_back({ openStep_, Milliseconds(stepStart_, Clock::now()) });
+			openStep_.clear();
+		}
+	}
+
+	// Parse is everything up to the first step - or all of it, if there weren't any steps (or
+	//  nothing could see them). Anything left over between steps is "other".
+	void Finish(ImportTiming& timing)
+	{
+		End();
+		Clock::time_point now = Clock::now();
+
+		timing.TotalMilliseconds = Milliseconds(start_, now);
+		timing.Steps.clear();
+		timing.Steps.push_back({ "parse", Milliseconds(start_, anySteps_ ? firstStep_ : now) });
+
+		double accounted = timing.Steps[0].Milliseconds;
+		for (auto&& step : steps_)
+		{
+			timing.Steps.push_back(step);
+			accounted += step.Milliseconds;
+		}
+		if (timing.TotalMilliseconds - accounted > 0.05)
+		{
+			timing.Steps.push_back({ "other", timing.TotalMilliseconds - accounted });
+		}
+	}
+
+protected:
+	std::thread::id thread_;
+	Clock::time_point start_;
+	Clock::time_point firstStep_;
+	Clock::time_point stepStart_;
+	std::string openStep_;
+	bool anySteps_;
+	std::vector<ImportStepTime> steps_;
+};
+
+std::atomic<bool> stepTimingEnabled(false);
+std::mutex timedImportMutex; // Held for the whole of a timed import
+std::atomic<StepRecorder*> activeRecorder(nullptr);
+
+//
+// Assimp's hooks
+//
+
+// Steps announce themselves with a "<Step> begin" debug message, and most say
+//  "<Step> finished ..." at the end. DefaultLogger puts "Debug, T1234: " in front of
+//  everything and a newline after.
+class StepLogStream : public Assimp::LogStream
+{
+public:
+	void write(const char* message) override
+	{
+		StepRecorder* recorder = activeRecorder.load();
+		if (!recorder || recorder->Thread() != std::this_thread::get_id())
+		{
+			return; // Somebody else's import - not one that's being timed
+		}
+
+		const char* text = strstr(message, ": ");
+		text = text ? text + 2 : message;
+		std::string line(text);
+		while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+		{
+			line.pop_back();
+		}
+
+		std::size_t space = line.find(' ');
+		if (space == std::string::npos)
+		{
+			return;
+		}
+		std::string name = line.substr(0u, space);
+		std::string rest = line.substr(space + 1u);
+
+		if (rest == "begin")
+		{
+			recorder->Begin(name);
+		}
+		else if (name == recorder->OpenStep() && (rest.compare(0u, 8u, "finished") == 0 || rest.compare(0u, 3u, "end") == 0))
+		{
+			recorder->End();
+		}
+	}
+};
+
+// Assimp calls Update() after running each step. Steps that didn't say they finished end here.
+class StepProgressHandler : public Assimp::ProgressHandler
+{
+public:
+	bool Update(float /* percentage */) override
+	{
+		StepRecorder* recorder = activeRecorder.load();
+		if (recorder && recorder->Thread() == std::this_thread::get_id())
+		{
+			recorder->End();
+		}
+		return true; // Keep going
+	}
+};
+
+// A verbose DefaultLogger (Assimp only sends debug messages to one of those) with a
+//  StepLogStream on it, for as long as one of these is around. Only made with
+//  timedImportMutex held, so there's never more than one at a time. Whatever logger was
+//  there before goes back the way it was afterwards, so imports that aren't being timed
+//  don't pay for formatting every debug message.
+class StepLogInstall
+{
+public:
+	StepLogInstall()
+		: stream_(new StepLogStream())
+		, createdLogger_(Assimp::DefaultLogger::isNullLogger())
+		, previousSeverity_(Assimp::Logger::NORMAL)
+	{
+		if (createdLogger_)
+		{
+			// No log file, no debugger output - just the stream
+			Assimp::DefaultLogger::create("", Assimp::Logger::VERBOSE, 0u);
+		}
+		else
+		{
+			previousSeverity_ = Assimp::DefaultLogger::get()->getLogSeverity();
+			Assimp::DefaultLogger::get()->setLogSeverity(Assimp::Logger::VERBOSE);
+		}
+		Assimp::DefaultLogger::get()->attachStream(stream_, StreamSeverity);
+	}
+
+	~StepLogInstall()
+	{
+		if (createdLogger_)
+		{
+			// The logger deletes its streams when it goes
+			Assimp::DefaultLogger::kill();
+		}
+		else
+		{
+			// Detaching hands the stream back to whoever attached it
+			Assimp::DefaultLogger::get()->detatchStream(stream_, StreamSeverity);
+			delete stream_;
+			Assimp::DefaultLogger::get()->setLogSeverity(previousSeverity_);
+		}
+	}
+
+	StepLogInstall(const StepLogInstall&) = delete;
+	StepLogInstall& operator=(const StepLogInstall&) = delete;
+
+protected:
+	static const unsigned int StreamSeverity = Assimp::Logger::Debugging | Assimp::Logger::Info;
+
+	StepLogStream* stream_;
+	bool createdLogger_;
+	Assimp::Logger::LogSeverity previousSeverity_;
+};
+
+};
+
+unsigned int ImportProfileFlags(ImportProfile profile)
+{
+	switch (profile)
+	{
+	case ImportProfile::Fast:
+		return aiProcess_Triangulate
+			| aiProcess_JoinIdenticalVertices
+			| aiProcess_GenNormals
+			| aiProcess_SortByPType;
+	case ImportProfile::Max:
+		return aiProcessPreset_TargetRealtime_MaxQuality;
+	case ImportProfile::Default:
+	default:
+		return aiProcess_Triangulate
+			| aiProcess_JoinIdenticalVertices
+			| aiProcess_GenSmoothNormals
+			| aiProcess_GenUVCoords
+			| aiProcess_SortByPType
+			| aiProcess_FindDegenerates
+			| aiProcess_FindInvalidData
+			| aiProcess_ImproveCacheLocality;
+	}
+}
+
+void SetImportStepTiming(bool enabled)
+{
+	stepTimingEnabled = enabled;
+}
+
+bool ImportStepTimingEnabled()
+{
+	return stepTimingEnabled;
+}
+
+const aiScene* ReadFileWithStepTiming(Assimp::Importer& importer, const char* file, unsigned int flags, ImportTiming& timing)
+{
+	if (!ImportStepTimingEnabled())
+	{
+		Clock::time_point start = Clock::now();
+		const aiScene* scene = importer.ReadFile(file, flags);
+		timing.TotalMilliseconds = Milliseconds(start, Clock::now());
+		timing.Steps.assign(1u, { "parse", timing.TotalMilliseconds });
+		return scene;
+	}
+
+	std::lock_guard<std::mutex> lock(timedImportMutex);
+	StepLogInstall logging;
+
+	// The importer deletes its progress handler when it goes
+	importer.SetProgressHandler(new StepProgressHandler());
+
+	StepRecorder recorder;
+	activeRecorder = &recorder;
+	const aiScene* scene = importer.ReadFile(file, flags);
+	activeRecorder = nullptr;
+
+	recorder.Finish(timing);
+	return scene;
+}
+
+void ImportTiming::Report(std::ostream& o, const char* what) const
+{
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%.1f ms", TotalMilliseconds);
+	o << "Imported " << what << " in " << buffer;
+
+	for (std::size_t i = 0u; i < Steps.size(); i++)
+	{
+		snprintf(buffer, sizeof(buffer), "%.1f ms", Steps[i].Milliseconds);
+		o << (i == 0u ? " (" : ", ") << Steps[i].Name << " " << buffer;
+	}
+	o << (Steps.empty() ? "" : ")") << std::endl;
+}
+
+};
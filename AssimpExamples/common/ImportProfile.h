@@ -0,0 +1,80 @@
+#pragma once
+
+// Which Assimp post-processing steps to run on import, and how long each of them took.
+// The loaders all used to import with aiProcessPreset_TargetRealtime_MaxQuality, which is
+//  everything Assimp has for real time use - including steps that make things the demos
+//  never look at (tangents and bitangents, with no normal maps anywhere), steps that redo what
+//  cooking already does (SplitLargeMeshes, when SplitForShortIndices handles big meshes
+//  better), and ValidateDataStructure, which checks the whole scene over again. The profiles:
+//  - Fast:    triangles, joined vertices and flat normals. Enough to draw, and nothing else.
+//  - Default: what the shaders' vertex formats actually use - smooth normals, UVs, vertex
+//             cache ordering, and throwing out broken triangles and data.
+//  - Max:     aiProcessPreset_TargetRealtime_MaxQuality, same as before.
+// A cooked model remembers the flags it was imported with (see CookedModel.h), so changing an
+//  asset's profile cooks it again on the next start up.
+//
+// To find out where import time goes, turn on step timing (SetImportStepTiming). Every import
+//  that goes through ReadFileWithStepTiming after that gets split up into the raw parse, then
+//  each post-processing step, by listening to the same hooks Assimp gives everybody:
+//  - each step writes "<Step> begin" to Assimp's log (which needs a verbose DefaultLogger -
+//    that gets set up for the length of each timed import, and whatever logger was there
+//    before is put back after)
+//  - the importer's ProgressHandler gets an Update() after each step
+//  "Imported road.fbx in 81.2 ms (parse 40.3 ms, JoinVerticesProcess 18.0 ms, ...)"
+// Assimp's logger isn't made for more than one import writing to it at a time, so timed
+//  imports take turns - which is what you want for timing them anyways, but it does mean
+//  step timing is a thing to turn on while looking, and leave off otherwise.
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct aiScene;
+
+namespace Assimp
+{
+class Importer;
+};
+
+namespace sess
+{
+
+enum class ImportProfile
+{
+	Fast,
+	Default,
+	Max,
+};
+
+// aiPostProcessSteps flags for a profile
+unsigned int ImportProfileFlags(ImportProfile profile);
+
+struct ImportStepTime
+{
+public:
+	std::string Name;
+	double Milliseconds;
+};
+
+struct ImportTiming
+{
+public:
+	double TotalMilliseconds;
+	std::vector<ImportStepTime> Steps; // "parse" first, then each post-processing step in order, then "other"
+
+public:
+	ImportTiming() : TotalMilliseconds(0.0) {}
+
+	void Report(std::ostream& o, const char* what) const;
+};
+
+// Off to start with
+void SetImportStepTiming(bool enabled);
+bool ImportStepTimingEnabled();
+
+// importer.ReadFile(file, flags), with how long each part of it took in timing. Works with
+//  step timing off too - everything just counts as "parse".
+const aiScene* ReadFileWithStepTiming(Assimp::Importer& importer, const char* file, unsigned int flags, ImportTiming& timing);
+
+};
@@ -0,0 +1,68 @@
+#include <ImportedScene.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <utility>
+
+namespace sess
+{
+
+ImportedScene::ImportedScene()
+	: importer_()
+	, scene_(nullptr)
+{}
+
+ImportedScene::ImportedScene(ImportedScene&& o)
+	: ImportedScene()
+{
+	*this = std::move(o);
+}
+
+ImportedScene& ImportedScene::operator=(ImportedScene&& o)
+{
+	if (this != &o)
+	{
+		Release();
+		importer_ = std::move(o.importer_);
+		scene_ = o.scene_;
+		o.scene_ = nullptr;
+	}
+	return *this;
+}
+
+ImportedScene::~ImportedScene()
+{
+	Release();
+}
+
+bool ImportedScene::Read(const char* file, unsigned int flags, Assimp::IOSystem* io, ImportTiming* timing)
+{
+	// A fresh importer every time, so an IO handler from last time doesn't stick around
+	Release();
+	importer_.reset(new Assimp::Importer());
+	if (io)
+	{
+		importer_->SetIOHandler(io);
+	}
+
+	ImportTiming ignored;
+	scene_ = ReadFileWithStepTiming(*importer_, file, flags, timing ? *timing : ignored);
+	return scene_ != nullptr;
+}
+
+void ImportedScene::Release()
+{
+	if (importer_)
+	{
+		importer_->FreeScene();
+	}
+	scene_ = nullptr;
+}
+
+std::string ImportedScene::ErrorString() const
+{
+	return importer_ ? importer_->GetErrorString() : "";
+}
+
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+// An Assimp import that cleans up after itself.
+// aiImportFile hands back a scene that stays in memory until somebody calls aiReleaseImport
+//  on it, and nothing makes sure somebody does - an early return, or just forgetting (the
+//  first demo did), and every vertex of the model sits there for the rest of the run.
+//  ImportedScene owns the Assimp::Importer that made the scene, and the scene goes when it
+//  does. Release() lets it go early, the moment nothing needs it any more - the cook does that
+//  as soon as the last mesh is converted, well before the model is drawn.
+//
+//  ImportedScene scene;
+//  if (!scene.Read("./assets/road.fbx", ImportProfileFlags(ImportProfile::Default)))
+//  {
+//      std::cerr << scene.ErrorString() << std::endl;
+//      return false;
+//  }
+//  ... scene->mNumMeshes ...
+//
+// It can't free one mesh at a time while the rest are still being used: Assimp allocated
+//  everything in the scene from inside its own DLL, which (depending on how the DLL and this
+//  code were built) can be a different heap than the one delete uses over here, and Assimp
+//  has no call for freeing part of a scene. The whole thing at once is what it offers.
+
+#include <ImportProfile.h>
+
+#include <memory>
+#include <string>
+
+struct aiScene;
+
+namespace Assimp
+{
+class Importer;
+class IOSystem;
+};
+
+namespace sess
+{
+
+class ImportedScene
+{
+public:
+	ImportedScene();
+	ImportedScene(ImportedScene&& o);
+	ImportedScene& operator=(ImportedScene&& o);
+	ImportedScene(const ImportedScene&) = delete;
+	ImportedScene& operator=(const ImportedScene&) = delete;
+	~ImportedScene();
+
+	// Imports file with the given aiPostProcessSteps flags, replacing whatever scene was here.
+	//  If io is given, files get opened through it (the importer owns it after this - see
+	//  AssetArchive::CreateIOSystem). If timing is given, how long the parse and each step
+	//  took goes in it (see ImportProfile.h). False if the import failed.
+	bool Read(const char* file, unsigned int flags, Assimp::IOSystem* io = nullptr, ImportTiming* timing = nullptr);
+
+	// Frees the scene now, instead of when this goes out of scope
+	void Release();
+
+	const aiScene* Get() const { return scene_; }
+	const aiScene* operator->() const { return scene_; }
+	explicit operator bool() const { return scene_ != nullptr; }
+
+	// Why the last Read failed
+	std::string ErrorString() const;
+
+protected:
+	std::unique_ptr<Assimp::Importer> importer_;
+	const aiScene* scene_;
+};
+
+};
@@ -0,0 +1,198 @@
+#include <MappedFile.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+namespace sess
+{
+
+MappedFile::MappedFile()
+	: data_(nullptr)
+	, size_(0u)
+	, isOpen_(false)
+#if defined(_WIN32)
+	, file_(INVALID_HANDLE_VALUE)
+	, mapping_(nullptr)
+#endif
+{}
+
+MappedFile::MappedFile(MappedFile&& o)
+	: MappedFile()
+{
+	*this = std::move(o);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& o)
+{
+	if (this != &o)
+	{
+		Close();
+		std::swap(data_, o.data_);
+		std::swap(size_, o.size_);
+		std::swap(isOpen_, o.isOpen_);
+#if defined(_WIN32)
+		std::swap(file_, o.file_);
+		std::swap(mapping_, o.mapping_);
+#endif
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(file_, &size))
+	{
+		Close();
+		return false;
+	}
+	size_ = (std::size_t)size.QuadPart;
+	isOpen_ = true;
+
+	// CreateFileMapping refuses empty files - there's nothing to map anyways
+	if (size_ == 0u)
+	{
+		return true;
+	}
+
+	mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_)
+	{
+		Close();
+		return false;
+	}
+
+	data_ = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (!data_)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_)
+	{
+		CloseHandle(mapping_);
+	}
+	if (file_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_);
+	}
+
+	data_ = nullptr;
+	size_ = 0u;
+	isOpen_ = false;
+	file_ = INVALID_HANDLE_VALUE;
+	mapping_ = nullptr;
+}
+
+void MappedFile::Prefetch() const
+{
+	// PrefetchVirtualMemory is Windows 8 and up - anything older just pages in as it goes
+#if _WIN32_WINNT >= 0x0602
+	if (data_)
+	{
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = const_cast<std::uint8_t*>(data_);
+		range.NumberOfBytes = size_;
+		PrefetchVirtualMemory(GetCurrentProcess(), 1u, &range, 0u);
+	}
+#endif
+}
+
+#else
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	size_ = (std::size_t)info.st_size;
+	isOpen_ = true;
+
+	// mmap refuses zero lengths - there's nothing to map anyways
+	if (size_ > 0u)
+	{
+		void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+		{
+			close(fd);
+			size_ = 0u;
+			isOpen_ = false;
+			return false;
+		}
+		data_ = static_cast<const std::uint8_t*>(p);
+	}
+
+	// The mapping holds its own reference to the file
+	close(fd);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_)
+	{
+		munmap(const_cast<std::uint8_t*>(data_), size_);
+	}
+
+	data_ = nullptr;
+	size_ = 0u;
+	isOpen_ = false;
+}
+
+void MappedFile::Prefetch() const
+{
+	if (data_)
+	{
+		madvise(const_cast<std::uint8_t*>(data_), size_, MADV_WILLNEED);
+	}
+}
+
+#endif
+
+};
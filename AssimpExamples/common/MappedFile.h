@@ -0,0 +1,49 @@
+#pragma once
+
+// Read only view of a whole file, mapped into memory by the OS (MapViewOfFile on Windows,
+//  mmap everywhere else).
+// Nothing gets read up front - pages come in from disk (or more likely the OS file cache)
+//  the first time they're touched, and there's no copy into a buffer of our own. For a file
+//  that's about to be handed over to the GPU as-is, that's about as cheap as loading gets.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sess
+{
+
+class MappedFile
+{
+public:
+	MappedFile();
+	MappedFile(MappedFile&& o);
+	MappedFile& operator=(MappedFile&& o);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	// False if the file can't be opened. An empty file opens fine, with Data() == nullptr.
+	bool Open(const char* path);
+	void Close();
+
+	bool IsOpen() const { return isOpen_; }
+	const std::uint8_t* Data() const { return data_; }
+	std::size_t Size() const { return size_; }
+
+	// Asks the OS to start reading the whole file in now, in the background, instead of a page
+	//  at a time as it gets touched. Just a hint - it's fine if nothing happens.
+	void Prefetch() const;
+
+protected:
+	const std::uint8_t* data_;
+	std::size_t size_;
+	bool isOpen_;
+
+#if defined(_WIN32)
+	// HANDLEs, kept as void* so windows.h stays out of the header
+	void* file_;
+	void* mapping_;
+#endif
+};
+
+};
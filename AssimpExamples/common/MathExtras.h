@@ -14,18 +14,76 @@
 #include <Quaternion.h>
 #include <Color.h>
 
+#include <cmath>
+
 namespace sess
 {
 
-const float PI = 3.141592653f;
-
-// Operators
-Vec3 operator*(const Vec3&, const Quaternion&);
+constexpr float PI = 3.141592653f;
 
 // Helper methods
-Matrix PerspectiveLH(float fovY, float aspect, float nearZ, float farZ);
-Matrix LookAtLH(const Vec3& pos, const Vec3& lookAt, const Vec3& up);
-float Radians(float angle);
-float Degrees(float radians);
+constexpr float Radians(float angle) { return angle * PI / 180.f; }
+constexpr float Degrees(float radians) { return radians * 180.f / PI; }
+
+// Everything below used to live in MathExtras.cc, but it's on the per-frame path (camera
+//  updates) and the per-vertex path (model loading), so it's all inline now.
+
+// http://gamedev.stackexchange.com/questions/28395/rotating-vector3-by-a-quaternion
+// For a unit quaternion (u, s), that works out to v + 2s(u x v) + 2u x (u x v).
+//  Written as t = 2(u x v), v' = v + s*t + u x t it's two cross products and no
+//  temporaries, which matters when this is called for every vertex of a mesh. The Vec3
+//  arithmetic below is all expression templates (Vec.h), so the last line turns into one
+//  multiply-add chain per component - the same code as writing the components out by hand.
+inline Vec3 operator*(const Vec3 &v, const Quaternion &q)
+{
+	Vec3 u(q.x, q.y, q.z);
+	Vec3 t = Vec3::Cross(u, v) * 2.f;
+	return v + t * q.w + Vec3::Cross(u, t);
+}
+
+// The matrix producers take the layout to write as a template parameter, and default to
+//  Matrix's (column major, ready for a constant buffer). The elements below are written in
+//  row order either way - FromRows puts them where the layout wants them.
+// They also take a precision policy for the trig and normalizing (MathPolicy.h).
+// https://msdn.microsoft.com/en-us/library/windows/desktop/bb205350(v=vs.85).aspx
+template <typename Layout = ColumnMajor, typename Math = ExactMath>
+inline MatrixT<Layout> PerspectiveLH(float fovY, float aspect, float nearZ, float farZ)
+{
+	float s, c;
+	Math::SinCos(fovY / 2.f, s, c);
+	float yScale = c / s;
+	float xScale = yScale / aspect;
+
+	return MatrixT<Layout>::FromRows(
+		xScale, 0.f, 0.f, 0.f,
+		0.f, yScale, 0.f, 0.f,
+		0.f, 0.f, farZ / (farZ - nearZ), 1.f,
+		0.f, 0.f, -nearZ * farZ / (farZ - nearZ), 0.f
+		);
+}
+
+template <typename Layout = ColumnMajor, typename Math = ExactMath>
+inline MatrixT<Layout> LookAtLH(const Vec3 & pos, const Vec3 & lookAt, const Vec3 & up)
+{
+	/**
+	zaxis = normal(At - Eye)
+	xaxis = normal(cross(Up, zaxis))
+	yaxis = cross(zaxis, xaxis)
+
+	xaxis.x           yaxis.x           zaxis.x          0
+	xaxis.y           yaxis.y           zaxis.y          0
+	xaxis.z           yaxis.z           zaxis.z          0
+	-dot(xaxis, eye)  -dot(yaxis, eye)  -dot(zaxis, eye)  1
+	*/
+	Vec3 zaxis = Vec3(lookAt - pos).Normal<Math>();
+	Vec3 xaxis = Vec3::Cross(up, zaxis).Normal<Math>();
+	Vec3 yaxis = Vec3::Cross(zaxis, xaxis);
+
+	return MatrixT<Layout>::FromRows(
+		xaxis.x, yaxis.x, zaxis.x, 0.f,
+		xaxis.y, yaxis.y, zaxis.y, 0.f,
+		xaxis.z, yaxis.z, zaxis.z, 0.f,
+		-Vec3::Dot(xaxis, pos), -Vec3::Dot(yaxis, pos), -Vec3::Dot(zaxis, pos), 1.f);
+}
 
 };
\ No newline at end of file
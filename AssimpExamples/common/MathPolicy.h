@@ -0,0 +1,135 @@
+#pragma once
+
+// Math precision policies - pick how exact the trig and square roots should be at compile
+//  time, as a template parameter:
+//  ExactMath - the standard library (sinf, cosf, 1/sqrtf). The default everywhere.
+//  FastMath  - polynomial approximations and a hardware reciprocal square root estimate.
+//              Cheaper in loops (see below), and good enough for anything that gets looked at
+//              rather than accumulated (cameras, animation, normals).
+// Things that take a policy default to ExactMath, so nothing changes unless a caller asks:
+//  Quaternion::FromAxisAngle<FastMath>(axis, angle)
+//  v.Normal<FastMath>()
+//  PerspectiveLH<ColumnMajor, FastMath>(...)
+//
+// Worst errors measured by mathbench --accuracy (benchmarks/MathAccuracy.cc), against double
+//  precision results:
+//  Sin/Cos/SinCos              |angle| <= 10000    9.3e-8 absolute
+//  RSqrt                       2^-100 ... 2^100    2.5e-7 relative with SSE, 4.7e-6 without
+//  FromAxisAngle<FastMath>                         2.5e-7 radians of rotation
+//  Normal<FastMath>                                length within 3.4e-7 of 1 (4.8e-6 without SSE)
+// Further out the range reduction runs out of bits - 1e-6 at |angle| = 100000, but 0.03 at
+//  a million. Don't feed it something like the raw time in milliseconds since startup.
+//
+// Where the speed comes from: one call on its own is about the same as glibc's sinf/cosf
+//  (which are very good, and GCC merges into a single sincosf). The difference is that
+//  these are inline and branch free, so a loop over them vectorizes - a loop of 1024
+//  SinCos calls runs ~3x faster than the ExactMath one (mathbench, "SinCos loop"). And
+//  MSVC's CRT, which the demos build against, has slower sinf/cosf than glibc does.
+
+#include <Simd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace sess
+{
+
+struct ExactMath
+{
+public:
+	static float Sin(float angle) { return sinf(angle); }
+	static float Cos(float angle) { return cosf(angle); }
+	static void SinCos(float angle, float& s, float& c)
+	{
+		s = sinf(angle);
+		c = cosf(angle);
+	}
+	static float RSqrt(float x) { return 1.f / sqrtf(x); }
+};
+
+struct FastMath
+{
+public:
+	// One range reduction shared between both results
+	static void SinCos(float angle, float& s, float& c);
+	static float Sin(float angle);
+	static float Cos(float angle);
+
+	// 1 / sqrt(x) for x > 0
+	static float RSqrt(float x);
+};
+
+//
+// Everything is inline - these are only worth it if they don't cost a call
+//
+
+// Same approach as Cephes' sinf/cosf: angle = q * pi/2 + r with |r| <= pi/4, then a short
+//  polynomial for each of sin(r) and cos(r), and the quadrant q picks which one goes where.
+// pi/2 is split into three parts (Cody-Waite) so that q * pi/2 can be taken off of angle
+//  without losing all of r's bits to rounding.
+inline void FastMath::SinCos(float angle, float& s, float& c)
+{
+	const float TwoOverPi = 0.636619772f;
+	const float PiOver2A = 1.5703125f;
+	const float PiOver2B = 4.837512969970703125e-4f;
+	const float PiOver2C = 7.54978995489188216e-8f;
+
+	// Round to nearest - the truncating conversion is a single instruction, floorf isn't.
+	//  Adding +/-0.5 by copying angle's sign keeps it branch free.
+	int q = (int)(angle * TwoOverPi + copysignf(0.5f, angle));
+	float qf = (float)q;
+	float r = ((angle - qf * PiOver2A) - qf * PiOver2B) - qf * PiOver2C;
+	float z = r * r;
+
+	float sinR = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+	float cosR = 1.f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+
+	// Quadrants 1 and 3 swap sin and cos, and the signs flip every other quadrant (offset
+	//  by one for cos). Done on the bits rather than with a switch - the quadrant of a
+	//  random angle is random, and a mispredicted branch costs more than all of the above.
+	std::uint32_t sinBits, cosBits;
+	memcpy(&sinBits, &sinR, sizeof(sinBits));
+	memcpy(&cosBits, &cosR, sizeof(cosBits));
+
+	std::uint32_t swap = 0u - (std::uint32_t)(q & 1);
+	std::uint32_t sBits = ((sinBits & ~swap) | (cosBits & swap)) ^ ((std::uint32_t)(q & 2) << 30);
+	std::uint32_t cBits = ((cosBits & ~swap) | (sinBits & swap)) ^ ((std::uint32_t)((q + 1) & 2) << 30);
+
+	memcpy(&s, &sBits, sizeof(s));
+	memcpy(&c, &cBits, sizeof(c));
+}
+
+inline float FastMath::Sin(float angle)
+{
+	float s, c;
+	SinCos(angle, s, c);
+	return s;
+}
+
+inline float FastMath::Cos(float angle)
+{
+	float s, c;
+	SinCos(angle, s, c);
+	return c;
+}
+
+inline float FastMath::RSqrt(float x)
+{
+#if defined(SESS_SIMD_SSE)
+	// rsqrtss is good to ~12 bits, one Newton-Raphson step takes it to ~23
+	float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	return y * (1.5f - 0.5f * x * y * y);
+#else
+	// The Quake III trick for the first guess (~3.4% off), and two Newton-Raphson steps
+	std::uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	bits = 0x5F3759DFu - (bits >> 1);
+	float y;
+	memcpy(&y, &bits, sizeof(y));
+	y = y * (1.5f - 0.5f * x * y * y);
+	return y * (1.5f - 0.5f * x * y * y);
+#endif
+}
+
+};
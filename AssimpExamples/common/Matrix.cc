@@ -1,67 +1,238 @@
 #include <Matrix.h>
-#include <cstdint>
-#include <memory>
 
 namespace sess
 {
 
-const Matrix Matrix::Identity = { 1.f, 0.f, 0.f, 0.f,  0.f, 1.f, 0.f, 0.f,  0.f, 0.f, 1.f, 0.f,  0.f, 0.f, 0.f, 1.f };
+namespace
+{
 
-Matrix::Matrix()
-	: _11(0.f), _12(0.f), _13(0.f), _14(0.f)
-	, _21(0.f), _22(0.f), _23(0.f), _24(0.f)
-	, _31(0.f), _32(0.f), _33(0.f), _34(0.f)
-	, _41(0.f), _42(0.f), _43(0.f), _44(0.f)
-{}
+#if defined(SESS_SIMD_SSE)
+// Helpers for the 2x2 block inverse. Each __m128 holds a row-major 2x2 matrix (a b c d)
+template <int lane>
+inline __m128 Splat(__m128 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane));
+}
 
-Matrix::Matrix(float m11, float m12, float m13, float m14, float m21, float m22, float m23, float m24, float m31, float m32, float m33, float m34, float m41, float m42, float m43, float m44)
-	: _11(m11), _12(m12), _13(m13), _14(m14)
-	, _21(m21), _22(m22), _23(m23), _24(m24)
-	, _31(m31), _32(m32), _33(m33), _34(m34)
-	, _41(m41), _42(m42), _43(m43), _44(m44)
-{}
+// A * B
+inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+	return _mm_add_ps(
+		_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
 
-Matrix Matrix::Transpose() const
+// adj(A) * B
+inline __m128 Mat2AdjMul(__m128 a, __m128 b)
 {
-	Matrix tr;
+	return _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
 
-	for (std::uint8_t r = 0u; r < 4u; r++)
-	{
-		for (std::uint8_t c = 0u; c < 4u; c++)
-		{
-			tr.m[r][c] = m[c][r];
-		}
-	}
+// A * adj(B)
+inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(
+		_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+#endif
+
+};
+
+// Constant-initialized through the constexpr constructor, so no startup code runs for this.
+// The identity looks the same in both layouts.
+template <typename Layout>
+const MatrixT<Layout> MatrixT<Layout>::Identity = MatrixT<Layout>(1.f, 0.f, 0.f, 0.f,  0.f, 1.f, 0.f, 0.f,  0.f, 0.f, 1.f, 0.f,  0.f, 0.f, 0.f, 1.f);
+
+// Laplace expansion using the 2x2 determinants of the top two rows (s) and the bottom two rows (c)
+// Works on the raw storage - the determinant of a transpose is the same.
+template <typename Layout>
+float MatrixT<Layout>::Determinant() const
+{
+	float s0 = _11 * _22 - _21 * _12;
+	float s1 = _11 * _23 - _21 * _13;
+	float s2 = _11 * _24 - _21 * _14;
+	float s3 = _12 * _23 - _22 * _13;
+	float s4 = _12 * _24 - _22 * _14;
+	float s5 = _13 * _24 - _23 * _14;
+
+	float c5 = _33 * _44 - _43 * _34;
+	float c4 = _32 * _44 - _42 * _34;
+	float c3 = _32 * _43 - _42 * _33;
+	float c2 = _31 * _44 - _41 * _34;
+	float c1 = _31 * _43 - _41 * _33;
+	float c0 = _31 * _42 - _41 * _32;
+
+	return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+// The inverse of the transpose is the transpose of the inverse, so this doesn't care about layout either
+template <typename Layout>
+MatrixT<Layout> MatrixT<Layout>::Inverse() const
+{
+	MatrixT inv(NoInit{});
+
+#if defined(SESS_SIMD_SSE)
+	// Block matrix method - split the matrix into four 2x2 matrices, one per register:
+	//  M = | A B |
+	//      | C D |
+	// All of the inverse can be written in terms of 2x2 products, adjugates and determinants
+	//  of those blocks, which map really well onto 4-wide registers.
+	// https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+	__m128 r0 = _mm_loadu_ps(m[0]);
+	__m128 r1 = _mm_loadu_ps(m[1]);
+	__m128 r2 = _mm_loadu_ps(m[2]);
+	__m128 r3 = _mm_loadu_ps(m[3]);
+
+	__m128 A = _mm_movelh_ps(r0, r1);
+	__m128 B = _mm_movehl_ps(r1, r0);
+	__m128 C = _mm_movelh_ps(r2, r3);
+	__m128 D = _mm_movehl_ps(r3, r2);
+
+	// Determinants of all four blocks at once, (|A| |B| |C| |D|)
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+	__m128 detA = Splat<0>(detSub);
+	__m128 detB = Splat<1>(detSub);
+	__m128 detC = Splat<2>(detSub);
+	__m128 detD = Splat<3>(detSub);
 
-	return tr;
+	__m128 D_C = Mat2AdjMul(D, C);
+	__m128 A_B = Mat2AdjMul(A, B);
+
+	// Adjugates of the blocks of the inverse (before dividing by the determinant)
+	__m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+	__m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+	__m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+	__m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 tr = _mm_mul_ps(A_B, _mm_shuffle_ps(D_C, D_C, _MM_SHUFFLE(3, 1, 2, 0)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(2, 3, 0, 1)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+	__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), detM);
+	X_ = _mm_mul_ps(X_, rDetM);
+	Y_ = _mm_mul_ps(Y_, rDetM);
+	Z_ = _mm_mul_ps(Z_, rDetM);
+	W_ = _mm_mul_ps(W_, rDetM);
+
+	// Taking the adjugate of each block and reassembling the rows is one shuffle per row
+	_mm_storeu_ps(inv.m[0], _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(inv.m[1], _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(inv.m[2], _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(inv.m[3], _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(0, 2, 0, 2)));
+#else
+	// Same 2x2 determinants as Determinant(), re-used for every cofactor
+	float s0 = _11 * _22 - _21 * _12;
+	float s1 = _11 * _23 - _21 * _13;
+	float s2 = _11 * _24 - _21 * _14;
+	float s3 = _12 * _23 - _22 * _13;
+	float s4 = _12 * _24 - _22 * _14;
+	float s5 = _13 * _24 - _23 * _14;
+
+	float c5 = _33 * _44 - _43 * _34;
+	float c4 = _32 * _44 - _42 * _34;
+	float c3 = _32 * _43 - _42 * _33;
+	float c2 = _31 * _44 - _41 * _34;
+	float c1 = _31 * _43 - _41 * _33;
+	float c0 = _31 * _42 - _41 * _32;
+
+	float invDet = 1.f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+	inv._11 = (_22 * c5 - _23 * c4 + _24 * c3) * invDet;
+	inv._12 = (-_12 * c5 + _13 * c4 - _14 * c3) * invDet;
+	inv._13 = (_42 * s5 - _43 * s4 + _44 * s3) * invDet;
+	inv._14 = (-_32 * s5 + _33 * s4 - _34 * s3) * invDet;
+
+	inv._21 = (-_21 * c5 + _23 * c2 - _24 * c1) * invDet;
+	inv._22 = (_11 * c5 - _13 * c2 + _14 * c1) * invDet;
+	inv._23 = (-_41 * s5 + _43 * s2 - _44 * s1) * invDet;
+	inv._24 = (_31 * s5 - _33 * s2 + _34 * s1) * invDet;
+
+	inv._31 = (_21 * c4 - _22 * c2 + _24 * c0) * invDet;
+	inv._32 = (-_11 * c4 + _12 * c2 - _14 * c0) * invDet;
+	inv._33 = (_41 * s4 - _42 * s2 + _44 * s0) * invDet;
+	inv._34 = (-_31 * s4 + _32 * s2 - _34 * s0) * invDet;
+
+	inv._41 = (-_21 * c3 + _22 * c1 - _23 * c0) * invDet;
+	inv._42 = (_11 * c3 - _12 * c1 + _13 * c0) * invDet;
+	inv._43 = (-_41 * s3 + _42 * s1 - _43 * s0) * invDet;
+	inv._44 = (_31 * s3 - _32 * s1 + _33 * s0) * invDet;
+#endif
+
+	return inv;
 }
 
-// Assumes regular 4x4 matrix, with 0 0 0 1 as the bottom row
-float Matrix::Determinant() const
+// For M = | A t |   the inverse is | A^-1  -A^-1 t |
+//         | 0 1 |                  |  0       1    |
+// ... and the row-vector version (translation in the bottom row) is the same idea, transposed.
+// Only one of the two translations is non-zero in an affine matrix, so computing both
+//  handles either convention without having to check which one we've got.
+template <typename Layout>
+MatrixT<Layout> MatrixT<Layout>::AffineInverse() const
 {
-	return
-		_11 * (_22 * _33 - _23 * _32)
-		- _12 * (_21 * _33 - _13 * _31)
-		+ _13 * (_21 * _32 - _23 * _31);
+	// Inverse of the upper 3x3 is its adjugate (transposed cofactors) over the determinant
+	float c11 = _22 * _33 - _23 * _32;
+	float c12 = _23 * _31 - _21 * _33;
+	float c13 = _21 * _32 - _22 * _31;
+	float invDet = 1.f / (_11 * c11 + _12 * c12 + _13 * c13);
+
+	MatrixT inv(NoInit{});
+	inv._11 = c11 * invDet;
+	inv._12 = (_13 * _32 - _12 * _33) * invDet;
+	inv._13 = (_12 * _23 - _13 * _22) * invDet;
+
+	inv._21 = c12 * invDet;
+	inv._22 = (_11 * _33 - _13 * _31) * invDet;
+	inv._23 = (_13 * _21 - _11 * _23) * invDet;
+
+	inv._31 = c13 * invDet;
+	inv._32 = (_12 * _31 - _11 * _32) * invDet;
+	inv._33 = (_11 * _22 - _12 * _21) * invDet;
+
+	inv._14 = -(inv._11 * _14 + inv._12 * _24 + inv._13 * _34);
+	inv._24 = -(inv._21 * _14 + inv._22 * _24 + inv._23 * _34);
+	inv._34 = -(inv._31 * _14 + inv._32 * _24 + inv._33 * _34);
+
+	inv._41 = -(_41 * inv._11 + _42 * inv._21 + _43 * inv._31);
+	inv._42 = -(_41 * inv._12 + _42 * inv._22 + _43 * inv._32);
+	inv._43 = -(_41 * inv._13 + _42 * inv._23 + _43 * inv._33);
+	inv._44 = 1.f;
+
+	return inv;
 }
 
-Matrix Matrix::operator*(const Matrix & m2) const
+// (A^-1)^T is just the cofactor matrix of A over the determinant - no transposing needed
+template <typename Layout>
+MatrixT<Layout> MatrixT<Layout>::InverseTranspose() const
 {
-	Matrix tr;
+	float c11 = _22 * _33 - _23 * _32;
+	float c12 = _23 * _31 - _21 * _33;
+	float c13 = _21 * _32 - _22 * _31;
+	float invDet = 1.f / (_11 * c11 + _12 * c12 + _13 * c13);
 
-	for (std::uint8_t row = 0u; row < 4; row++)
+	return MatrixT(
+		c11 * invDet, c12 * invDet, c13 * invDet, 0.f,
+		(_13 * _32 - _12 * _33) * invDet, (_11 * _33 - _13 * _31) * invDet, (_12 * _31 - _11 * _32) * invDet, 0.f,
+		(_12 * _23 - _13 * _22) * invDet, (_13 * _21 - _11 * _23) * invDet, (_11 * _22 - _12 * _21) * invDet, 0.f,
+		0.f, 0.f, 0.f, 1.f);
+}
+
+template <typename Layout>
+void MatrixT<Layout>::MultiplyMany(const MatrixT* a, const MatrixT* b, MatrixT* out, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i++)
 	{
-		for (std::uint8_t col = 0u; col < 4; col++)
-		{
-			tr.m[row][col] = 0.f;
-			for (std::uint8_t k = 0u; k < 4; k++)
-			{
-				tr.m[row][col] += m[row][k] * m2.m[k][col];
-			}
-		}
+		MultiplyStorage(a[i], b[i], out[i]);
 	}
-
-	return std::move(tr);
 }
 
+template class MatrixT<RowMajor>;
+template class MatrixT<ColumnMajor>;
+
 };
\ No newline at end of file
@@ -5,12 +5,58 @@
 //  really it's just sorta an essential part of computer graphics.
 // This handles all the mathy stuff.
 
+#include <Simd.h>
+
+#include <cstddef>
+
+// Matrices are 16-byte aligned by default, so each row sits in exactly one SSE register
+//  and a matrix never straddles more cache lines than it has to. The kernels don't
+//  require it (unaligned loads are used throughout), so define SESS_UNALIGNED_MATRIX
+//  to get the tightly packed 4-byte aligned layout back.
+#if defined(SESS_UNALIGNED_MATRIX)
+#define SESS_MATRIX_ALIGNMENT
+#else
+#define SESS_MATRIX_ALIGNMENT alignas(16)
+#endif
+
 namespace sess
 {
 
-class Matrix
+// Matrix layouts
+// All the math in here uses row vectors, same as mul(v, M) in HLSL - a point is transformed
+//  as v * M, transforms chain left to right, and translation is the bottom row. The layout
+//  only decides what order the sixteen floats are stored in:
+//  - RowMajor: m[r] is row r. This is how D3DX stored things, and what a "row_major" matrix
+//    in HLSL expects.
+//  - ColumnMajor: m[c] is column c. This is HLSL's default packing, so these can be copied
+//    into a constant buffer as-is. It's also why Transform::GetTransformMatrix has always put
+//    translation into _14, _24, _34 - that's the bottom row, stored sideways.
+// The layout is part of the type, so things that build matrices (LookAtLH, PerspectiveLH...)
+//  write directly into whichever layout the consumer asked for. The swizzling is all sorted out
+//  at compile time, and nothing has to be transposed right before an upload every frame.
+struct RowMajor
+{
+	static constexpr bool IsColumnMajor = false;
+
+	// Where element (row, col) of the math matrix lives in m[][]
+	static constexpr int StorageRow(int row, int /* col */) { return row; }
+	static constexpr int StorageCol(int /* row */, int col) { return col; }
+};
+
+struct ColumnMajor
+{
+	static constexpr bool IsColumnMajor = true;
+
+	static constexpr int StorageRow(int /* row */, int col) { return col; }
+	static constexpr int StorageCol(int row, int /* col */) { return row; }
+};
+
+template <typename Layout>
+class SESS_MATRIX_ALIGNMENT MatrixT
 {
 public:
+	// Named fields and m[][] are the raw storage - for a ColumnMajor matrix, _14 is the
+	//  first element of the bottom row. Use At() to read by row and column regardless of layout.
 	union
 	{
 		struct
@@ -25,18 +71,174 @@ public:
 	};
 
 public:
-	Matrix();
-	Matrix(const Matrix&) = default;
-	Matrix(float m11, float m12, float m13, float m14, float m21, float m22, float m23, float m24, float m31, float m32, float m33, float m34, float m41, float m42, float m43, float m44);
-	~Matrix() = default;
+	// The constexpr constructors go through m rather than the named fields, since only
+	//  one member of a union can be initialized in a constant expression.
+	constexpr MatrixT() : m{} {}
+	MatrixT(const MatrixT&) = default;
+
+	// Elements in storage order
+	constexpr MatrixT(float m11, float m12, float m13, float m14, float m21, float m22, float m23, float m24, float m31, float m32, float m33, float m34, float m41, float m42, float m43, float m44)
+		: m{ { m11, m12, m13, m14 }, { m21, m22, m23, m24 }, { m31, m32, m33, m34 }, { m41, m42, m43, m44 } }
+	{}
+
+	// Converting from the other layout is a transpose, so it has to be asked for explicitly
+	template <typename OtherLayout>
+	explicit constexpr MatrixT(const MatrixT<OtherLayout>& o)
+		: MatrixT(FromRows(
+			o.At(0, 0), o.At(0, 1), o.At(0, 2), o.At(0, 3),
+			o.At(1, 0), o.At(1, 1), o.At(1, 2), o.At(1, 3),
+			o.At(2, 0), o.At(2, 1), o.At(2, 2), o.At(2, 3),
+			o.At(3, 0), o.At(3, 1), o.At(3, 2), o.At(3, 3)))
+	{}
+	~MatrixT() = default;
+
+	// Elements in math order, row by row, whatever the layout. This is what producers
+	//  should use - the shuffle into storage order is resolved by the compiler.
+	static constexpr MatrixT FromRows(float r11, float r12, float r13, float r14, float r21, float r22, float r23, float r24, float r31, float r32, float r33, float r34, float r41, float r42, float r43, float r44)
+	{
+		return Layout::IsColumnMajor
+			? MatrixT(r11, r21, r31, r41, r12, r22, r32, r42, r13, r23, r33, r43, r14, r24, r34, r44)
+			: MatrixT(r11, r12, r13, r14, r21, r22, r23, r24, r31, r32, r33, r34, r41, r42, r43, r44);
+	}
+
+	// Element at (row, col) of the math matrix
+	constexpr float At(int row, int col) const
+	{
+		return m[Layout::StorageRow(row, col)][Layout::StorageCol(row, col)];
+	}
+
+	constexpr MatrixT Transpose() const
+	{
+		return MatrixT(
+			m[0][0], m[1][0], m[2][0], m[3][0],
+			m[0][1], m[1][1], m[2][1], m[3][1],
+			m[0][2], m[1][2], m[2][2], m[3][2],
+			m[0][3], m[1][3], m[2][3], m[3][3]);
+	}
 
-	Matrix Transpose() const;
 	float Determinant() const;
 
-	Matrix operator*(const Matrix& m2) const;
+	// General 4x4 inverse. There's no inverse for a singular matrix (determinant of 0),
+	//  and you'll get infinities/NaNs back if you try.
+	MatrixT Inverse() const;
+
+	// Much cheaper inverse for affine matrices (rotation/scale/shear + translation).
+	// Doesn't care about the layout - it works with translation stored in either the last
+	//  column or the last row, as long as the other one is 0 0 0 1.
+	MatrixT AffineInverse() const;
+
+	// Transpose of the inverse of the upper 3x3, with translation dropped. This is the
+	//  matrix to transform normals with when the model matrix has non-uniform scale.
+	MatrixT InverseTranspose() const;
+
+	// this, then m2 (row vectors) - for both layouts
+	MatrixT operator*(const MatrixT& m2) const;
+
+	// Multiply n pairs of matrices, out[i] = a[i] * b[i]
+	// Much better than calling operator* in a loop for large batches (instance
+	//  transforms, skinning palettes) - no temporaries, and the loop stays in registers.
+	// out may be the same array as a or b.
+	static void MultiplyMany(const MatrixT* a, const MatrixT* b, MatrixT* out, std::size_t n);
 
 public:
-	static const Matrix Identity;
+	static const MatrixT Identity;
+
+protected:
+	// Used internally for results that are about to be completely overwritten,
+	//  so that they aren't zeroed out first for nothing.
+	struct NoInit {};
+	explicit MatrixT(NoInit) {}
+
+	// out = a * b on the raw storage, shared by operator* and MultiplyMany
+	static void MultiplyKernel(const float* a, const float* b, float* out);
+
+	// Storage of (a * b). Column major storage holds the transpose, and (AB)^T = B^T A^T,
+	//  so the operands just swap - decided at compile time, no cost at all.
+	static void MultiplyStorage(const MatrixT& a, const MatrixT& b, MatrixT& out)
+	{
+		if (Layout::IsColumnMajor)
+		{
+			MultiplyKernel(&b.m[0][0], &a.m[0][0], &out.m[0][0]);
+		}
+		else
+		{
+			MultiplyKernel(&a.m[0][0], &b.m[0][0], &out.m[0][0]);
+		}
+	}
 };
 
+// Most things in here want to end up on the GPU, so the default is the layout HLSL reads
+//  without any help. Use MatrixT<RowMajor> explicitly where row major is more convenient.
+typedef MatrixT<ColumnMajor> Matrix;
+
+// Everything that isn't inline is instantiated for both layouts in Matrix.cc
+extern template class MatrixT<RowMajor>;
+extern template class MatrixT<ColumnMajor>;
+
+// out = a * b, for row-major 4x4 float arrays
+// Every row of the product is a linear combination of the rows of b, weighted by the
+//  entries in the matching row of a. That's four broadcasts and four multiply-adds per row,
+//  instead of the 64 scalar multiplies of the textbook triple loop.
+// All of b is loaded before anything is written, and each row of a is read before its
+//  output row is written, so out may alias either input.
+template <typename Layout>
+inline void MatrixT<Layout>::MultiplyKernel(const float* a, const float* b, float* out)
+{
+#if defined(SESS_SIMD_AVX)
+	// Two output rows per iteration - each 128-bit lane holds one row of a, and the
+	//  rows of b are duplicated into both lanes.
+	__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 0));
+	__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 4));
+	__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 8));
+	__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 12));
+
+	for (int row = 0; row < 4; row += 2)
+	{
+		__m256 ar = _mm256_loadu_ps(a + row * 4);
+		__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, 0x00), b0);
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, 0x55), b1));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, 0xaa), b2));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(ar, ar, 0xff), b3));
+		_mm256_storeu_ps(out + row * 4, r);
+	}
+#elif defined(SESS_SIMD_SSE)
+	__m128 b0 = _mm_loadu_ps(b + 0);
+	__m128 b1 = _mm_loadu_ps(b + 4);
+	__m128 b2 = _mm_loadu_ps(b + 8);
+	__m128 b3 = _mm_loadu_ps(b + 12);
+
+	for (int row = 0; row < 4; row++)
+	{
+		__m128 ar = _mm_loadu_ps(a + row * 4);
+		__m128 r = _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0x00), b0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0x55), b1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0xaa), b2));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(ar, ar, 0xff), b3));
+		_mm_storeu_ps(out + row * 4, r);
+	}
+#else
+	float r[16];
+	for (int row = 0; row < 4; row++)
+	{
+		const float* ar = a + row * 4;
+		for (int col = 0; col < 4; col++)
+		{
+			r[row * 4 + col] = ar[0] * b[col] + ar[1] * b[4 + col] + ar[2] * b[8 + col] + ar[3] * b[12 + col];
+		}
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		out[i] = r[i];
+	}
+#endif
+}
+
+template <typename Layout>
+inline MatrixT<Layout> MatrixT<Layout>::operator*(const MatrixT& m2) const
+{
+	MatrixT tr(NoInit{});
+	MultiplyStorage(*this, m2, tr);
+	return tr;
+}
+
 };
\ No newline at end of file
@@ -0,0 +1,411 @@
+#include <MeshConvert.h>
+#include <Simd.h>
+
+#include <assimp/mesh.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <thread>
+
+namespace sess
+{
+
+namespace
+{
+
+// aiVector3D arrays get read as plain floats, three per vector
+static_assert(sizeof(aiVector3D) == 3u * sizeof(float), "Assimp has to be built with single precision ai_real");
+
+// n x y z vectors from in, each written as x y z w to out, out + stride, out + 2 * stride...
+//  Optionally keeps track of the smallest and largest x, y and z along the way.
+template <bool TrackBounds>
+void StreamFloat3ToFloat4(const float* in, std::size_t n, float w, unsigned char* out, std::size_t stride, Vec3& min, Vec3& max)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	// Four vectors are exactly three registers worth of floats:
+	//  a = x0 y0 z0 x1   b = y1 z1 x2 y2   c = z2 x3 y3 z3
+	// Two shuffles get vector 1 out, one each for 2 and 3, and vector 0 is a already. The
+	//  fourth lane of each is then whatever's left over, which the mask swaps for w.
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	const __m128 wLane = _mm_setr_ps(0.f, 0.f, 0.f, w);
+	__m128 lo = _mm_set1_ps(FLT_MAX);
+	__m128 hi = _mm_set1_ps(-FLT_MAX);
+	for (; i + 4u <= n; i += 4u, in += 12)
+	{
+		__m128 a = _mm_loadu_ps(in);
+		__m128 b = _mm_loadu_ps(in + 4);
+		__m128 c = _mm_loadu_ps(in + 8);
+
+		__m128 v[4];
+		v[0] = a;
+		v[1] = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 3)); // x1 x1 y1 z1
+		v[1] = _mm_shuffle_ps(v[1], v[1], _MM_SHUFFLE(3, 3, 2, 0));
+		v[2] = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 0, 3, 2));
+		v[3] = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 2, 1));
+
+		for (int k = 0; k < 4; k++)
+		{
+			if (TrackBounds)
+			{
+				// The fourth lane is junk here, but it never gets read back out
+				lo = _mm_min_ps(lo, v[k]);
+				hi = _mm_max_ps(hi, v[k]);
+			}
+			_mm_storeu_ps(reinterpret_cast<float*>(out), _mm_or_ps(_mm_and_ps(v[k], xyzMask), wLane));
+			out += stride;
+		}
+	}
+
+	if (TrackBounds)
+	{
+		float l[4], h[4];
+		_mm_storeu_ps(l, lo);
+		_mm_storeu_ps(h, hi);
+		min = Vec3(std::min(min.x, l[0]), std::min(min.y, l[1]), std::min(min.z, l[2]));
+		max = Vec3(std::max(max.x, h[0]), std::max(max.y, h[1]), std::max(max.z, h[2]));
+	}
+#endif
+
+	for (; i < n; i++, in += 3)
+	{
+		float v[4] = { in[0], in[1], in[2], w };
+		memcpy(out, v, sizeof(v));
+		out += stride;
+
+		if (TrackBounds)
+		{
+			min = Vec3(std::min(min.x, v[0]), std::min(min.y, v[1]), std::min(min.z, v[2]));
+			max = Vec3(std::max(max.x, v[0]), std::max(max.y, v[1]), std::max(max.z, v[2]));
+		}
+	}
+}
+
+// Three indices per triangle face, as whichever index type out is
+template <typename Index>
+void ConvertTriangles(const aiMesh* mesh, Index* out)
+{
+	// Every face's indices are their own little heap allocation, so this is a pointer chase
+	//  per triangle no matter what - the most that can be done is not doing anything else.
+	const aiFace* faces = mesh->mFaces;
+	if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+	{
+		for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++, out += 3)
+		{
+			const unsigned int* idx = faces[faceIdx].mIndices;
+			out[0] = (Index)idx[0];
+			out[1] = (Index)idx[1];
+			out[2] = (Index)idx[2];
+		}
+		return;
+	}
+
+	for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++)
+	{
+		if (faces[faceIdx].mNumIndices != 3u)
+		{
+			continue;
+		}
+		const unsigned int* idx = faces[faceIdx].mIndices;
+		out[0] = (Index)idx[0];
+		out[1] = (Index)idx[1];
+		out[2] = (Index)idx[2];
+		out += 3;
+	}
+}
+
+// For a mesh without normals or texture coordinates
+void FillZeros(std::size_t n, std::size_t bytes, unsigned char* out, std::size_t stride)
+{
+	for (std::size_t i = 0u; i < n; i++, out += stride)
+	{
+		memset(out, 0, bytes);
+	}
+}
+
+};
+
+std::size_t MeshVertexCount(const aiMesh* mesh)
+{
+	return mesh->mNumVertices;
+}
+
+AABB ConvertAssimpVertices(const aiMesh* mesh, const MeshVertexLayout& layout, void* out)
+{
+	unsigned char* bytes = static_cast<unsigned char*>(out);
+	std::size_t n = mesh->mNumVertices;
+
+	AABB bounds;
+	StreamFloat3ToFloat4<true>(reinterpret_cast<const float*>(mesh->mVertices), n, 1.f, bytes + layout.PositionOffset, layout.Stride, bounds.Min, bounds.Max);
+
+	if (layout.NormalOffset != MeshVertexLayout::NoAttribute)
+	{
+		if (mesh->HasNormals())
+		{
+			Vec3 unused;
+			StreamFloat3ToFloat4<false>(reinterpret_cast<const float*>(mesh->mNormals), n, 0.f, bytes + layout.NormalOffset, layout.Stride, unused, unused);
+		}
+		else
+		{
+			FillZeros(n, 4u * sizeof(float), bytes + layout.NormalOffset, layout.Stride);
+		}
+	}
+
+	if (layout.UVOffset != MeshVertexLayout::NoAttribute)
+	{
+		if (mesh->HasTextureCoords(0u))
+		{
+			// Two floats out of every three - an 8 byte copy per vertex, nothing for SIMD to win
+			const float* uvs = reinterpret_cast<const float*>(mesh->mTextureCoords[0]);
+			unsigned char* uvOut = bytes + layout.UVOffset;
+			for (std::size_t i = 0u; i < n; i++, uvs += 3, uvOut += layout.Stride)
+			{
+				memcpy(uvOut, uvs, 2u * sizeof(float));
+			}
+		}
+		else
+		{
+			FillZeros(n, 2u * sizeof(float), bytes + layout.UVOffset, layout.Stride);
+		}
+	}
+
+	return bounds;
+}
+
+std::size_t CountAssimpTriangleIndices(const aiMesh* mesh)
+{
+	// aiProcess_Triangulate + aiProcess_SortByPType (both in every preset) leave meshes that
+	//  are nothing but triangles, and say so - no need to look at the faces at all
+	if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+	{
+		return mesh->mNumFaces * 3u;
+	}
+
+	std::size_t count = 0u;
+	for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; faceIdx++)
+	{
+		if (mesh->mFaces[faceIdx].mNumIndices == 3u)
+		{
+			count += 3u;
+		}
+	}
+	return count;
+}
+
+void ConvertAssimpIndices(const aiMesh* mesh, std::uint32_t* out)
+{
+	ConvertTriangles(mesh, out);
+}
+
+void ConvertAssimpIndices(const aiMesh* mesh, std::uint16_t* out)
+{
+	ConvertTriangles(mesh, out);
+}
+
+void NarrowIndices(const std::uint32_t* in, std::uint16_t* out, std::size_t n)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	// SSE2 only has a signed saturating pack (the unsigned 32 -> 16 one is SSE4.1), so shift
+	//  0...65535 down into the signed range first and back up afterwards
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+	for (; i + 8u <= n; i += 8u)
+	{
+		__m128i lo = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), bias32);
+		__m128i hi = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4u)), bias32);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(_mm_packs_epi32(lo, hi), bias16));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		out[i] = (std::uint16_t)in[i];
+	}
+}
+
+namespace
+{
+
+// The walk over the triangles that every split does. newVertex(v) gets called the first time
+//  source vertex v is used in the range being built (in the order they go into the output),
+//  setIndex(i, local) for every index, and endRange(range) as each range is finished.
+//  Returns how many vertices went into the output.
+template <typename NewVertex, typename SetIndex, typename EndRange>
+std::size_t WalkShortIndexRanges(std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount, NewVertex newVertex, SetIndex setIndex, EndRange endRange)
+{
+	// Where each source vertex went in the range being built. Tagged with the range number
+	//  rather than cleared for every new range - a big mesh might make a few of them.
+	const std::uint32_t NotYet = 0xFFFFFFFFu;
+	std::vector<std::uint32_t> rangeOf(vertexCount, NotYet);
+	std::vector<std::uint16_t> localIndex(vertexCount);
+
+	std::size_t outVertexCount = 0u;
+	std::uint32_t rangeIdx = 0u;
+	IndexRange range = { 0u, 0u, 0u };
+	for (std::size_t i = 0u; i + 3u <= indexCount; i += 3u)
+	{
+		std::size_t newVertices = 0u;
+		for (std::size_t k = 0u; k < 3u; k++)
+		{
+			// A triangle can use the same vertex twice (degenerate, but legal)
+			std::uint32_t v = indices[i + k];
+			bool repeated = (k > 0u && v == indices[i]) || (k > 1u && v == indices[i + 1u]);
+			newVertices += (rangeOf[v] != rangeIdx && !repeated) ? 1u : 0u;
+		}
+
+		if (outVertexCount - range.BaseVertex + newVertices > MaxShortIndexVertices)
+		{
+			endRange(range);
+			rangeIdx++;
+			range.StartIndex = (std::uint32_t)i;
+			range.IndexCount = 0u;
+			range.BaseVertex = (std::uint32_t)outVertexCount;
+		}
+
+		for (std::size_t k = 0u; k < 3u; k++)
+		{
+			std::uint32_t v = indices[i + k];
+			if (rangeOf[v] != rangeIdx)
+			{
+				rangeOf[v] = rangeIdx;
+				localIndex[v] = (std::uint16_t)(outVertexCount - range.BaseVertex);
+				newVertex(v);
+				outVertexCount++;
+			}
+			setIndex(i + k, localIndex[v]);
+		}
+		range.IndexCount += 3u;
+	}
+	endRange(range);
+	return outVertexCount;
+}
+
+};
+
+void CountShortIndexSplit(std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount, std::size_t& splitVertexCount, std::size_t& rangeCount)
+{
+	if (vertexCount <= MaxShortIndexVertices)
+	{
+		splitVertexCount = vertexCount;
+		rangeCount = 1u;
+		return;
+	}
+
+	rangeCount = 0u;
+	splitVertexCount = WalkShortIndexRanges(vertexCount, indices, indexCount,
+		[](std::uint32_t) {},
+		[](std::size_t, std::uint16_t) {},
+		[&rangeCount](const IndexRange&) { rangeCount++; });
+}
+
+void SplitForShortIndices(const void* vertices, std::size_t vertexCount, std::size_t stride, const std::uint32_t* indices, std::size_t indexCount, void* outVertices, std::uint16_t* outIndices, IndexRange* outRanges)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(vertices);
+	std::uint8_t* vertexOut = static_cast<std::uint8_t*>(outVertices);
+
+	if (vertexCount <= MaxShortIndexVertices)
+	{
+		if (vertexCount > 0u)
+		{
+			memcpy(vertexOut, in, vertexCount * stride);
+		}
+		if (indexCount > 0u)
+		{
+			NarrowIndices(indices, outIndices, indexCount);
+		}
+		outRanges[0] = { 0u, (std::uint32_t)indexCount, 0u };
+		return;
+	}
+
+	WalkShortIndexRanges(vertexCount, indices, indexCount,
+		[&vertexOut, in, stride](std::uint32_t v)
+		{
+			memcpy(vertexOut, in + v * stride, stride);
+			vertexOut += stride;
+		},
+		[outIndices](std::size_t i, std::uint16_t local) { outIndices[i] = local; },
+		[&outRanges](const IndexRange& range) { *outRanges++ = range; });
+}
+
+void ParallelFor(std::size_t count, std::size_t maxTasks, const std::function<void(std::size_t)>& fn)
+{
+	if (maxTasks == 0u)
+	{
+		maxTasks = std::max(1u, std::thread::hardware_concurrency());
+	}
+	std::size_t taskCount = std::min(maxTasks, count);
+
+	// Meshes in a scene are anything but the same size (a whole car body next to each of its
+	//  wheel nuts), so rather than splitting the list up front, every task grabs the next item
+	//  nobody has started on yet until there aren't any left.
+	std::atomic<std::size_t> next(0u);
+	auto work = [count, &fn, &next]()
+	{
+		for (std::size_t i = next++; i < count; i = next++)
+		{
+			fn(i);
+		}
+	};
+
+	// This thread is one of the workers too
+	std::vector<std::future<void>> tasks;
+	for (std::size_t i = 1u; i < taskCount; i++)
+	{
+		tasks.push_back(std::async(std::launch::async, work));
+	}
+	work();
+	for (auto&& task : tasks)
+	{
+		task.get();
+	}
+}
+
+void ForEachIndex(const ForEachFn& forEach, std::size_t count, const std::function<void(std::size_t)>& fn)
+{
+	if (forEach)
+	{
+		forEach(count, fn);
+	}
+	else
+	{
+		ParallelFor(count, 0u, fn);
+	}
+}
+
+LoadTimer::LoadTimer()
+	: start_(Clock::now())
+	, stageStart_(start_)
+	, stages_()
+{}
+
+void LoadTimer::EndStage(const char* name)
+{
+	Clock::time_point now = Clock::now();
+	stages_.push_back({ name, std::chrono::duration<double, std::milli>(now - stageStart_).count() });
+	stageStart_ = now;
+}
+
+double LoadTimer::TotalMilliseconds() const
+{
+	return std::chrono::duration<double, std::milli>(stageStart_ - start_).count();
+}
+
+void LoadTimer::Report(std::ostream& o, const char* what) const
+{
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%.1f ms", TotalMilliseconds());
+	o << "Loaded " << what << " in " << buffer;
+
+	for (std::size_t i = 0u; i < stages_.size(); i++)
+	{
+		snprintf(buffer, sizeof(buffer), "%.1f ms", stages_[i].Milliseconds);
+		o << (i == 0u ? " (" : ", ") << stages_[i].Name << " " << buffer;
+	}
+	o << (stages_.empty() ? "" : ")") << std::endl;
+}
+
+};
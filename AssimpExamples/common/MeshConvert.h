@@ -0,0 +1,209 @@
+#pragma once
+
+// Turns Assimp meshes into vertex and index arrays that are ready to go onto the GPU.
+// Every model loader used to have its own copy of the same two loops - push_back one
+//  Vertex at a time (each one built by a constructor that writes the 1 and 0 padding
+//  floats), then push_back the three indices of each face one at a time. This is the one
+//  copy of them, for any vertex type:
+//  - The output is sized once up front, and written straight into - no push_back, no
+//    reallocating, and no constructor running for every vertex first.
+//  - Positions and normals go four at a time with SSE (see MeshConvert.cc). Assimp keeps
+//    them as tightly packed x y z floats, the shaders want them as float4 with w = 1 for a
+//    position and 0 for a normal. Each vertex gets x y z w in one 16 byte store, so the
+//    padding is written exactly once, along with everything else.
+//  - The bounding box comes out of the same pass over the positions.
+//  - Faces get flattened into the index array directly.
+// Nothing here touches D3D - making the buffers is left to the caller, on the thread that
+//  owns the device.
+//
+// A vertex type says where everything goes with a static Layout() function, and needs a
+//  default constructor that does nothing (the converter fills in every field):
+//
+//  struct Vertex
+//  {
+//      Vec3 Position; float __one; Vec3 Normal; float __zero; float U, V;
+//      Vertex() {}
+//      static MeshVertexLayout Layout()
+//      {
+//          return MeshVertexLayout(sizeof(Vertex), offsetof(Vertex, Position), offsetof(Vertex, Normal), offsetof(Vertex, U));
+//      }
+//  };
+
+#include <Bounds.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+struct aiMesh;
+
+namespace sess
+{
+
+// Byte offsets of each attribute in a vertex
+struct MeshVertexLayout
+{
+public:
+	static const std::size_t NoAttribute = ~(std::size_t)0u;
+
+	std::size_t Stride;
+	std::size_t PositionOffset; // x y z, then a float that gets 1
+	std::size_t NormalOffset;   // x y z, then a float that gets 0. NoAttribute if there isn't one
+	std::size_t UVOffset;       // u v from the first texture coordinate set. NoAttribute if there isn't one
+
+public:
+	MeshVertexLayout(std::size_t stride, std::size_t positionOffset, std::size_t normalOffset = NoAttribute, std::size_t uvOffset = NoAttribute)
+		: Stride(stride), PositionOffset(positionOffset), NormalOffset(normalOffset), UVOffset(uvOffset)
+	{}
+};
+
+//
+// The untyped pieces - everything that actually looks at an aiMesh lives in MeshConvert.cc
+//
+
+// Writes every attribute of mesh's vertices into out, which has room for mesh->mNumVertices
+//  vertices laid out as layout says. Returns the bounding box of the positions.
+// A missing normal or texture coordinate comes out as zeros.
+AABB ConvertAssimpVertices(const aiMesh* mesh, const MeshVertexLayout& layout, void* out);
+
+// How many indices ConvertAssimpIndices will write
+std::size_t CountAssimpTriangleIndices(const aiMesh* mesh);
+
+// Three indices per triangle. Points and lines (which aiProcess_SortByPType can leave behind
+//  in a mesh of their own) are skipped - the demos only draw triangle lists.
+void ConvertAssimpIndices(const aiMesh* mesh, std::uint32_t* out);
+
+// Same, as 16 bit indices - only for meshes with at most MaxShortIndexVertices vertices
+void ConvertAssimpIndices(const aiMesh* mesh, std::uint16_t* out);
+
+// mesh->mNumVertices, so the template below doesn't need the Assimp headers included
+//  everywhere this one is
+std::size_t MeshVertexCount(const aiMesh* mesh);
+
+// Calls fn(i) once for every i in 0...count-1, from up to maxTasks threads (0 picks one per
+//  core). The calling thread is one of them. Every call starts threads of its own, so this is
+//  for code that isn't already running on a thread pool - see ForEachFn for code that is.
+void ParallelFor(std::size_t count, std::size_t maxTasks, const std::function<void(std::size_t)>& fn);
+
+// Something that calls fn(0) ... fn(count - 1), maybe in parallel, and returns once they're
+//  all done. Code that converts mesh by mesh takes one of these so that, when it's running
+//  inside an AssetLoader job, it can share the loader's threads (AssetLoader::ForEachFunction)
+//  instead of starting a thread per core on top of every worker that's already busy.
+typedef std::function<void(std::size_t, const std::function<void(std::size_t)>&)> ForEachFn;
+
+// forEach(count, fn), or ParallelFor with a thread per core if forEach is empty
+void ForEachIndex(const ForEachFn& forEach, std::size_t count, const std::function<void(std::size_t)>& fn);
+
+//
+// 16 bit indices
+//
+// Half the memory of 32 bit indices, and half the bandwidth for the GPU's input assembler to
+//  fetch them. They can only count up to 65535, but nearly every mesh in a scene is far
+//  smaller than that (the icosphere has 12 vertices, a road piece a few hundred). The ones
+//  that aren't get split into pieces that each fit, drawn one DrawIndexed call per piece.
+//
+
+// The most vertices 16 bit indices can reach
+const std::size_t MaxShortIndexVertices = 65536u;
+
+// Part of an index buffer that gets drawn with one DrawIndexed call
+struct IndexRange
+{
+public:
+	std::uint32_t StartIndex;
+	std::uint32_t IndexCount;
+	std::uint32_t BaseVertex; // Added to each index by the GPU (DrawIndexed's BaseVertexLocation)
+};
+
+// 32 bit indices to 16. Every index has to be below MaxShortIndexVertices.
+void NarrowIndices(const std::uint32_t* in, std::uint16_t* out, std::size_t n);
+
+// How many vertices (duplicates included) and how many ranges SplitForShortIndices will come
+//  out with, without building any of it, so the buffers can be sized first. Only needs the
+//  indices.
+void CountShortIndexSplit(std::size_t vertexCount, const std::uint32_t* indices, std::size_t indexCount, std::size_t& splitVertexCount, std::size_t& rangeCount);
+
+// Splits a triangle list with too many vertices for 16 bit indices into ranges that each use
+//  at most MaxShortIndexVertices of them. Triangles are taken in order (Assimp's
+//  aiProcess_ImproveCacheLocality already puts ones that share vertices close together), and
+//  a new range starts when the next triangle would bring in one vertex too many. Each range
+//  gets its own copy of the vertices it uses, so a vertex shared by triangles on both sides
+//  of a split gets duplicated - that's the only cost.
+// Meshes that fit already come out as one range, with the vertices copied as they are.
+// Everything is written straight into buffers that are already the right size (see
+//  CountShortIndexSplit) - splitVertexCount vertices, indexCount indices, rangeCount ranges.
+void SplitForShortIndices(const void* vertices, std::size_t vertexCount, std::size_t stride, const std::uint32_t* indices, std::size_t indexCount, void* outVertices, std::uint16_t* outIndices, IndexRange* outRanges);
+
+//
+// The typed converter
+//
+
+template <typename Vertex>
+struct ConvertedMesh
+{
+public:
+	std::vector<Vertex> Vertices;
+	std::vector<std::uint32_t> Indices;
+	AABB Bounds;
+};
+
+template <typename Vertex>
+void ConvertAssimpMesh(const aiMesh* mesh, ConvertedMesh<Vertex>& out)
+{
+	// The converter writes raw bytes at the offsets the vertex gives it
+	static_assert(std::is_standard_layout<Vertex>::value, "Vertex types have to be standard layout for MeshVertexLayout offsets to mean anything");
+	static_assert(std::is_trivially_copyable<Vertex>::value, "Vertex types have to be trivially copyable to be filled in as bytes");
+
+	out.Vertices.resize(MeshVertexCount(mesh));
+	out.Indices.resize(CountAssimpTriangleIndices(mesh));
+	out.Bounds = out.Vertices.empty() ? AABB() : ConvertAssimpVertices(mesh, Vertex::Layout(), &out.Vertices[0]);
+	if (!out.Indices.empty())
+	{
+		ConvertAssimpIndices(mesh, &out.Indices[0]);
+	}
+}
+
+//
+// Load timing
+//
+
+// Wall clock time of each step of loading a model, for finding out where the time goes:
+//  LoadTimer timer;
+//  ... import ...
+//  timer.EndStage("import");
+//  ... convert ...
+//  timer.EndStage("convert");
+//  timer.Report(std::cout, fileName);
+// ... prints "Loaded road.fbx in 85.1 ms (import 79.0 ms, convert 6.1 ms)"
+class LoadTimer
+{
+public:
+	LoadTimer();
+
+	// Ends the stage that's running now, and starts the next one
+	void EndStage(const char* name);
+
+	double TotalMilliseconds() const;
+	void Report(std::ostream& o, const char* what) const;
+
+protected:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Stage
+	{
+	public:
+		std::string Name;
+		double Milliseconds;
+	};
+
+	Clock::time_point start_;
+	Clock::time_point stageStart_;
+	std::vector<Stage> stages_;
+};
+
+};
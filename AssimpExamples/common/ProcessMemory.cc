@@ -0,0 +1,73 @@
+#include <ProcessMemory.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+// Only needed before Windows 7 - after that GetProcessMemoryInfo is in kernel32
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+namespace sess
+{
+
+#if defined(_WIN32)
+
+std::size_t CurrentResidentBytes()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0u;
+	}
+	return counters.WorkingSetSize;
+}
+
+std::size_t PeakResidentBytes()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0u;
+	}
+	return counters.PeakWorkingSetSize;
+}
+
+#else
+
+std::size_t CurrentResidentBytes()
+{
+	// Second number is the resident set, in pages. Linux only - anywhere else can say 0.
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (!statm)
+	{
+		return 0u;
+	}
+	unsigned long size = 0u, resident = 0u;
+	int read = fscanf(statm, "%lu %lu", &size, &resident);
+	fclose(statm);
+	return read == 2 ? (std::size_t)resident * (std::size_t)sysconf(_SC_PAGESIZE) : 0u;
+}
+
+std::size_t PeakResidentBytes()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0u;
+	}
+#if defined(__APPLE__)
+	return (std::size_t)usage.ru_maxrss; // Bytes on macOS...
+#else
+	return (std::size_t)usage.ru_maxrss * 1024u; // ...and kilobytes everywhere else
+#endif
+}
+
+#endif
+
+};
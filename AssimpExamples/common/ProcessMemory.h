@@ -0,0 +1,19 @@
+#pragma once
+
+// How much memory this process is using, as the OS sees it (the working set on Windows,
+//  resident set everywhere else). It's the whole process - every thread, every allocation,
+//  plus whatever pages of mapped files have been touched - so it's good for "did that just
+//  blow up memory use", and not much finer than that.
+
+#include <cstddef>
+
+namespace sess
+{
+
+// Bytes resident right now. 0 if the OS won't say.
+std::size_t CurrentResidentBytes();
+
+// Most bytes that were ever resident at once since the process started. 0 if the OS won't say.
+std::size_t PeakResidentBytes();
+
+};
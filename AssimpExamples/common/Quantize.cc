@@ -0,0 +1,652 @@
+#include <Quantize.h>
+#include <MathExtras.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sess
+{
+
+static_assert(sizeof(PackedQuaternion48) == 6u, "PackedQuaternion48 should be exactly 48 bits");
+static_assert(sizeof(PackedQuaternion32) == 4u, "PackedQuaternion32 should be exactly 32 bits");
+static_assert(sizeof(PackedTransform) == 18u, "PackedTransform should have no padding");
+static_assert(sizeof(PackedRigidTransform) == 12u, "PackedRigidTransform should only have the two bytes of padding after Position");
+
+namespace
+{
+
+// The three smallest components of a unit quaternion are all within +/- 1/sqrt(2)
+const float Range = 0.70710678f;
+
+// Smallest three, unpacked: { index of the largest component, then the other three
+//  components in x, y, z, w order, quantized to [0, MaxValue] }
+template <std::uint32_t MaxValue>
+std::uint32_t QuantizeComponent(float v)
+{
+	float t = (v + Range) * (0.5f / Range);
+	t = std::min(std::max(t, 0.f), 1.f);
+	return (std::uint32_t)(t * (float)MaxValue + 0.5f);
+}
+
+template <std::uint32_t MaxValue>
+float DequantizeComponent(std::uint32_t v)
+{
+	return (float)v * (2.f * Range / (float)MaxValue) - Range;
+}
+
+template <std::uint32_t MaxValue>
+void EncodeSmallestThree(const Quaternion& q, std::uint32_t* out)
+{
+	float c[4] = { q.x, q.y, q.z, q.w };
+	std::uint32_t largest = 0u;
+	for (std::uint32_t i = 1u; i < 4u; i++)
+	{
+		if (fabsf(c[i]) > fabsf(c[largest]))
+		{
+			largest = i;
+		}
+	}
+
+	// q and -q are the same rotation - flip it so the dropped component is positive,
+	//  and then it doesn't need a sign bit
+	float sign = c[largest] < 0.f ? -1.f : 1.f;
+
+	out[0] = largest;
+	std::uint32_t o = 1u;
+	for (std::uint32_t i = 0u; i < 4u; i++)
+	{
+		if (i != largest)
+		{
+			out[o++] = QuantizeComponent<MaxValue>(c[i] * sign);
+		}
+	}
+}
+
+template <std::uint32_t MaxValue>
+Quaternion DecodeSmallestThree(const std::uint32_t* in)
+{
+	float s[3] = { DequantizeComponent<MaxValue>(in[1]), DequantizeComponent<MaxValue>(in[2]), DequantizeComponent<MaxValue>(in[3]) };
+	float m = sqrtf(std::max(0.f, 1.f - (s[0] * s[0] + s[1] * s[1] + s[2] * s[2])));
+
+	float c[4];
+	std::uint32_t o = 0u;
+	for (std::uint32_t i = 0u; i < 4u; i++)
+	{
+		c[i] = (i == in[0]) ? m : s[o++];
+	}
+
+	return Quaternion::Unchecked(c[3], c[0], c[1], c[2]);
+}
+
+#if defined(SESS_SIMD_SSE)
+inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline __m128 LaneEquals(__m128i v, int k)
+{
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(v, _mm_set1_epi32(k)));
+}
+
+inline __m128 LaneLess(__m128i v, int k)
+{
+	return _mm_castsi128_ps(_mm_cmplt_epi32(v, _mm_set1_epi32(k)));
+}
+
+// Four at a time - out[k * 4 + lane] is element k of EncodeSmallestThree for q[lane].
+// Exactly the same operations as the scalar version, so the results match bit for bit.
+template <std::uint32_t MaxValue>
+void EncodeSmallestThree4(const Quaternion* q, std::uint32_t* out)
+{
+	__m128 x = _mm_loadu_ps(&q[0].x);
+	__m128 y = _mm_loadu_ps(&q[1].x);
+	__m128 z = _mm_loadu_ps(&q[2].x);
+	__m128 w = _mm_loadu_ps(&q[3].x);
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128i largest = _mm_setzero_si128();
+	__m128 best = _mm_and_ps(x, absMask);
+	__m128 bestValue = x;
+	const __m128 c[3] = { y, z, w };
+	for (int i = 0; i < 3; i++)
+	{
+		__m128 a = _mm_and_ps(c[i], absMask);
+		__m128 greater = _mm_cmpgt_ps(a, best);
+		best = Select(greater, a, best);
+		bestValue = Select(greater, c[i], bestValue);
+		largest = _mm_or_si128(_mm_and_si128(_mm_castps_si128(greater), _mm_set1_epi32(i + 1)), _mm_andnot_si128(_mm_castps_si128(greater), largest));
+	}
+
+	// Multiplying by -1 is just flipping the sign bit
+	__m128 sign = _mm_and_ps(bestValue, _mm_set1_ps(-0.f));
+	x = _mm_xor_ps(x, sign);
+	y = _mm_xor_ps(y, sign);
+	z = _mm_xor_ps(z, sign);
+	w = _mm_xor_ps(w, sign);
+
+	__m128 s0 = Select(LaneEquals(largest, 0), y, x);
+	__m128 s1 = Select(LaneLess(largest, 2), z, y);
+	__m128 s2 = Select(LaneLess(largest, 3), w, z);
+
+	const __m128 offset = _mm_set1_ps(Range);
+	const __m128 scale = _mm_set1_ps(0.5f / Range);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 maxValue = _mm_set1_ps((float)MaxValue);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 s[3] = { s0, s1, s2 };
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), largest);
+	for (int k = 0; k < 3; k++)
+	{
+		__m128 t = _mm_mul_ps(_mm_add_ps(s[k], offset), scale);
+		t = _mm_min_ps(_mm_max_ps(t, zero), one);
+		__m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, maxValue), half));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * (k + 1)), v);
+	}
+}
+
+// in[lane * 4 + k] is element k for q[lane] - one quaternion after another, as they come
+//  out of the bit unpacking. The registers are put together from scalars on purpose: a
+//  16 byte load straight after four 4 byte stores to the same place can't be forwarded and
+//  stalls until the stores land, which made the AVX build of this 3x slower (mathbench).
+template <std::uint32_t MaxValue>
+void DecodeSmallestThree4(const std::uint32_t* in, Quaternion* q)
+{
+	__m128i largest = _mm_setr_epi32(in[0], in[4], in[8], in[12]);
+	const __m128 scale = _mm_set1_ps(2.f * Range / (float)MaxValue);
+	const __m128 offset = _mm_set1_ps(Range);
+
+	__m128 s[3];
+	for (int k = 0; k < 3; k++)
+	{
+		__m128 v = _mm_cvtepi32_ps(_mm_setr_epi32(in[k + 1], in[k + 5], in[k + 9], in[k + 13]));
+		s[k] = _mm_sub_ps(_mm_mul_ps(v, scale), offset);
+	}
+
+	__m128 sumSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s[0], s[0]), _mm_mul_ps(s[1], s[1])), _mm_mul_ps(s[2], s[2]));
+	__m128 m = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_set1_ps(1.f), sumSq)));
+
+	// Put the dropped component back where it came from, and shift the others around it
+	__m128 x = Select(LaneEquals(largest, 0), m, s[0]);
+	__m128 y = Select(LaneEquals(largest, 1), m, Select(LaneEquals(largest, 0), s[0], s[1]));
+	__m128 z = Select(LaneEquals(largest, 2), m, Select(LaneLess(largest, 2), s[1], s[2]));
+	__m128 w = Select(LaneEquals(largest, 3), m, s[2]);
+
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(&q[0].x, x);
+	_mm_storeu_ps(&q[1].x, y);
+	_mm_storeu_ps(&q[2].x, z);
+	_mm_storeu_ps(&q[3].x, w);
+}
+#endif
+
+//
+// Bit packing - 2 bits of index, then the three components, high bits first
+//
+PackedQuaternion48 ToBits48(std::uint32_t largest, std::uint32_t a, std::uint32_t b, std::uint32_t c)
+{
+	std::uint64_t v = ((std::uint64_t)largest << 45) | ((std::uint64_t)a << 30) | ((std::uint64_t)b << 15) | (std::uint64_t)c;
+	PackedQuaternion48 p;
+	p.Bits[0] = (std::uint16_t)(v & 0xFFFFu);
+	p.Bits[1] = (std::uint16_t)((v >> 16) & 0xFFFFu);
+	p.Bits[2] = (std::uint16_t)((v >> 32) & 0xFFFFu);
+	return p;
+}
+
+void FromBits48(const PackedQuaternion48& p, std::uint32_t* out)
+{
+	std::uint64_t v = (std::uint64_t)p.Bits[0] | ((std::uint64_t)p.Bits[1] << 16) | ((std::uint64_t)p.Bits[2] << 32);
+	out[0] = (std::uint32_t)((v >> 45) & 0x3u);
+	out[1] = (std::uint32_t)((v >> 30) & 0x7FFFu);
+	out[2] = (std::uint32_t)((v >> 15) & 0x7FFFu);
+	out[3] = (std::uint32_t)(v & 0x7FFFu);
+}
+
+PackedQuaternion32 ToBits32(std::uint32_t largest, std::uint32_t a, std::uint32_t b, std::uint32_t c)
+{
+	PackedQuaternion32 p;
+	p.Bits = (largest << 30) | (a << 20) | (b << 10) | c;
+	return p;
+}
+
+void FromBits32(const PackedQuaternion32& p, std::uint32_t* out)
+{
+	out[0] = (p.Bits >> 30) & 0x3u;
+	out[1] = (p.Bits >> 20) & 0x3FFu;
+	out[2] = (p.Bits >> 10) & 0x3FFu;
+	out[3] = p.Bits & 0x3FFu;
+}
+
+// Shared batch loops for both sizes - Max is the largest quantized value
+template <std::uint32_t MaxValue, typename Packed, typename ToBits>
+void PackQuaternions(const Quaternion* q, Packed* out, std::size_t n, ToBits toBits)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	std::uint32_t lanes[16];
+	for (; i + 4u <= n; i += 4u)
+	{
+		EncodeSmallestThree4<MaxValue>(q + i, lanes);
+		for (std::size_t lane = 0u; lane < 4u; lane++)
+		{
+			out[i + lane] = toBits(lanes[lane], lanes[4 + lane], lanes[8 + lane], lanes[12 + lane]);
+		}
+	}
+#endif
+	for (; i < n; i++)
+	{
+		std::uint32_t e[4];
+		EncodeSmallestThree<MaxValue>(q[i], e);
+		out[i] = toBits(e[0], e[1], e[2], e[3]);
+	}
+}
+
+template <std::uint32_t MaxValue, typename Packed, typename FromBits>
+void UnpackQuaternions(const Packed* packed, Quaternion* out, std::size_t n, FromBits fromBits)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_SSE)
+	std::uint32_t lanes[16];
+	for (; i + 4u <= n; i += 4u)
+	{
+		for (std::size_t lane = 0u; lane < 4u; lane++)
+		{
+			fromBits(packed[i + lane], lanes + 4u * lane);
+		}
+		DecodeSmallestThree4<MaxValue>(lanes, out + i);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		std::uint32_t e[4];
+		fromBits(packed[i], e);
+		out[i] = DecodeSmallestThree<MaxValue>(e);
+	}
+}
+
+const std::uint32_t Max15 = 0x7FFFu;
+const std::uint32_t Max10 = 0x3FFu;
+
+// Position and scale go through the batch half conversion a chunk at a time
+const std::size_t TransformChunk = 64u;
+
+// Rotation and position, the part both transform formats share
+template <typename Packed>
+void PackTransformChunk(const Transform* t, Packed* out, std::size_t n)
+{
+	Quaternion rotations[TransformChunk];
+	decltype(out[0].Rotation) packedRotations[TransformChunk];
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		rotations[i] = t[i].Rotation;
+	}
+	PackMany(rotations, packedRotations, n);
+
+	float components[TransformChunk * 3u];
+	std::uint16_t halves[TransformChunk * 3u];
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		out[i].Rotation = packedRotations[i];
+		components[i * 3u] = t[i].Position.x;
+		components[i * 3u + 1u] = t[i].Position.y;
+		components[i * 3u + 2u] = t[i].Position.z;
+	}
+	FloatToHalfMany(components, halves, n * 3u);
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		memcpy(out[i].Position, halves + i * 3u, sizeof(out[i].Position));
+	}
+}
+
+void PackScaleChunk(const Transform* t, PackedTransform* out, std::size_t n)
+{
+	float components[TransformChunk * 3u];
+	std::uint16_t halves[TransformChunk * 3u];
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		components[i * 3u] = t[i].Scale.x;
+		components[i * 3u + 1u] = t[i].Scale.y;
+		components[i * 3u + 2u] = t[i].Scale.z;
+	}
+	FloatToHalfMany(components, halves, n * 3u);
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		memcpy(out[i].Scale, halves + i * 3u, sizeof(out[i].Scale));
+	}
+}
+
+// The angle of the rotation that takes a to b. The obvious 2 acos(|a.b|) falls apart for
+//  small angles in floats (a dot product within one rounding step of 1 already reads as
+//  0.04 degrees), so this goes by the distance between the two quaternions instead.
+float RotationAngle(const Quaternion& a, const Quaternion& b)
+{
+	float s = Quaternion::Dot(a, b) < 0.f ? -1.f : 1.f;
+	float dx = a.x - s * b.x, dy = a.y - s * b.y, dz = a.z - s * b.z, dw = a.w - s * b.w;
+	float d = sqrtf(dx * dx + dy * dy + dz * dz + dw * dw);
+	return 4.f * asinf(std::min(0.5f * d, 1.f));
+}
+
+void AddRotationError(QuantizationError& e, const Quaternion& a, const Quaternion& b)
+{
+	float angle = RotationAngle(a, b);
+	e.MaxRotationError = std::max(e.MaxRotationError, angle);
+	e.MeanRotationError += angle;
+}
+
+float MaxComponentError(const Vec3& a, const Vec3& b)
+{
+	return std::max(fabsf(a.x - b.x), std::max(fabsf(a.y - b.y), fabsf(a.z - b.z)));
+}
+
+template <typename Packed>
+QuantizationError MeasureRotationError(const Quaternion* original, const Packed* packed, std::size_t n)
+{
+	QuantizationError e;
+	e.Count = n;
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		AddRotationError(e, original[i], packed[i].Unpack());
+	}
+	e.MeanRotationError = n > 0u ? e.MeanRotationError / n : 0.f;
+	return e;
+}
+
+template <typename Packed>
+QuantizationError MeasureTransformError(const Transform* original, const Packed* packed, std::size_t n, bool withScale)
+{
+	QuantizationError e;
+	e.Count = n;
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		Transform t = packed[i].Unpack();
+		AddRotationError(e, original[i].Rotation, t.Rotation);
+		e.MaxPositionError = std::max(e.MaxPositionError, MaxComponentError(original[i].Position, t.Position));
+		if (withScale)
+		{
+			e.MaxScaleError = std::max(e.MaxScaleError, MaxComponentError(original[i].Scale, t.Scale));
+		}
+	}
+	e.MeanRotationError = n > 0u ? e.MeanRotationError / n : 0.f;
+	return e;
+}
+
+};
+
+//
+// Half floats
+//
+std::uint16_t FloatToHalf(float f)
+{
+	std::uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+
+	std::uint32_t sign = (bits >> 16) & 0x8000u;
+	std::uint32_t absBits = bits & 0x7FFFFFFFu;
+
+	// Infinity and NaN (keep NaNs as NaNs)
+	if (absBits >= 0x7F800000u)
+	{
+		return (std::uint16_t)(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x0200u : 0u));
+	}
+
+	// 65520 and up rounds to infinity
+	if (absBits >= 0x477FF000u)
+	{
+		return (std::uint16_t)(sign | 0x7C00u);
+	}
+
+	// Below 2^-14 is a denormal half - shift the mantissa (with its implicit 1) into place
+	if (absBits < 0x38800000u)
+	{
+		if (absBits < 0x33000000u)
+		{
+			return (std::uint16_t)sign;
+		}
+
+		std::uint32_t mantissa = (absBits & 0x007FFFFFu) | 0x00800000u;
+		std::uint32_t shift = 126u - (absBits >> 23);
+		std::uint32_t h = mantissa >> shift;
+		std::uint32_t rest = mantissa & ((1u << shift) - 1u);
+		std::uint32_t halfway = 1u << (shift - 1u);
+		if (rest > halfway || (rest == halfway && (h & 1u)))
+		{
+			h++;
+		}
+		return (std::uint16_t)(sign | h);
+	}
+
+	// Normal - re-bias the exponent (127 -> 15) and round off the bottom 13 mantissa bits.
+	//  Rounding up can carry into the exponent, which is exactly what should happen.
+	std::uint32_t h = (absBits - 0x38000000u) >> 13;
+	std::uint32_t rest = absBits & 0x1FFFu;
+	if (rest > 0x1000u || (rest == 0x1000u && (h & 1u)))
+	{
+		h++;
+	}
+	return (std::uint16_t)(sign | h);
+}
+
+float HalfToFloat(std::uint16_t h)
+{
+	std::uint32_t sign = (std::uint32_t)(h & 0x8000u) << 16;
+	std::uint32_t exponent = (h >> 10) & 0x1Fu;
+	std::uint32_t mantissa = h & 0x03FFu;
+
+	std::uint32_t bits;
+	if (exponent == 0u)
+	{
+		// Zero or denormal - mantissa * 2^-24
+		float f = (float)mantissa * 5.9604645e-8f;
+		return (h & 0x8000u) ? -f : f;
+	}
+	else if (exponent == 0x1Fu)
+	{
+		// Hardware conversion quiets signaling NaNs, so this does too
+		bits = sign | 0x7F800000u | (mantissa << 13) | (mantissa ? 0x00400000u : 0u);
+	}
+	else
+	{
+		bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+	}
+
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+void FloatToHalfMany(const float* in, std::uint16_t* out, std::size_t n)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_F16C)
+	for (; i + 8u <= n; i += 8u)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		out[i] = FloatToHalf(in[i]);
+	}
+}
+
+void HalfToFloatMany(const std::uint16_t* in, float* out, std::size_t n)
+{
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_F16C)
+	for (; i + 8u <= n; i += 8u)
+	{
+		_mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		out[i] = HalfToFloat(in[i]);
+	}
+}
+
+//
+// Rotations
+//
+PackedQuaternion48 PackedQuaternion48::Pack(const Quaternion& q)
+{
+	std::uint32_t e[4];
+	EncodeSmallestThree<Max15>(q, e);
+	return ToBits48(e[0], e[1], e[2], e[3]);
+}
+
+Quaternion PackedQuaternion48::Unpack() const
+{
+	std::uint32_t e[4];
+	FromBits48(*this, e);
+	return DecodeSmallestThree<Max15>(e);
+}
+
+PackedQuaternion32 PackedQuaternion32::Pack(const Quaternion& q)
+{
+	std::uint32_t e[4];
+	EncodeSmallestThree<Max10>(q, e);
+	return ToBits32(e[0], e[1], e[2], e[3]);
+}
+
+Quaternion PackedQuaternion32::Unpack() const
+{
+	std::uint32_t e[4];
+	FromBits32(*this, e);
+	return DecodeSmallestThree<Max10>(e);
+}
+
+//
+// Transforms
+//
+PackedTransform PackedTransform::Pack(const Transform& t)
+{
+	PackedTransform p;
+	p.Rotation = PackedQuaternion48::Pack(t.Rotation);
+	p.Position[0] = FloatToHalf(t.Position.x);
+	p.Position[1] = FloatToHalf(t.Position.y);
+	p.Position[2] = FloatToHalf(t.Position.z);
+	p.Scale[0] = FloatToHalf(t.Scale.x);
+	p.Scale[1] = FloatToHalf(t.Scale.y);
+	p.Scale[2] = FloatToHalf(t.Scale.z);
+	return p;
+}
+
+Transform PackedTransform::Unpack() const
+{
+	return Transform(
+		Vec3(HalfToFloat(Position[0]), HalfToFloat(Position[1]), HalfToFloat(Position[2])),
+		Rotation.Unpack(),
+		Vec3(HalfToFloat(Scale[0]), HalfToFloat(Scale[1]), HalfToFloat(Scale[2])));
+}
+
+PackedRigidTransform PackedRigidTransform::Pack(const Transform& t)
+{
+	PackedRigidTransform p;
+	p.Rotation = PackedQuaternion32::Pack(t.Rotation);
+	p.Position[0] = FloatToHalf(t.Position.x);
+	p.Position[1] = FloatToHalf(t.Position.y);
+	p.Position[2] = FloatToHalf(t.Position.z);
+	return p;
+}
+
+Transform PackedRigidTransform::Unpack() const
+{
+	return Transform(
+		Vec3(HalfToFloat(Position[0]), HalfToFloat(Position[1]), HalfToFloat(Position[2])),
+		Rotation.Unpack(),
+		Vec3::Ones);
+}
+
+//
+// Batches
+//
+void PackMany(const Quaternion* q, PackedQuaternion48* out, std::size_t n)
+{
+	PackQuaternions<Max15>(q, out, n, ToBits48);
+}
+
+void PackMany(const Quaternion* q, PackedQuaternion32* out, std::size_t n)
+{
+	PackQuaternions<Max10>(q, out, n, ToBits32);
+}
+
+void UnpackMany(const PackedQuaternion48* packed, Quaternion* out, std::size_t n)
+{
+	UnpackQuaternions<Max15>(packed, out, n, FromBits48);
+}
+
+void UnpackMany(const PackedQuaternion32* packed, Quaternion* out, std::size_t n)
+{
+	UnpackQuaternions<Max10>(packed, out, n, FromBits32);
+}
+
+void PackMany(const Transform* t, PackedTransform* out, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i += TransformChunk)
+	{
+		std::size_t count = std::min(TransformChunk, n - i);
+		PackTransformChunk(t + i, out + i, count);
+		PackScaleChunk(t + i, out + i, count);
+	}
+}
+
+void PackMany(const Transform* t, PackedRigidTransform* out, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i += TransformChunk)
+	{
+		PackTransformChunk(t + i, out + i, std::min(TransformChunk, n - i));
+	}
+}
+
+void UnpackMany(const PackedTransform* packed, Transform* out, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		out[i] = packed[i].Unpack();
+	}
+}
+
+void UnpackMany(const PackedRigidTransform* packed, Transform* out, std::size_t n)
+{
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		out[i] = packed[i].Unpack();
+	}
+}
+
+//
+// Error
+//
+QuantizationError::QuantizationError()
+	: Count(0u)
+	, MaxRotationError(0.f)
+	, MeanRotationError(0.f)
+	, MaxPositionError(0.f)
+	, MaxScaleError(0.f)
+{}
+
+QuantizationError MeasureError(const Quaternion* original, const PackedQuaternion48* packed, std::size_t n)
+{
+	return MeasureRotationError(original, packed, n);
+}
+
+QuantizationError MeasureError(const Quaternion* original, const PackedQuaternion32* packed, std::size_t n)
+{
+	return MeasureRotationError(original, packed, n);
+}
+
+QuantizationError MeasureError(const Transform* original, const PackedTransform* packed, std::size_t n)
+{
+	return MeasureTransformError(original, packed, n, true);
+}
+
+QuantizationError MeasureError(const Transform* original, const PackedRigidTransform* packed, std::size_t n)
+{
+	return MeasureTransformError(original, packed, n, false);
+}
+
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+// Smaller storage for rotations and transforms.
+// A Quaternion is 16 bytes and a Transform is 40, which is fine for a handful of objects,
+//  but animation keys and per-instance data for thousands of characters add up fast.
+//  None of that needs full 32 bit floats, so it can be packed down and unpacked on use:
+//  - Rotations use "smallest three": a unit quaternion's largest component can always
+//    be worked out from the other three, so store which one it was (2 bits) and the other
+//    three, which are all within +/- 1/sqrt(2). 15 bits each is 48 bits, 10 bits each is 32.
+//  - Positions and scales use half floats (16 bits, about three significant digits).
+//    Great for local/animation space, not so great for big world positions - 1000 units
+//    out, the step between half floats is half a unit.
+// The Pack/Unpack pairs below aren't lossless, so there's also MeasureError to check how
+//  much was lost on real data before committing to a format. mathbench --accuracy runs it
+//  over random rotations and transforms (positions within +/- 10), which is where the
+//  errors here come from.
+//
+//                        Size        vs. full floats   Worst rotation error (measured)
+//  PackedQuaternion48    6 bytes     2.7x smaller      ~0.007 degrees (1.3e-4 radians)
+//  PackedQuaternion32    4 bytes     4x smaller        ~0.23 degrees (4e-3 radians)
+//  PackedTransform       18 bytes    2.2x smaller      (48 bit rotation + 6 halves)
+//  PackedRigidTransform  12 bytes    3.3x smaller      (32 bit rotation + 3 halves + 2 bytes padding, no scale)
+// Half float positions at +/- 10 are off by up to 0.004 per component.
+
+#include <Transform.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sess
+{
+
+//
+// Half floats
+//
+std::uint16_t FloatToHalf(float f); // Rounds to nearest
+float HalfToFloat(std::uint16_t h);
+
+// Batch versions - F16C instructions when they're available (see Simd.h), same results either way
+void FloatToHalfMany(const float* in, std::uint16_t* out, std::size_t n);
+void HalfToFloatMany(const std::uint16_t* in, float* out, std::size_t n);
+
+//
+// Rotations
+//
+struct PackedQuaternion48
+{
+public:
+	std::uint16_t Bits[3];
+
+public:
+	static PackedQuaternion48 Pack(const Quaternion& q);
+	Quaternion Unpack() const;
+};
+
+struct PackedQuaternion32
+{
+public:
+	std::uint32_t Bits;
+
+public:
+	static PackedQuaternion32 Pack(const Quaternion& q);
+	Quaternion Unpack() const;
+};
+
+//
+// Transforms
+//
+struct PackedTransform
+{
+public:
+	PackedQuaternion48 Rotation;
+	std::uint16_t Position[3];
+	std::uint16_t Scale[3];
+
+public:
+	static PackedTransform Pack(const Transform& t);
+	Transform Unpack() const;
+};
+
+// For things that never scale (most skeletons, most props) - scale unpacks as 1
+struct PackedRigidTransform
+{
+public:
+	PackedQuaternion32 Rotation;
+	std::uint16_t Position[3];
+
+public:
+	static PackedRigidTransform Pack(const Transform& t);
+	Transform Unpack() const;
+};
+
+// Batch versions - the rotation math runs on four quaternions per SSE register.
+// Same results as calling Pack/Unpack one at a time.
+void PackMany(const Quaternion* q, PackedQuaternion48* out, std::size_t n);
+void PackMany(const Quaternion* q, PackedQuaternion32* out, std::size_t n);
+void UnpackMany(const PackedQuaternion48* packed, Quaternion* out, std::size_t n);
+void UnpackMany(const PackedQuaternion32* packed, Quaternion* out, std::size_t n);
+void PackMany(const Transform* t, PackedTransform* out, std::size_t n);
+void PackMany(const Transform* t, PackedRigidTransform* out, std::size_t n);
+void UnpackMany(const PackedTransform* packed, Transform* out, std::size_t n);
+void UnpackMany(const PackedRigidTransform* packed, Transform* out, std::size_t n);
+
+//
+// Round trip error
+//
+struct QuantizationError
+{
+public:
+	std::size_t Count;
+	float MaxRotationError; // Radians - the angle of the rotation between original and unpacked
+	float MeanRotationError;
+	float MaxPositionError; // Largest difference in any one component
+	float MaxScaleError;
+
+public:
+	QuantizationError();
+};
+
+// Unpacks each packed value and compares it against the original it was packed from
+QuantizationError MeasureError(const Quaternion* original, const PackedQuaternion48* packed, std::size_t n);
+QuantizationError MeasureError(const Quaternion* original, const PackedQuaternion32* packed, std::size_t n);
+QuantizationError MeasureError(const Transform* original, const PackedTransform* packed, std::size_t n);
+QuantizationError MeasureError(const Transform* original, const PackedRigidTransform* packed, std::size_t n);
+
+};
@@ -1,76 +1,269 @@
 #include <Quaternion.h>
+#include <MathExtras.h>
 #include <algorithm>
+#include <cmath>
 
 namespace sess
 {
 
-const Quaternion Quaternion::Identity = Quaternion(0.f, 0.f, 0.f, 1.f);
+// w is the first constructor argument - (0, 0, 0, 1) here used to be a 180 degree turn about Z
+const Quaternion Quaternion::Identity = Quaternion::Unchecked(1.f, 0.f, 0.f, 0.f);
 
-// Unit quaternion: Arbitrary axis, angle of 0
-Quaternion::Quaternion() : x(0.f), y(0.f), z(0.f), w(1.f)
-{}
+// http://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/
+Quaternion Quaternion::FromMatrix(const Matrix & m)
+{
+	float sx = Vec3(m._11, m._21, m._31).Magnitude();
+	float sy = Vec3(m._12, m._22, m._32).Magnitude();
+	float sz = Vec3(m._13, m._23, m._33).Magnitude();
+
+	float w = sqrtf(std::max(0.f, 1.f + m._11 / sx + m._22 / sy + m._33 / sz)) / 2.f;
+	float x = std::copysignf(sqrtf(std::max(0.f, 1.f + m._11 / sx - m._22 / sy - m._33 / sz)) / 2.f, m._32 / sy - m._23 / sz);
+	float y = std::copysignf(sqrtf(std::max(0.f, 1.f - m._11 / sx + m._22 / sy - m._33 / sz)) / 2.f, m._13 / sz - m._31 / sx);
+	float z = std::copysignf(sqrtf(std::max(0.f, 1.f - m._11 / sx - m._22 / sy + m._33 / sz)) / 2.f, m._21 / sx - m._12 / sy);
+
+	return Quaternion(w, x, y, z);
+}
 
-Quaternion::Quaternion(Vec3 axis, float angle)
-	: w(cosf(angle / 2.f))
-	, x(sinf(angle / 2.f) * axis.x)
-	, y(sinf(angle / 2.f) * axis.y)
-	, z(sinf(angle / 2.f) * axis.z)
+Quaternion Quaternion::Slerp(const Quaternion& a, const Quaternion& b, float t)
 {
-	Normalize();
+	float cosTheta = Dot(a, b);
+	float sign = 1.f;
+	if (cosTheta < 0.f)
+	{
+		cosTheta = -cosTheta;
+		sign = -1.f;
+	}
+
+	// Nearly identical rotations - sin(theta) goes to 0, and the lerp is just as good
+	if (cosTheta > 0.9995f)
+	{
+		return Nlerp(a, b, t);
+	}
+
+	float theta = acosf(cosTheta);
+	float invSinTheta = 1.f / sqrtf(1.f - cosTheta * cosTheta);
+	float wa = sinf((1.f - t) * theta) * invSinTheta;
+	float wb = sinf(t * theta) * invSinTheta * sign;
+
+	return Quaternion(
+		wa * a.w + wb * b.w,
+		wa * a.x + wb * b.x,
+		wa * a.y + wb * b.y,
+		wa * a.z + wb * b.z);
 }
 
-Quaternion::Quaternion(float W, float X, float Y, float Z)
-	: w(W)
-	, x(X)
-	, y(Y)
-	, z(Z)
+Quaternion Quaternion::Nlerp(const Quaternion& a, const Quaternion& b, float t)
 {
-	Normalize();
+	float wb = Dot(a, b) < 0.f ? -t : t;
+	float wa = 1.f - t;
+
+	// Constructor normalizes
+	return Quaternion(
+		wa * a.w + wb * b.w,
+		wa * a.x + wb * b.x,
+		wa * a.y + wb * b.y,
+		wa * a.z + wb * b.z);
 }
 
-Quaternion Quaternion::Inverse() const
+// http://zeux.io/2015/07/23/approximating-slerp/
+// Nlerp moves too fast near the ends and too slow in the middle. The correction
+//  t' = t + t(t - 0.5)(t - 1)k, with k fit as a function of the angle between the
+//  quaternions, pulls the speed back to very nearly constant.
+Quaternion Quaternion::SlerpApprox(const Quaternion& a, const Quaternion& b, float t)
 {
-	return Quaternion(-w, x, y, z);
+	float d = fabsf(Dot(a, b));
+	float A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	float B = 0.848013f + d * (-1.06021f + d * 0.215638f);
+	float k = A * (t - 0.5f) * (t - 0.5f) + B;
+	float ot = t + t * (t - 0.5f) * (t - 1.f) * k;
+
+	return Nlerp(a, b, ot);
 }
 
-Quaternion Quaternion::operator*(const Quaternion& o) const
+//
+// Batch operations
+//
+static_assert(sizeof(Quaternion) == 4u * sizeof(float), "Batch kernels load a Quaternion as one 4-float register");
+static_assert(sizeof(Vec3) == 3u * sizeof(float), "RotateMany expects tightly packed Vec3 arrays");
+
+#if defined(SESS_SIMD_SSE)
+namespace
 {
-	// Multiplying two quaternions together has the effect of performing the
-	//  first rotation, and then performing the second.
-	return Quaternion(
-		o.w * w - o.x * x - o.y * y - o.z * z,
-		o.w * x + o.x * w - o.y * z + o.z * y,
-		o.w * y + o.x * z + o.y * w - o.z * x,
-		o.w * z - o.x * y + o.y * x + o.z * w);
+
+template <int a, int b, int c, int d>
+inline __m128 Swizzle(__m128 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(d, c, b, a));
 }
 
-Quaternion& Quaternion::operator*=(const Quaternion& o)
+// Same as operator*, with lanes (x, y, z, w). Each term of the product is one lane of b
+//  times a shuffled copy of a, with the signs flipped where the formula subtracts.
+inline __m128 MultiplyKernel(__m128 a, __m128 b)
 {
-	return *this = *this * o;
+	const __m128 signX = _mm_setr_ps(0.f, 0.f, -0.f, -0.f);
+	const __m128 signY = _mm_setr_ps(-0.f, 0.f, 0.f, -0.f);
+	const __m128 signZ = _mm_setr_ps(0.f, -0.f, 0.f, -0.f);
+
+	__m128 r = _mm_mul_ps(Swizzle<3, 3, 3, 3>(b), a);
+	r = _mm_add_ps(r, _mm_mul_ps(Swizzle<0, 0, 0, 0>(b), _mm_xor_ps(Swizzle<3, 2, 1, 0>(a), signX)));
+	r = _mm_add_ps(r, _mm_mul_ps(Swizzle<1, 1, 1, 1>(b), _mm_xor_ps(Swizzle<2, 3, 0, 1>(a), signY)));
+	r = _mm_add_ps(r, _mm_mul_ps(Swizzle<2, 2, 2, 2>(b), _mm_xor_ps(Swizzle<1, 0, 3, 2>(a), signZ)));
+	return r;
 }
 
-// http://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/
-Quaternion Quaternion::FromMatrix(const Matrix & m)
+// Sum of all four lanes, in all four lanes
+inline __m128 HorizontalSum(__m128 v)
 {
-	float sx = Vec3(m._11, m._21, m._31).Magnitude();
-	float sy = Vec3(m._12, m._22, m._32).Magnitude();
-	float sz = Vec3(m._13, m._23, m._33).Magnitude();
+	v = _mm_add_ps(v, Swizzle<1, 0, 3, 2>(v));
+	return _mm_add_ps(v, Swizzle<2, 3, 0, 1>(v));
+}
 
-	float w = sqrtf(std::max(0.f, 1.f + m._11 / sx + m._22 / sy + m._33 / sz)) / 2.f;
-	float x = std::copysignf(sqrtf(std::max(0.f, 1.f + m._11 / sx - m._22 / sy - m._33 / sz)) / 2.f, m._32 - m._23);
-	float y = std::copysignf(sqrtf(std::max(0.f, 1.f - m._11 / sx + m._22 / sy - m._33 / sz)) / 2.f, m._13 - m._31);
-	float z = std::copysignf(sqrtf(std::max(0.f, 1.f - m._11 / sx - m._22 / sy + m._33 / sz)) / 2.f, m._21 - m._12);
+inline __m128 InverseSqrt(__m128 v)
+{
+	__m128 r = _mm_rsqrt_ps(v);
+	__m128 rrv = _mm_mul_ps(_mm_mul_ps(r, r), v);
+	return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r), _mm_sub_ps(_mm_set1_ps(3.f), rrv));
+}
 
-	return Quaternion(w, x, y, z);
+};
+#endif
+
+void Quaternion::MultiplyMany(const Quaternion* a, const Quaternion* b, Quaternion* out, std::size_t n)
+{
+#if defined(SESS_SIMD_SSE)
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		_mm_storeu_ps(&out[i].x, MultiplyKernel(_mm_loadu_ps(&a[i].x), _mm_loadu_ps(&b[i].x)));
+	}
+#else
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		out[i] = a[i] * b[i];
+	}
+#endif
+}
+
+void Quaternion::NormalizeMany(Quaternion* q, std::size_t n)
+{
+#if defined(SESS_SIMD_SSE)
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		__m128 v = _mm_loadu_ps(&q[i].x);
+		_mm_storeu_ps(&q[i].x, _mm_mul_ps(v, InverseSqrt(HorizontalSum(_mm_mul_ps(v, v)))));
+	}
+#else
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		q[i].Normalize();
+	}
+#endif
 }
 
-void Quaternion::Normalize()
+void Quaternion::FromMatrixMany(const Matrix* m, Quaternion* out, std::size_t n)
 {
-	float mag = sqrt(x * x + w * w + y * y + z * z);
-	x /= mag;
-	y /= mag;
-	z /= mag;
-	w /= mag;
+	std::size_t i = 0u;
+
+#if defined(SESS_SIMD_SSE)
+	// Four matrices at a time. Transposing row r of four matrices gives _r1, _r2, _r3, _r4
+	//  of all four in separate registers, and then it's the same math as FromMatrix
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps(-0.f);
+	for (; i + 4u <= n; i += 4u)
+	{
+		__m128 e[3][4];
+		for (int row = 0; row < 3; row++)
+		{
+			e[row][0] = _mm_loadu_ps(m[i].m[row]);
+			e[row][1] = _mm_loadu_ps(m[i + 1u].m[row]);
+			e[row][2] = _mm_loadu_ps(m[i + 2u].m[row]);
+			e[row][3] = _mm_loadu_ps(m[i + 3u].m[row]);
+			_MM_TRANSPOSE4_PS(e[row][0], e[row][1], e[row][2], e[row][3]);
+		}
+
+		// Remove scale from the diagonal
+		__m128 isx = InverseSqrt(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e[0][0], e[0][0]), _mm_mul_ps(e[1][0], e[1][0])), _mm_mul_ps(e[2][0], e[2][0])));
+		__m128 isy = InverseSqrt(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e[0][1], e[0][1]), _mm_mul_ps(e[1][1], e[1][1])), _mm_mul_ps(e[2][1], e[2][1])));
+		__m128 isz = InverseSqrt(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e[0][2], e[0][2]), _mm_mul_ps(e[1][2], e[1][2])), _mm_mul_ps(e[2][2], e[2][2])));
+		__m128 d1 = _mm_mul_ps(e[0][0], isx);
+		__m128 d2 = _mm_mul_ps(e[1][1], isy);
+		__m128 d3 = _mm_mul_ps(e[2][2], isz);
+
+		__m128 qw = _mm_mul_ps(half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_add_ps(_mm_add_ps(one, d1), _mm_add_ps(d2, d3)))));
+		__m128 qx = _mm_mul_ps(half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(_mm_add_ps(one, d1), _mm_add_ps(d2, d3)))));
+		__m128 qy = _mm_mul_ps(half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(_mm_add_ps(one, d2), _mm_add_ps(d1, d3)))));
+		__m128 qz = _mm_mul_ps(half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(_mm_add_ps(one, d3), _mm_add_ps(d1, d2)))));
+
+		// copysign - the magnitudes are never negative, so xor-ing in the sign bit is enough
+		qx = _mm_xor_ps(qx, _mm_and_ps(signMask, _mm_sub_ps(_mm_mul_ps(e[2][1], isy), _mm_mul_ps(e[1][2], isz))));
+		qy = _mm_xor_ps(qy, _mm_and_ps(signMask, _mm_sub_ps(_mm_mul_ps(e[0][2], isz), _mm_mul_ps(e[2][0], isx))));
+		qz = _mm_xor_ps(qz, _mm_and_ps(signMask, _mm_sub_ps(_mm_mul_ps(e[1][0], isx), _mm_mul_ps(e[0][1], isy))));
+
+		__m128 invLen = InverseSqrt(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw))));
+		qx = _mm_mul_ps(qx, invLen);
+		qy = _mm_mul_ps(qy, invLen);
+		qz = _mm_mul_ps(qz, invLen);
+		qw = _mm_mul_ps(qw, invLen);
+
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+		_mm_storeu_ps(&out[i].x, qx);
+		_mm_storeu_ps(&out[i + 1u].x, qy);
+		_mm_storeu_ps(&out[i + 2u].x, qz);
+		_mm_storeu_ps(&out[i + 3u].x, qw);
+	}
+#endif
+
+	for (; i < n; i++)
+	{
+		out[i] = FromMatrix(m[i]);
+	}
+}
+
+// Same formula as operator*(Vec3, Quaternion) in MathExtras - see there for details
+void Quaternion::RotateMany(const Vec3* points, Vec3* out, std::size_t n) const
+{
+	std::size_t i = 0u;
+
+#if defined(SESS_SIMD_SSE)
+	// Four points (twelve floats, three registers) at a time. The points are shuffled
+	//  into all-x, all-y and all-z registers, rotated, and shuffled back.
+	const __m128 qx = _mm_set1_ps(x), qy = _mm_set1_ps(y), qz = _mm_set1_ps(z), qw = _mm_set1_ps(w);
+	const __m128 two = _mm_set1_ps(2.f);
+	for (; i + 4u <= n; i += 4u)
+	{
+		const float* src = &points[i].x;
+		__m128 p0 = _mm_loadu_ps(src); // x0 y0 z0 x1
+		__m128 p1 = _mm_loadu_ps(src + 4); // y1 z1 x2 y2
+		__m128 p2 = _mm_loadu_ps(src + 8); // z2 x3 y3 z3
+
+		__m128 vx = _mm_shuffle_ps(p0, _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		__m128 vy = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 vz = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 1, 2, 2)), p2, _MM_SHUFFLE(3, 0, 2, 0));
+
+		// t = 2 (u x v)
+		__m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)));
+		__m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)));
+		__m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)));
+
+		// v' = v + w t + u x t
+		__m128 rx = _mm_add_ps(_mm_add_ps(vx, _mm_mul_ps(qw, tx)), _mm_sub_ps(_mm_mul_ps(qy, tz), _mm_mul_ps(qz, ty)));
+		__m128 ry = _mm_add_ps(_mm_add_ps(vy, _mm_mul_ps(qw, ty)), _mm_sub_ps(_mm_mul_ps(qz, tx), _mm_mul_ps(qx, tz)));
+		__m128 rz = _mm_add_ps(_mm_add_ps(vz, _mm_mul_ps(qw, tz)), _mm_sub_ps(_mm_mul_ps(qx, ty), _mm_mul_ps(qy, tx)));
+
+		float* dst = &out[i].x;
+		__m128 xy = _mm_unpacklo_ps(rx, ry); // x0 y0 x1 y1
+		__m128 xyHi = _mm_unpackhi_ps(rx, ry); // x2 y2 x3 y3
+		_mm_storeu_ps(dst, _mm_shuffle_ps(xy, _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storeu_ps(dst + 4, _mm_shuffle_ps(_mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)), xyHi, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(dst + 8, _mm_shuffle_ps(_mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+#endif
+
+	for (; i < n; i++)
+	{
+		out[i] = points[i] * (*this);
+	}
 }
 
 };
\ No newline at end of file
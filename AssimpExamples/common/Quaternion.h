@@ -8,6 +8,9 @@
 #include <Vec3.h>
 #include <Matrix.h>
 
+#include <cmath>
+#include <cstddef>
+
 namespace sess
 {
 
@@ -17,23 +20,146 @@ public:
 	float x, y, z, w;
 
 public:
-	Quaternion();
+	// Unit quaternion: Arbitrary axis, angle of 0
+	constexpr Quaternion() : x(0.f), y(0.f), z(0.f), w(1.f) {}
 	Quaternion(Vec3 axis, float angle);
 	Quaternion(float w, float x, float y, float z);
 	Quaternion(const Quaternion&) = default;
 	~Quaternion() = default;
 
-	Quaternion Inverse() const;
+	// The constructors above always normalize, which is a waste when the components are
+	//  already known to be unit length (products of unit quaternions, data that was
+	//  normalized when it was saved, etc). This skips it - garbage in, garbage out.
+	static constexpr Quaternion Unchecked(float w, float x, float y, float z)
+	{
+		return Quaternion(w, x, y, z, NoNormalize{});
+	}
+
+	// (-w, x, y, z) is the conjugate negated, which is the same rotation
+	constexpr Quaternion Inverse() const { return Quaternion(-w, x, y, z, NoNormalize{}); }
+	Quaternion Normal() const;
 
-	Quaternion operator*(const Quaternion&) const;
+	// Multiplying two quaternions together has the effect of performing the
+	//  first rotation, and then performing the second.
+	// The product of two unit quaternions is a unit quaternion, so these don't renormalize.
+	//  If you chain thousands of them together, take the Normal() now and then.
+	constexpr Quaternion operator*(const Quaternion& o) const
+	{
+		return Quaternion(
+			o.w * w - o.x * x - o.y * y - o.z * z,
+			o.w * x + o.x * w - o.y * z + o.z * y,
+			o.w * y + o.x * z + o.y * w - o.z * x,
+			o.w * z - o.x * y + o.y * x + o.z * w,
+			NoNormalize{});
+	}
 	Quaternion& operator*=(const Quaternion&);
 
 	static Quaternion FromMatrix(const Matrix& m);
 
+	// Same as the axis/angle constructor, with the sin and cos coming from a precision
+	//  policy (MathPolicy.h). FastMath is a good fit for things like camera controls that
+	//  build a new rotation every frame.
+	template <typename Math = ExactMath>
+	static Quaternion FromAxisAngle(const Vec3& axis, float angle);
+
+	// Batch versions of the above, for long arrays (skinning, bounds, animation data).
+	// All of these may write to the same array they read from.
+
+	// out[i] = a[i] * b[i]
+	static void MultiplyMany(const Quaternion* a, const Quaternion* b, Quaternion* out, std::size_t n);
+
+	// Normalizes every quaternion in place
+	static void NormalizeMany(Quaternion* q, std::size_t n);
+
+	// out[i] = FromMatrix(m[i])
+	static void FromMatrixMany(const Matrix* m, Quaternion* out, std::size_t n);
+
+	// out[i] = points[i] * (*this), i.e. rotate every point by this quaternion
+	void RotateMany(const Vec3* points, Vec3* out, std::size_t n) const;
+
+	static constexpr float Dot(const Quaternion& a, const Quaternion& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	}
+
+	// Interpolation between two rotations. t = 0 gives a, t = 1 gives b.
+	// q and -q are the same rotation, so all of these flip b if needed to take the
+	//  shorter way around - otherwise a blend can spin the long way (almost 360 degrees).
+
+	// Spherical linear interpolation - constant angular speed along the shortest arc.
+	static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+
+	// Normalized linear interpolation - cheap, same path as slerp but the speed isn't
+	//  constant across the blend. Great for blending nearby poses.
+	static Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t);
+
+	// Nlerp with t adjusted by a polynomial fit so the speed matches slerp. No trig at all.
+	// Stays within about 4e-4 of Slerp per quaternion component, which is at most about 8e-4
+	//  radians (0.05 degrees) of rotation between the two results (mathbench --accuracy).
+	static Quaternion SlerpApprox(const Quaternion& a, const Quaternion& b, float t);
+
 	static const Quaternion Identity;
 
 protected:
 	void Normalize();
+
+	struct NoNormalize {};
+	constexpr Quaternion(float W, float X, float Y, float Z, NoNormalize) : x(X), y(Y), z(Z), w(W) {}
 };
 
+inline Quaternion::Quaternion(Vec3 axis, float angle)
+	: Quaternion(FromAxisAngle(axis, angle))
+{}
+
+template <typename Math>
+inline Quaternion Quaternion::FromAxisAngle(const Vec3& axis, float angle)
+{
+	float s, c;
+	Math::SinCos(angle / 2.f, s, c);
+
+	Quaternion q(c, s * axis.x, s * axis.y, s * axis.z, NoNormalize{});
+	q.Normalize();
+	return q;
+}
+
+inline Quaternion::Quaternion(float W, float X, float Y, float Z)
+	: x(X)
+	, y(Y)
+	, z(Z)
+	, w(W)
+{
+	Normalize();
+}
+
+inline Quaternion Quaternion::Normal() const
+{
+	Quaternion q(*this);
+	q.Normalize();
+	return q;
+}
+
+inline Quaternion& Quaternion::operator*=(const Quaternion& o)
+{
+	return *this = *this * o;
+}
+
+inline void Quaternion::Normalize()
+{
+	float magSq = x * x + y * y + z * z + w * w;
+
+#if defined(SESS_SIMD_SSE)
+	// rsqrtss is only good to ~12 bits, one Newton-Raphson step takes it to ~23.
+	//  Still much cheaper than a sqrt and four divides.
+	float invMag = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(magSq)));
+	invMag = invMag * (1.5f - 0.5f * magSq * invMag * invMag);
+#else
+	float invMag = 1.f / sqrtf(magSq);
+#endif
+
+	x *= invMag;
+	y *= invMag;
+	z *= invMag;
+	w *= invMag;
+}
+
 };
\ No newline at end of file
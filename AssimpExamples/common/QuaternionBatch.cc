@@ -0,0 +1,115 @@
+#include <QuaternionBatch.h>
+
+namespace sess
+{
+
+namespace
+{
+
+// Shared body of NlerpMany and the approximate SlerpMany - they only differ in how t
+//  is adjusted before the normalized lerp (see Quaternion::SlerpApprox)
+template <bool correctT>
+void BlendOne(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out, std::size_t i)
+{
+	Quaternion qa(a.W[i], a.X[i], a.Y[i], a.Z[i]);
+	Quaternion qb(b.W[i], b.X[i], b.Y[i], b.Z[i]);
+	out.Set(i, correctT ? Quaternion::SlerpApprox(qa, qb, t) : Quaternion::Nlerp(qa, qb, t));
+}
+
+#if defined(SESS_SIMD_SSE)
+template <typename Lanes, bool correctT>
+void BlendLanes(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out, std::size_t i)
+{
+	typedef typename Lanes::V V;
+
+	V ax = Lanes::Load(&a.X[i]), ay = Lanes::Load(&a.Y[i]), az = Lanes::Load(&a.Z[i]), aw = Lanes::Load(&a.W[i]);
+	V bx = Lanes::Load(&b.X[i]), by = Lanes::Load(&b.Y[i]), bz = Lanes::Load(&b.Z[i]), bw = Lanes::Load(&b.W[i]);
+
+	V d = Lanes::Add(Lanes::Add(Lanes::Mul(ax, bx), Lanes::Mul(ay, by)), Lanes::Add(Lanes::Mul(az, bz), Lanes::Mul(aw, bw)));
+
+	// Shortest path - flip b wherever the dot product is negative, without branching
+	V sign = Lanes::SignBits(d);
+	bx = Lanes::Xor(bx, sign);
+	by = Lanes::Xor(by, sign);
+	bz = Lanes::Xor(bz, sign);
+	bw = Lanes::Xor(bw, sign);
+
+	V wb = Lanes::Set(t);
+	if (correctT)
+	{
+		V absD = Lanes::Xor(d, sign);
+		V A = Lanes::Add(Lanes::Set(1.0904f), Lanes::Mul(absD, Lanes::Add(Lanes::Set(-3.2452f),
+			Lanes::Mul(absD, Lanes::Sub(Lanes::Set(3.55645f), Lanes::Mul(absD, Lanes::Set(1.43519f)))))));
+		V B = Lanes::Add(Lanes::Set(0.848013f), Lanes::Mul(absD, Lanes::Add(Lanes::Set(-1.06021f), Lanes::Mul(absD, Lanes::Set(0.215638f)))));
+		V k = Lanes::Add(Lanes::Mul(A, Lanes::Set((t - 0.5f) * (t - 0.5f))), B);
+		wb = Lanes::Add(wb, Lanes::Mul(Lanes::Set(t * (t - 0.5f) * (t - 1.f)), k));
+	}
+	V wa = Lanes::Sub(Lanes::Set(1.f), wb);
+
+	V rx = Lanes::Add(Lanes::Mul(wa, ax), Lanes::Mul(wb, bx));
+	V ry = Lanes::Add(Lanes::Mul(wa, ay), Lanes::Mul(wb, by));
+	V rz = Lanes::Add(Lanes::Mul(wa, az), Lanes::Mul(wb, bz));
+	V rw = Lanes::Add(Lanes::Mul(wa, aw), Lanes::Mul(wb, bw));
+
+	V lenSq = Lanes::Add(Lanes::Add(Lanes::Mul(rx, rx), Lanes::Mul(ry, ry)), Lanes::Add(Lanes::Mul(rz, rz), Lanes::Mul(rw, rw)));
+	V invLen = Lanes::Div(Lanes::Set(1.f), Lanes::Sqrt(lenSq));
+
+	Lanes::Store(&out.X[i], Lanes::Mul(rx, invLen));
+	Lanes::Store(&out.Y[i], Lanes::Mul(ry, invLen));
+	Lanes::Store(&out.Z[i], Lanes::Mul(rz, invLen));
+	Lanes::Store(&out.W[i], Lanes::Mul(rw, invLen));
+}
+#endif
+
+template <bool correctT>
+void BlendMany(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out)
+{
+	std::size_t n = a.Size();
+	out.Resize(n);
+
+	std::size_t i = 0u;
+#if defined(SESS_SIMD_AVX)
+	for (; i + AvxLanes::Width <= n; i += AvxLanes::Width)
+	{
+		BlendLanes<AvxLanes, correctT>(a, b, t, out, i);
+	}
+#endif
+#if defined(SESS_SIMD_SSE)
+	for (; i + SseLanes::Width <= n; i += SseLanes::Width)
+	{
+		BlendLanes<SseLanes, correctT>(a, b, t, out, i);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		BlendOne<correctT>(a, b, t, out, i);
+	}
+}
+
+};
+
+void SlerpMany(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out, SlerpPrecision precision)
+{
+	if (precision == SlerpPrecision::Approximate)
+	{
+		BlendMany<true>(a, b, t, out);
+		return;
+	}
+
+	std::size_t n = a.Size();
+	out.Resize(n);
+	for (std::size_t i = 0u; i < n; i++)
+	{
+		out.Set(i, Quaternion::Slerp(
+			Quaternion(a.W[i], a.X[i], a.Y[i], a.Z[i]),
+			Quaternion(b.W[i], b.X[i], b.Y[i], b.Z[i]),
+			t));
+	}
+}
+
+void NlerpMany(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out)
+{
+	BlendMany<false>(a, b, t, out);
+}
+
+};
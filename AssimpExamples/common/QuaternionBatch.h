@@ -0,0 +1,26 @@
+#pragma once
+
+// Batch versions of the Quaternion operations, for when there are thousands of them
+//  to get through at once (blending every joint of every animated character, for example).
+// These work on QuaternionSoA streams so that SSE/AVX can process 4/8 quaternions per
+//  instruction, and produce the same results as calling the Quaternion methods one at a time.
+
+#include <TransformSoA.h>
+
+namespace sess
+{
+
+enum class SlerpPrecision
+{
+	Exact, // Same as Quaternion::Slerp. Needs acos/sin per quaternion, so it isn't vectorized.
+	Approximate // Same as Quaternion::SlerpApprox. Vectorized, no trig.
+};
+
+// out[i] = Quaternion::Slerp(a[i], b[i], t) (or SlerpApprox)
+// out is resized to match the inputs, and may be the same object as a or b.
+void SlerpMany(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out, SlerpPrecision precision = SlerpPrecision::Exact);
+
+// out[i] = Quaternion::Nlerp(a[i], b[i], t)
+void NlerpMany(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out);
+
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+// SIMD feature detection for the math code in common/
+// Everything that has a vectorized kernel also has a plain C++ version, so the
+//  demos still build on compilers/architectures that don't have SSE available.
+// x64 always has SSE2, and Visual Studio defines __AVX__ when building with /arch:AVX.
+// Define SESS_NO_SIMD to force the scalar paths everywhere - handy for checking that
+//  a SIMD kernel agrees with the plain version.
+
+#if !defined(SESS_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SESS_SIMD_SSE 1
+#endif
+#if defined(SESS_SIMD_SSE) && defined(__AVX__)
+#define SESS_SIMD_AVX 1
+#endif
+// Half float conversion instructions. Every AVX2 chip has them, and Visual Studio doesn't
+//  have a separate switch (or define) for them, so /arch:AVX2 is what turns them on there.
+#if defined(SESS_SIMD_AVX) && (defined(__F16C__) || defined(__AVX2__))
+#define SESS_SIMD_F16C 1
+#endif
+#endif
+
+#if defined(SESS_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(SESS_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+#if defined(SESS_SIMD_SSE)
+#include <cstddef>
+
+namespace sess
+{
+
+// Thin wrappers around the intrinsics, so a batch kernel can be written once as a template
+//  and instantiated for 4-wide SSE and 8-wide AVX registers.
+struct SseLanes
+{
+	typedef __m128 V;
+	static const std::size_t Width = 4u;
+	static V Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, V v) { _mm_storeu_ps(p, v); }
+	static V Set(float f) { return _mm_set1_ps(f); }
+	static V Add(V a, V b) { return _mm_add_ps(a, b); }
+	static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+	static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static V Div(V a, V b) { return _mm_div_ps(a, b); }
+	static V Sqrt(V a) { return _mm_sqrt_ps(a); }
+	static V Min(V a, V b) { return _mm_min_ps(a, b); }
+	static V Max(V a, V b) { return _mm_max_ps(a, b); }
+	static V And(V a, V b) { return _mm_and_ps(a, b); }
+	static V Or(V a, V b) { return _mm_or_ps(a, b); }
+	static V Xor(V a, V b) { return _mm_xor_ps(a, b); }
+	static V SignBits(V a) { return _mm_and_ps(a, _mm_set1_ps(-0.f)); }
+	static V Abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+	static V CmpLt(V a, V b) { return _mm_cmplt_ps(a, b); }
+	static int MoveMask(V a) { return _mm_movemask_ps(a); } // One bit per lane, from the sign bit
+	static __m128 Half(V v, int) { return v; }
+};
+
+#if defined(SESS_SIMD_AVX)
+struct AvxLanes
+{
+	typedef __m256 V;
+	static const std::size_t Width = 8u;
+	static V Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, V v) { _mm256_storeu_ps(p, v); }
+	static V Set(float f) { return _mm256_set1_ps(f); }
+	static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+	static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static V Div(V a, V b) { return _mm256_div_ps(a, b); }
+	static V Sqrt(V a) { return _mm256_sqrt_ps(a); }
+	static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+	static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+	static V And(V a, V b) { return _mm256_and_ps(a, b); }
+	static V Or(V a, V b) { return _mm256_or_ps(a, b); }
+	static V Xor(V a, V b) { return _mm256_xor_ps(a, b); }
+	static V SignBits(V a) { return _mm256_and_ps(a, _mm256_set1_ps(-0.f)); }
+	static V Abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+	static V CmpLt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static int MoveMask(V a) { return _mm256_movemask_ps(a); }
+	static __m128 Half(V v, int half) { return half == 0 ? _mm256_castps256_ps128(v) : _mm256_extractf128_ps(v, 1); }
+};
+#endif
+
+};
+#endif
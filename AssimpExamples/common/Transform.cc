@@ -27,56 +27,115 @@ Transform Transform::operator*(const Transform& o) const
 		);
 }
 
-Matrix Transform::GetTransformMatrix() const
+// Rows of the matrix are the scaled rotation axes, then the position. Written in row order
+//  and left to FromRows to lay out, so both layouts come out of the same code.
+template <typename Layout>
+MatrixT<Layout> Transform::GetTransformMatrix() const
 {
-	Matrix m;
+	return MatrixT<Layout>::FromRows(
+		Scale.x * (1.f - 2.f * Rotation.y * Rotation.y - 2.f * Rotation.z * Rotation.z),
+		Scale.x * (2.f * Rotation.x * Rotation.y + 2.f * Rotation.z * Rotation.w),
+		Scale.x * (2.f * Rotation.x * Rotation.z - 2.f * Rotation.y * Rotation.w),
+		0.f,
+
+		Scale.y * (2.f * Rotation.x * Rotation.y - 2.f * Rotation.z * Rotation.w),
+		Scale.y * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.z * Rotation.z),
+		Scale.y * (2.f * Rotation.y * Rotation.z + 2.f * Rotation.x * Rotation.w),
+		0.f,
+
+		Scale.z * (2.f * Rotation.x * Rotation.z + 2.f * Rotation.y * Rotation.w),
+		Scale.z * (2.f * Rotation.y * Rotation.z - 2.f * Rotation.x * Rotation.w),
+		Scale.z * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.y * Rotation.y),
+		0.f,
+
+		Position.x, Position.y, Position.z, 1.f);
+}
+
+template MatrixT<RowMajor> Transform::GetTransformMatrix<RowMajor>() const;
+template MatrixT<ColumnMajor> Transform::GetTransformMatrix<ColumnMajor>() const;
 
-	m._11 = Scale.x * (1.f - 2.f * Rotation.y * Rotation.y - 2.f * Rotation.z * Rotation.z);
-	m._12 = Scale.y * (2.f * Rotation.x * Rotation.y - 2.f * Rotation.z * Rotation.w);
-	m._13 = Scale.z * (2.f * Rotation.x * Rotation.z + 2.f * Rotation.y * Rotation.w);
-	m._14 = Position.x;
+Affine3x4 Transform::GetAffineMatrix() const
+{
+	return Affine3x4::FromRows(
+		Scale.x * (1.f - 2.f * Rotation.y * Rotation.y - 2.f * Rotation.z * Rotation.z),
+		Scale.x * (2.f * Rotation.x * Rotation.y + 2.f * Rotation.z * Rotation.w),
+		Scale.x * (2.f * Rotation.x * Rotation.z - 2.f * Rotation.y * Rotation.w),
 
-	m._21 = Scale.x * (2.f * Rotation.x * Rotation.y + 2.f * Rotation.z * Rotation.w);
-	m._22 = Scale.y * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.z * Rotation.z);
-	m._23 = Scale.z * (2.f * Rotation.y * Rotation.z - 2.f * Rotation.x * Rotation.w);
-	m._24 = Position.y;
+		Scale.y * (2.f * Rotation.x * Rotation.y - 2.f * Rotation.z * Rotation.w),
+		Scale.y * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.z * Rotation.z),
+		Scale.y * (2.f * Rotation.y * Rotation.z + 2.f * Rotation.x * Rotation.w),
 
-	m._31 = Scale.x * (2.f * Rotation.x * Rotation.z - 2.f * Rotation.y * Rotation.w);
-	m._32 = Scale.y * (2.f * Rotation.y * Rotation.z + 2.f * Rotation.x * Rotation.w);
-	m._33 = Scale.z * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.y * Rotation.y);
-	m._34 = Position.z;
+		Scale.z * (2.f * Rotation.x * Rotation.z + 2.f * Rotation.y * Rotation.w),
+		Scale.z * (2.f * Rotation.y * Rotation.z - 2.f * Rotation.x * Rotation.w),
+		Scale.z * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.y * Rotation.y),
 
-	m._41 = 0.f;
-	m._42 = 0.f;
-	m._43 = 0.f;
-	m._44 = 1.f;
+		Position.x, Position.y, Position.z);
+}
 
-	return m;
+// Written as a row vector times M (like GetTransformMatrix), with A the scaled rotation axes:
+// M = | A 0 |   so   M^-1 = |    A^-1    0 |
+//     | P 1 |                | -P A^-1    1 |
+// A^-1 is the unscaled rotation transposed, with each column divided by that axis' scale.
+Matrix Transform::GetInverseTransformMatrix() const
+{
+	float ix = 1.f / Scale.x;
+	float iy = 1.f / Scale.y;
+	float iz = 1.f / Scale.z;
+
+	// Each rotation axis divided by its scale - these end up as the columns of A^-1
+	Vec3 xAxis(
+		ix * (1.f - 2.f * Rotation.y * Rotation.y - 2.f * Rotation.z * Rotation.z),
+		ix * (2.f * Rotation.x * Rotation.y + 2.f * Rotation.z * Rotation.w),
+		ix * (2.f * Rotation.x * Rotation.z - 2.f * Rotation.y * Rotation.w));
+	Vec3 yAxis(
+		iy * (2.f * Rotation.x * Rotation.y - 2.f * Rotation.z * Rotation.w),
+		iy * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.z * Rotation.z),
+		iy * (2.f * Rotation.y * Rotation.z + 2.f * Rotation.x * Rotation.w));
+	Vec3 zAxis(
+		iz * (2.f * Rotation.x * Rotation.z + 2.f * Rotation.y * Rotation.w),
+		iz * (2.f * Rotation.y * Rotation.z - 2.f * Rotation.x * Rotation.w),
+		iz * (1.f - 2.f * Rotation.x * Rotation.x - 2.f * Rotation.y * Rotation.y));
+
+	return Matrix::FromRows(
+		xAxis.x, yAxis.x, zAxis.x, 0.f,
+		xAxis.y, yAxis.y, zAxis.y, 0.f,
+		xAxis.z, yAxis.z, zAxis.z, 0.f,
+		-Vec3::Dot(xAxis, Position), -Vec3::Dot(yAxis, Position), -Vec3::Dot(zAxis, Position), 1.f);
 }
 
+// (RS)^-T = R^-T S^-T = R S^-1, since R is orthonormal and S is diagonal
+Matrix Transform::GetNormalMatrix() const
+{
+	return Transform(Vec3::Zero, Rotation, Vec3(1.f / Scale.x, 1.f / Scale.y, 1.f / Scale.z)).GetTransformMatrix();
+}
+
+// Applying a transform is p' = Position + Rotation(Scale * p), so undoing it is
+//  p = Scale^-1 * Rotation^-1(p' - Position). That only splits back into a clean
+//  position/rotation/scale when the scale commutes with the rotation (uniform scale).
 Transform Transform::Inverse() const
 {
-	return Transform({ -Position, Rotation.Inverse(), Vec3(1.f / Scale.x, 1.f / Scale.y, 1.f / Scale.z) });
+	Quaternion inverseRotation = Rotation.Inverse();
+	Vec3 inverseScale(1.f / Scale.x, 1.f / Scale.y, 1.f / Scale.z);
+
+	return Transform(
+		-Vec3::ComponentProduct(Position * inverseRotation, inverseScale),
+		inverseRotation,
+		inverseScale
+		);
 }
 
 Transform Transform::Lerp(const Transform& t1, const Transform& t2, float ratio)
 {
-	// TODO SESS: Might not be accurate enough, use Slerp for quaternions
 	return Transform(
 		t1.Position * (1.f - ratio) + t2.Position * ratio,
-		Quaternion(
-			t1.Rotation.w * (1.f - ratio) + t2.Rotation.w * ratio,
-			t1.Rotation.x * (1.f - ratio) + t2.Rotation.x * ratio,
-			t1.Rotation.y * (1.f - ratio) + t2.Rotation.y * ratio,
-			t1.Rotation.z * (1.f - ratio) + t2.Rotation.z * ratio
-			),
+		Quaternion::Slerp(t1.Rotation, t2.Rotation, ratio),
 		t1.Scale * (1.f - ratio) + t2.Scale * ratio
 		);
 }
 
 Transform Transform::FromTransformMatrix(const Matrix& m)
 {
-	Vec3 pos(m._14, m._24, m._34);
+	Vec3 pos(m.At(3, 0), m.At(3, 1), m.At(3, 2));
 
 	// To find rotation, perform a rotation on a special vector.
 	// Where M is the transformation matrix, R is the rotation
@@ -89,9 +148,9 @@ Transform Transform::FromTransformMatrix(const Matrix& m)
 	// RSt = t'
 	// St = R^(-1)t'
 
-	float sx = Vec3(m._11, m._21, m._31).Magnitude();
-	float sy = Vec3(m._12, m._22, m._32).Magnitude();
-	float sz = Vec3(m._13, m._23, m._33).Magnitude();
+	float sx = Vec3(m.At(0, 0), m.At(0, 1), m.At(0, 2)).Magnitude();
+	float sy = Vec3(m.At(1, 0), m.At(1, 1), m.At(1, 2)).Magnitude();
+	float sz = Vec3(m.At(2, 0), m.At(2, 1), m.At(2, 2)).Magnitude();
 
 	// http://stackoverflow.com/questions/1171849/finding-quaternion-representing-the-rotation-from-one-vector-to-another
 	Quaternion rotation = Quaternion::FromMatrix(m);
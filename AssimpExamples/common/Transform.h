@@ -5,9 +5,11 @@
 //  convert to a matrix before sending to the GPU.
 // Realistically matrices could be exclusively used, but it's much easier to debug
 //  and reason about code in this format.
-// Is it faster or slower? No clue. I actually haven't profiled it.
+// Is it faster or slower? Depends what for - benchmarks/ (mathbench) has numbers for
+//  GetTransformMatrix, FromTransformMatrix and friends, next to the Matrix versions.
 
 #include <MathExtras.h>
+#include <Affine3x4.h>
 
 namespace sess
 {
@@ -28,13 +30,30 @@ public:
 	// Combine two transformations together
 	Transform operator*(const Transform& rhs) const;
 
-	Matrix GetTransformMatrix() const;
+	// Defaults to Matrix (column major, ready for the GPU). Instantiated for both layouts.
+	template <typename Layout = ColumnMajor>
+	MatrixT<Layout> GetTransformMatrix() const;
+
+	// Same matrix without the constant 0 0 0 1 column - 48 bytes instead of 64, and
+	//  cheaper to multiply together. What the shaders take for the model transform.
+	Affine3x4 GetAffineMatrix() const;
+
+	// Inverse of GetTransformMatrix(), built straight from the components - no general
+	//  4x4 inverse required. Exact for non-uniform scale too, unlike Inverse() below.
+	Matrix GetInverseTransformMatrix() const;
+
+	// Matrix for transforming normals (inverse transpose of the rotation/scale part).
+	// With position/rotation/scale split out, that's just rotation with 1/scale.
+	Matrix GetNormalMatrix() const;
+
+	// Position/rotation/scale can't represent the inverse of a non-uniformly scaled
+	//  transform, so this is only exact with uniform scale. Use GetInverseTransformMatrix otherwise.
 	Transform Inverse() const;
 	static Transform FromTransformMatrix(const Matrix& m);
 
 	// Interpolate between the two transformations. A ratio of 0 means use t1,
 	//  a ratio of 1 means t2, and something in the middle means mix the two.
-	// 0.25 means use 25% of t1, and 75% of t2, for example.
+	// 0.25 means use 75% of t1, and 25% of t2, for example.
 	// Position and scale interpolated linearly, rotation interpolated spherically
 	static Transform Lerp(const Transform& t1, const Transform& t2, float ratio);
 
@@ -0,0 +1,259 @@
+#include <TransformHierarchy.h>
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <future>
+
+namespace sess
+{
+
+namespace
+{
+
+// Fewer nodes than this on a level, and it isn't worth starting a thread for them
+const std::size_t MinNodesPerTask = 256u;
+
+};
+
+const std::uint32_t TransformHierarchy::NoParent;
+
+TransformHierarchy::TransformHierarchy()
+	: firstDirty_(0u)
+	, levelsValid_(true)
+{}
+
+std::size_t TransformHierarchy::Size() const
+{
+	return local_.size();
+}
+
+void TransformHierarchy::Reserve(std::size_t n)
+{
+	local_.reserve(n);
+	parent_.reserve(n);
+	world_.reserve(n);
+	dirty_.reserve(n);
+	depth_.reserve(n);
+}
+
+void TransformHierarchy::Clear()
+{
+	local_.clear();
+	parent_.clear();
+	world_.clear();
+	dirty_.clear();
+	depth_.clear();
+	levels_.clear();
+	firstDirty_ = 0u;
+	levelsValid_ = true;
+}
+
+std::uint32_t TransformHierarchy::Add(const Transform& local, std::uint32_t parent)
+{
+	std::uint32_t idx = (std::uint32_t)local_.size();
+
+	// A parent that doesn't exist yet would break the ordering, so treat it as a root instead
+	if (parent != NoParent && parent >= idx)
+	{
+		parent = NoParent;
+	}
+
+	local_.push_back(local);
+	parent_.push_back(parent);
+	world_.push_back(Affine3x4::Identity);
+	dirty_.push_back(1u);
+	depth_.push_back(parent == NoParent ? 0u : depth_[parent] + 1u);
+
+	firstDirty_ = std::min(firstDirty_, (std::size_t)idx);
+	levelsValid_ = false;
+
+	return idx;
+}
+
+std::uint32_t TransformHierarchy::AddAssimpNodes(const aiNode* node, std::uint32_t parent, std::vector<const aiNode*>* sourceNodes)
+{
+	// Same storage order as Matrix - translation in a4, b4, c4
+	const aiMatrix4x4& t = node->mTransformation;
+	Matrix local(
+		t.a1, t.a2, t.a3, t.a4,
+		t.b1, t.b2, t.b3, t.b4,
+		t.c1, t.c2, t.c3, t.c4,
+		t.d1, t.d2, t.d3, t.d4);
+
+	std::uint32_t idx = Add(Transform::FromTransformMatrix(local), parent);
+	if (sourceNodes)
+	{
+		sourceNodes->resize(Size());
+		(*sourceNodes)[idx] = node;
+	}
+
+	for (std::uint32_t childIdx = 0u; childIdx < node->mNumChildren; childIdx++)
+	{
+		AddAssimpNodes(node->mChildren[childIdx], idx, sourceNodes);
+	}
+
+	return idx;
+}
+
+std::uint32_t TransformHierarchy::GetParent(std::uint32_t idx) const
+{
+	return parent_[idx];
+}
+
+const Transform& TransformHierarchy::GetLocal(std::uint32_t idx) const
+{
+	return local_[idx];
+}
+
+void TransformHierarchy::SetLocal(std::uint32_t idx, const Transform& local)
+{
+	local_[idx] = local;
+	dirty_[idx] = 1u;
+	firstDirty_ = std::min(firstDirty_, (std::size_t)idx);
+}
+
+const Affine3x4& TransformHierarchy::GetWorldMatrix(std::uint32_t idx) const
+{
+	return world_[idx];
+}
+
+const Affine3x4* TransformHierarchy::GetWorldMatrices() const
+{
+	return world_.data();
+}
+
+bool TransformHierarchy::IsDirty() const
+{
+	return firstDirty_ < local_.size();
+}
+
+void TransformHierarchy::UpdateNode(std::uint32_t idx)
+{
+	std::uint32_t parent = parent_[idx];
+	if (parent == NoParent)
+	{
+		world_[idx] = local_[idx].GetAffineMatrix();
+	}
+	else
+	{
+		world_[idx] = local_[idx].GetAffineMatrix() * world_[parent];
+	}
+}
+
+std::size_t TransformHierarchy::Update()
+{
+	std::size_t n = local_.size();
+	std::size_t updated = 0u;
+
+	// Parents come first, so by the time a node is reached its parent's flag is final -
+	//  a dirty parent means a dirty child, and the flag gets passed along down the tree.
+	for (std::size_t i = firstDirty_; i < n; i++)
+	{
+		std::uint32_t parent = parent_[i];
+		if (parent != NoParent && dirty_[parent])
+		{
+			dirty_[i] = 1u;
+		}
+
+		if (dirty_[i])
+		{
+			UpdateNode((std::uint32_t)i);
+			updated++;
+		}
+	}
+
+	if (firstDirty_ < n)
+	{
+		std::fill(dirty_.begin() + firstDirty_, dirty_.end(), (std::uint8_t)0u);
+	}
+	firstDirty_ = n;
+
+	return updated;
+}
+
+void TransformHierarchy::BuildLevels()
+{
+	if (levelsValid_)
+	{
+		return;
+	}
+
+	levels_.clear();
+	for (std::size_t i = 0u; i < depth_.size(); i++)
+	{
+		if (depth_[i] >= levels_.size())
+		{
+			levels_.resize(depth_[i] + 1u);
+		}
+		levels_[depth_[i]].push_back((std::uint32_t)i);
+	}
+
+	levelsValid_ = true;
+}
+
+std::size_t TransformHierarchy::UpdateParallel(std::size_t maxTasks)
+{
+	if (!IsDirty())
+	{
+		return 0u;
+	}
+
+	BuildLevels();
+
+	// Same as the loop in Update, over any list of nodes whose parents are all done
+	auto updateNodes = [this](const std::uint32_t* nodes, std::size_t count) -> std::size_t {
+		std::size_t updated = 0u;
+		for (std::size_t i = 0u; i < count; i++)
+		{
+			std::uint32_t idx = nodes[i];
+			std::uint32_t parent = parent_[idx];
+			if (parent != NoParent && dirty_[parent])
+			{
+				dirty_[idx] = 1u;
+			}
+
+			if (dirty_[idx])
+			{
+				UpdateNode(idx);
+				updated++;
+			}
+		}
+		return updated;
+	};
+
+	std::size_t updated = 0u;
+	std::vector<std::future<std::size_t>> tasks;
+	for (auto&& level : levels_)
+	{
+		std::size_t taskCount = std::min(maxTasks, level.size() / MinNodesPerTask);
+		if (taskCount <= 1u)
+		{
+			updated += updateNodes(level.data(), level.size());
+			continue;
+		}
+
+		// The last chunk runs on this thread while the others are busy
+		std::size_t chunk = (level.size() + taskCount - 1u) / taskCount;
+		tasks.clear();
+		for (std::size_t first = 0u; first + chunk < level.size(); first += chunk)
+		{
+			tasks.push_back(std::async(std::launch::async, updateNodes, level.data() + first, chunk));
+		}
+		std::size_t last = tasks.size() * chunk;
+		updated += updateNodes(level.data() + last, level.size() - last);
+
+		// Every task has to finish before the next level can start
+		for (auto&& task : tasks)
+		{
+			updated += task.get();
+		}
+	}
+
+	std::fill(dirty_.begin() + firstDirty_, dirty_.end(), (std::uint8_t)0u);
+	firstDirty_ = local_.size();
+
+	return updated;
+}
+
+};
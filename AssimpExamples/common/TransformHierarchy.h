@@ -0,0 +1,100 @@
+#pragma once
+
+// Parent/child transforms - a wheel is attached to a car, a hand to an arm, and when the
+//  parent moves, everything attached to it moves too.
+// The obvious way to store that is a tree of node objects with child pointers, but walking
+//  pointers all over the heap is slow, and recursion gets deep for big imported scenes.
+//  Instead every node lives in a handful of flat arrays, and points at its parent by index.
+// Nodes are kept in topological order - a parent always comes before its children - so
+//  world matrices can be worked out in one front-to-back sweep, with the parent's world
+//  matrix always ready by the time a child needs it.
+// Moving a node only marks it dirty. Update() then recomputes the dirty nodes and everything
+//  underneath them, and skips the rest of the scene entirely.
+
+#include <Transform.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct aiNode;
+
+namespace sess
+{
+
+class TransformHierarchy
+{
+public:
+	static const std::uint32_t NoParent = 0xFFFFFFFFu;
+
+public:
+	TransformHierarchy();
+	TransformHierarchy(const TransformHierarchy&) = default;
+	TransformHierarchy(TransformHierarchy&&) = default;
+	~TransformHierarchy() = default;
+
+	std::size_t Size() const;
+	void Reserve(std::size_t n);
+	void Clear();
+
+	// Adds a node and returns its index. The parent has to be in the hierarchy already
+	//  (or NoParent for a root), which is what keeps everything in topological order.
+	std::uint32_t Add(const Transform& local, std::uint32_t parent = NoParent);
+
+	// Adds an Assimp node and all of its children (aiNode::mTransformation) under parent, and
+	//  returns the index of the first one. Nodes are added depth first, so the whole subtree
+	//  ends up in [returned index, Size()).
+	// If sourceNodes is given, it is resized to Size() and sourceNodes[i] is the aiNode that
+	//  node i came from - handy for finding which meshes (aiNode::mMeshes) hang off of it.
+	// Node matrices are split into position/rotation/scale, so any shear is lost.
+	std::uint32_t AddAssimpNodes(const aiNode* node, std::uint32_t parent = NoParent, std::vector<const aiNode*>* sourceNodes = nullptr);
+
+	std::uint32_t GetParent(std::uint32_t idx) const;
+	const Transform& GetLocal(std::uint32_t idx) const;
+
+	// Marks the node (and so everything under it) as needing an update
+	void SetLocal(std::uint32_t idx, const Transform& local);
+
+	// Only up to date after Update() - these don't work anything out themselves.
+	// World matrices are affine (48 bytes each, no constant 0 0 0 1 column), which is also
+	//  what the shaders take - use ToMatrix() on one if a full Matrix is needed.
+	const Affine3x4& GetWorldMatrix(std::uint32_t idx) const;
+	const Affine3x4* GetWorldMatrices() const;
+
+	bool IsDirty() const;
+
+	// Recomputes world matrices for dirty nodes and all of their descendants.
+	// Returns how many nodes were recomputed.
+	std::size_t Update();
+
+	// Same thing, but nodes at the same depth don't depend on each other, so each level of
+	//  the tree is split up between up to maxTasks std::async tasks. Levels that are too
+	//  small to be worth a thread are done inline - this only pays off for big scenes.
+	std::size_t UpdateParallel(std::size_t maxTasks);
+
+protected:
+	// world = local, then the parent's world
+	void UpdateNode(std::uint32_t idx);
+
+	// Builds levels_ if nodes were added since the last time
+	void BuildLevels();
+
+protected:
+	std::vector<Transform> local_;
+	std::vector<std::uint32_t> parent_;
+	std::vector<Affine3x4> world_;
+
+	// One byte per node rather than std::vector<bool>, so that parallel tasks can write
+	//  the flags of different nodes without stepping on each other
+	std::vector<std::uint8_t> dirty_;
+
+	// Nothing before this index is dirty, so the sweep can start here. Size() when clean.
+	std::size_t firstDirty_;
+
+	// Node indices grouped by depth, only used by UpdateParallel
+	std::vector<std::uint32_t> depth_;
+	std::vector<std::vector<std::uint32_t>> levels_;
+	bool levelsValid_;
+};
+
+};
@@ -0,0 +1,291 @@
+#include <TransformSoA.h>
+
+namespace sess
+{
+
+//
+// Vec3SoA
+//
+std::size_t Vec3SoA::Size() const
+{
+	return X.size();
+}
+
+void Vec3SoA::Reserve(std::size_t n)
+{
+	X.reserve(n);
+	Y.reserve(n);
+	Z.reserve(n);
+}
+
+void Vec3SoA::Resize(std::size_t n)
+{
+	X.resize(n);
+	Y.resize(n);
+	Z.resize(n);
+}
+
+void Vec3SoA::Clear()
+{
+	X.clear();
+	Y.clear();
+	Z.clear();
+}
+
+void Vec3SoA::PushBack(const Vec3& v)
+{
+	X.push_back(v.x);
+	Y.push_back(v.y);
+	Z.push_back(v.z);
+}
+
+Vec3 Vec3SoA::Get(std::size_t idx) const
+{
+	return Vec3(X[idx], Y[idx], Z[idx]);
+}
+
+void Vec3SoA::Set(std::size_t idx, const Vec3& v)
+{
+	X[idx] = v.x;
+	Y[idx] = v.y;
+	Z[idx] = v.z;
+}
+
+//
+// QuaternionSoA
+//
+std::size_t QuaternionSoA::Size() const
+{
+	return X.size();
+}
+
+void QuaternionSoA::Reserve(std::size_t n)
+{
+	X.reserve(n);
+	Y.reserve(n);
+	Z.reserve(n);
+	W.reserve(n);
+}
+
+void QuaternionSoA::Resize(std::size_t n)
+{
+	X.resize(n);
+	Y.resize(n);
+	Z.resize(n);
+	W.resize(n);
+}
+
+void QuaternionSoA::Clear()
+{
+	X.clear();
+	Y.clear();
+	Z.clear();
+	W.clear();
+}
+
+void QuaternionSoA::PushBack(const Quaternion& q)
+{
+	X.push_back(q.x);
+	Y.push_back(q.y);
+	Z.push_back(q.z);
+	W.push_back(q.w);
+}
+
+Quaternion QuaternionSoA::Get(std::size_t idx) const
+{
+	return Quaternion(W[idx], X[idx], Y[idx], Z[idx]);
+}
+
+void QuaternionSoA::Set(std::size_t idx, const Quaternion& q)
+{
+	X[idx] = q.x;
+	Y[idx] = q.y;
+	Z[idx] = q.z;
+	W[idx] = q.w;
+}
+
+//
+// TransformSoA
+//
+std::size_t TransformSoA::Size() const
+{
+	return Position.Size();
+}
+
+void TransformSoA::Reserve(std::size_t n)
+{
+	Position.Reserve(n);
+	Rotation.Reserve(n);
+	Scale.Reserve(n);
+}
+
+void TransformSoA::Resize(std::size_t n)
+{
+	Position.Resize(n);
+	Rotation.Resize(n);
+	Scale.Resize(n);
+}
+
+void TransformSoA::Clear()
+{
+	Position.Clear();
+	Rotation.Clear();
+	Scale.Clear();
+}
+
+std::size_t TransformSoA::Add(const Transform& transform)
+{
+	Position.PushBack(transform.Position);
+	Rotation.PushBack(transform.Rotation);
+	Scale.PushBack(transform.Scale);
+	return Size() - 1u;
+}
+
+Transform TransformSoA::Get(std::size_t idx) const
+{
+	return Transform(Position.Get(idx), Rotation.Get(idx), Scale.Get(idx));
+}
+
+void TransformSoA::Set(std::size_t idx, const Transform& transform)
+{
+	Position.Set(idx, transform.Position);
+	Rotation.Set(idx, transform.Rotation);
+	Scale.Set(idx, transform.Scale);
+}
+
+namespace
+{
+
+// Same math as Transform::GetTransformMatrix, for one transform
+void WriteTransformMatrix(const TransformSoA& t, std::size_t i, Matrix& m)
+{
+	float x = t.Rotation.X[i], y = t.Rotation.Y[i], z = t.Rotation.Z[i], w = t.Rotation.W[i];
+	float sx = t.Scale.X[i], sy = t.Scale.Y[i], sz = t.Scale.Z[i];
+
+	m._11 = sx * (1.f - 2.f * y * y - 2.f * z * z);
+	m._12 = sy * (2.f * x * y - 2.f * z * w);
+	m._13 = sz * (2.f * x * z + 2.f * y * w);
+	m._14 = t.Position.X[i];
+
+	m._21 = sx * (2.f * x * y + 2.f * z * w);
+	m._22 = sy * (1.f - 2.f * x * x - 2.f * z * z);
+	m._23 = sz * (2.f * y * z - 2.f * x * w);
+	m._24 = t.Position.Y[i];
+
+	m._31 = sx * (2.f * x * z - 2.f * y * w);
+	m._32 = sy * (2.f * y * z + 2.f * x * w);
+	m._33 = sz * (1.f - 2.f * x * x - 2.f * y * y);
+	m._34 = t.Position.Z[i];
+
+	m._41 = 0.f;
+	m._42 = 0.f;
+	m._43 = 0.f;
+	m._44 = 1.f;
+}
+
+#if defined(SESS_SIMD_SSE)
+// Builds Lanes::Width matrices starting at transform i.
+// Every matrix element is computed for all lanes at once, which leaves the results
+//  "sideways" - one register holds _11 for every matrix, the next holds _12, and so on.
+//  A 4x4 transpose per row turns four of those into one row of four different matrices.
+template <typename Lanes>
+void WriteTransformMatrices(const TransformSoA& t, std::size_t i, Matrix* out)
+{
+	typedef typename Lanes::V V;
+
+	V x = Lanes::Load(&t.Rotation.X[i]);
+	V y = Lanes::Load(&t.Rotation.Y[i]);
+	V z = Lanes::Load(&t.Rotation.Z[i]);
+	V w = Lanes::Load(&t.Rotation.W[i]);
+	V sx = Lanes::Load(&t.Scale.X[i]);
+	V sy = Lanes::Load(&t.Scale.Y[i]);
+	V sz = Lanes::Load(&t.Scale.Z[i]);
+
+	V one = Lanes::Set(1.f);
+	V x2 = Lanes::Add(x, x);
+	V y2 = Lanes::Add(y, y);
+	V z2 = Lanes::Add(z, z);
+
+	V xx = Lanes::Mul(x, x2), yy = Lanes::Mul(y, y2), zz = Lanes::Mul(z, z2);
+	V xy = Lanes::Mul(x, y2), xz = Lanes::Mul(x, z2), yz = Lanes::Mul(y, z2);
+	V xw = Lanes::Mul(w, x2), yw = Lanes::Mul(w, y2), zw = Lanes::Mul(w, z2);
+
+	V rows[3][4] =
+	{
+		{
+			Lanes::Mul(sx, Lanes::Sub(Lanes::Sub(one, yy), zz)),
+			Lanes::Mul(sy, Lanes::Sub(xy, zw)),
+			Lanes::Mul(sz, Lanes::Add(xz, yw)),
+			Lanes::Load(&t.Position.X[i])
+		},
+		{
+			Lanes::Mul(sx, Lanes::Add(xy, zw)),
+			Lanes::Mul(sy, Lanes::Sub(Lanes::Sub(one, xx), zz)),
+			Lanes::Mul(sz, Lanes::Sub(yz, xw)),
+			Lanes::Load(&t.Position.Y[i])
+		},
+		{
+			Lanes::Mul(sx, Lanes::Sub(xz, yw)),
+			Lanes::Mul(sy, Lanes::Add(yz, xw)),
+			Lanes::Mul(sz, Lanes::Sub(Lanes::Sub(one, xx), yy)),
+			Lanes::Load(&t.Position.Z[i])
+		}
+	};
+
+	const __m128 lastRow = _mm_setr_ps(0.f, 0.f, 0.f, 1.f);
+	for (int half = 0; half < (int)(Lanes::Width / 4u); half++)
+	{
+		Matrix* dst = out + half * 4;
+		for (int row = 0; row < 3; row++)
+		{
+			__m128 c0 = Lanes::Half(rows[row][0], half);
+			__m128 c1 = Lanes::Half(rows[row][1], half);
+			__m128 c2 = Lanes::Half(rows[row][2], half);
+			__m128 c3 = Lanes::Half(rows[row][3], half);
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_storeu_ps(dst[0].m[row], c0);
+			_mm_storeu_ps(dst[1].m[row], c1);
+			_mm_storeu_ps(dst[2].m[row], c2);
+			_mm_storeu_ps(dst[3].m[row], c3);
+		}
+		for (int m = 0; m < 4; m++)
+		{
+			_mm_storeu_ps(dst[m].m[3], lastRow);
+		}
+	}
+}
+#endif
+
+};
+
+void TransformSoA::GetTransformMatrices(Matrix* out) const
+{
+	GetTransformMatrices(0u, Size(), out);
+}
+
+void TransformSoA::GetTransformMatrices(std::size_t first, std::size_t count, Matrix* out) const
+{
+	std::size_t i = first;
+	std::size_t end = first + count;
+
+#if defined(SESS_SIMD_AVX)
+	for (; i + AvxLanes::Width <= end; i += AvxLanes::Width)
+	{
+		WriteTransformMatrices<AvxLanes>(*this, i, out + (i - first));
+	}
+#endif
+#if defined(SESS_SIMD_SSE)
+	for (; i + SseLanes::Width <= end; i += SseLanes::Width)
+	{
+		WriteTransformMatrices<SseLanes>(*this, i, out + (i - first));
+	}
+#endif
+
+	// Leftovers that don't fill a whole register (or everything, without SIMD)
+	for (; i < end; i++)
+	{
+		WriteTransformMatrix(*this, i, out[i - first]);
+	}
+}
+
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+// Structure-of-arrays storage for lots and lots of transforms.
+// A std::vector<Transform> stores each object's position, rotation and scale right
+//  next to each other (an "array of structures"). That's great for working with one
+//  object at a time, but for batch work it's much better to keep every x in one array,
+//  every y in another, and so on. Then four (or eight) objects' worth of any component
+//  can be loaded straight into one SIMD register, and the math never has to shuffle.
+// Layout mirrors Transform - Position, Rotation, Scale - so code reads about the same.
+
+#include <Transform.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace sess
+{
+
+struct Vec3SoA
+{
+public:
+	std::vector<float> X, Y, Z;
+
+public:
+	std::size_t Size() const;
+	void Reserve(std::size_t n);
+	void Resize(std::size_t n);
+	void Clear();
+	void PushBack(const Vec3& v);
+
+	Vec3 Get(std::size_t idx) const;
+	void Set(std::size_t idx, const Vec3& v);
+};
+
+struct QuaternionSoA
+{
+public:
+	std::vector<float> X, Y, Z, W;
+
+public:
+	std::size_t Size() const;
+	void Reserve(std::size_t n);
+	void Resize(std::size_t n);
+	void Clear();
+	void PushBack(const Quaternion& q);
+
+	Quaternion Get(std::size_t idx) const;
+	void Set(std::size_t idx, const Quaternion& q);
+};
+
+struct TransformSoA
+{
+public:
+	Vec3SoA Position;
+	QuaternionSoA Rotation;
+	Vec3SoA Scale;
+
+public:
+	TransformSoA() = default;
+	TransformSoA(const TransformSoA&) = default;
+	~TransformSoA() = default;
+
+	std::size_t Size() const;
+	void Reserve(std::size_t n);
+	void Resize(std::size_t n); // New entries are not initialized to anything useful
+	void Clear();
+
+	// Returns the index of the newly added transform
+	std::size_t Add(const Transform& transform);
+
+	Transform Get(std::size_t idx) const;
+	void Set(std::size_t idx, const Transform& transform);
+
+	// Equivalent to out[i] = Get(i).GetTransformMatrix() for every transform, but done
+	//  in one vectorized pass. out must have room for Size() matrices.
+	void GetTransformMatrices(Matrix* out) const;
+
+	// Same as above, but only for transforms [first, first + count)
+	void GetTransformMatrices(std::size_t first, std::size_t count, Matrix* out) const;
+};
+
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+// Expression templates for small fixed-size vectors.
+// Written the obvious way, something like
+//  v + t * s + Vec3::Cross(u, t)
+//  builds a Vec3 for every operator - t * s, then v + that, then + the cross product.
+//  Every one of those is a separate little loop with a result to store somewhere.
+// With the operators here, the arithmetic builds a small description of the expression
+//  instead (a "sum of a scaled vector and a vector" type), and nothing is computed until it
+//  gets assigned to a real vector. At that point each component is worked out in one go:
+//  result.x = v.x + t.x * s + c.x, which the compiler can turn into fused multiply-adds
+//  when the target has them (-mfma / /arch:AVX2), with no temporaries in between.
+// The expression types are all inline and tiny, so none of this survives into the
+//  optimized build - it only changes the shape of the code the compiler gets to see.
+//
+// Vec3 plugs into this (see Vec3.h), and Vec<N, T> is the general version for anything
+//  else that wants the same treatment.
+//
+// One catch, same as with every expression template library: an expression holds on to
+//  the vectors it was built from. Assign it to a Vec3 (or a Vec) rather than keeping it
+//  around with auto.
+//  auto e = a + b;  // e refers to a and b, and computes a + b whenever it's read
+//  Vec3 s = a + b;  // s is the sum, computed once
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace sess
+{
+
+// Base class of everything that can appear in a vector expression (CRTP - E is the
+//  actual type). E provides:
+//  Size, Scalar  - number of components and their type
+//  Result        - the vector type the expression evaluates to
+//  IsLeaf        - true for real vectors, which expressions refer to instead of copying
+//  operator[](i) - component i of the result
+template <typename E>
+struct VecExpr
+{
+public:
+	constexpr const E& Self() const { return static_cast<const E&>(*this); }
+
+	// Work the expression out into a real vector
+	template <typename R = E>
+	constexpr typename R::Result Eval() const { return typename R::Result(Self()); }
+
+	// A few of the vector methods, for things like (a - b).Normal()
+	template <typename R = E>
+	typename R::Scalar Magnitude() const { return Eval().Magnitude(); }
+	template <typename R = E>
+	typename R::Result Normal() const { return Eval().Normal(); }
+};
+
+namespace vec_detail
+{
+
+// Real vectors are referenced by expressions; expressions are small and get copied
+template <typename E>
+struct Operand
+{
+	typedef typename std::conditional<E::IsLeaf, const E&, const E>::type Type;
+};
+
+struct Add { template <typename T> static constexpr T Apply(T a, T b) { return a + b; } };
+struct Sub { template <typename T> static constexpr T Apply(T a, T b) { return a - b; } };
+struct Mul { template <typename T> static constexpr T Apply(T a, T b) { return a * b; } };
+
+// Dot product as a fold over the components - C++11 constexpr only allows recursion
+template <std::size_t I, std::size_t N>
+struct DotFold
+{
+	template <typename L, typename R>
+	static constexpr typename L::Scalar Apply(const L& l, const R& r)
+	{
+		return l[I] * r[I] + DotFold<I + 1u, N>::Apply(l, r);
+	}
+};
+
+template <std::size_t N>
+struct DotFold<N, N>
+{
+	template <typename L, typename R>
+	static constexpr typename L::Scalar Apply(const L&, const R&) { return typename L::Scalar(0); }
+};
+
+};
+
+// Component-wise l op r
+template <typename Op, typename L, typename R>
+struct VecBinary : public VecExpr<VecBinary<Op, L, R>>
+{
+public:
+	static const std::size_t Size = L::Size;
+	typedef typename L::Scalar Scalar;
+	typedef typename L::Result Result;
+	static const bool IsLeaf = false;
+
+	static_assert(L::Size == R::Size, "Vector expressions need both sides to be the same size");
+	static_assert(std::is_same<typename L::Scalar, typename R::Scalar>::value, "Vector expressions need both sides to have the same component type");
+
+public:
+	constexpr VecBinary(const L& l, const R& r) : l_(l), r_(r) {}
+	constexpr Scalar operator[](std::size_t i) const { return Op::Apply(l_[i], r_[i]); }
+
+private:
+	typename vec_detail::Operand<L>::Type l_;
+	typename vec_detail::Operand<R>::Type r_;
+};
+
+// e * s
+template <typename E>
+struct VecScale : public VecExpr<VecScale<E>>
+{
+public:
+	static const std::size_t Size = E::Size;
+	typedef typename E::Scalar Scalar;
+	typedef typename E::Result Result;
+	static const bool IsLeaf = false;
+
+public:
+	constexpr VecScale(const E& e, Scalar s) : e_(e), s_(s) {}
+	constexpr Scalar operator[](std::size_t i) const { return e_[i] * s_; }
+
+private:
+	typename vec_detail::Operand<E>::Type e_;
+	Scalar s_;
+};
+
+// -e
+template <typename E>
+struct VecNegate : public VecExpr<VecNegate<E>>
+{
+public:
+	static const std::size_t Size = E::Size;
+	typedef typename E::Scalar Scalar;
+	typedef typename E::Result Result;
+	static const bool IsLeaf = false;
+
+public:
+	constexpr explicit VecNegate(const E& e) : e_(e) {}
+	constexpr Scalar operator[](std::size_t i) const { return -e_[i]; }
+
+private:
+	typename vec_detail::Operand<E>::Type e_;
+};
+
+//
+// Operators - these only build the expression, the work happens when it's assigned
+//
+template <typename L, typename R>
+constexpr VecBinary<vec_detail::Add, L, R> operator+(const VecExpr<L>& l, const VecExpr<R>& r)
+{
+	return VecBinary<vec_detail::Add, L, R>(l.Self(), r.Self());
+}
+
+template <typename L, typename R>
+constexpr VecBinary<vec_detail::Sub, L, R> operator-(const VecExpr<L>& l, const VecExpr<R>& r)
+{
+	return VecBinary<vec_detail::Sub, L, R>(l.Self(), r.Self());
+}
+
+template <typename E>
+constexpr VecNegate<E> operator-(const VecExpr<E>& e)
+{
+	return VecNegate<E>(e.Self());
+}
+
+template <typename E>
+constexpr VecScale<E> operator*(const VecExpr<E>& e, typename E::Scalar s)
+{
+	return VecScale<E>(e.Self(), s);
+}
+
+template <typename E>
+constexpr VecScale<E> operator*(typename E::Scalar s, const VecExpr<E>& e)
+{
+	return VecScale<E>(e.Self(), s);
+}
+
+// (l.x * r.x, l.y * r.y, ...)
+template <typename L, typename R>
+constexpr VecBinary<vec_detail::Mul, L, R> ComponentProduct(const VecExpr<L>& l, const VecExpr<R>& r)
+{
+	return VecBinary<vec_detail::Mul, L, R>(l.Self(), r.Self());
+}
+
+template <typename L, typename R>
+constexpr typename L::Scalar Dot(const VecExpr<L>& l, const VecExpr<R>& r)
+{
+	return vec_detail::DotFold<0u, L::Size>::Apply(l.Self(), r.Self());
+}
+
+//
+// General N component vector
+//
+template <std::size_t N, typename T>
+struct Vec : public VecExpr<Vec<N, T>>
+{
+public:
+	static const std::size_t Size = N;
+	typedef T Scalar;
+	typedef Vec Result;
+	static const bool IsLeaf = true;
+
+	T Elements[N];
+
+public:
+	Vec()
+	{
+		for (std::size_t i = 0u; i < N; i++)
+		{
+			Elements[i] = T(0);
+		}
+	}
+	Vec(const Vec&) = default;
+	~Vec() = default;
+
+	// The one loop an expression turns into
+	template <typename E>
+	Vec(const VecExpr<E>& e)
+	{
+		static_assert(E::Size == N, "Expression is a different size than the vector");
+		for (std::size_t i = 0u; i < N; i++)
+		{
+			Elements[i] = e.Self()[i];
+		}
+	}
+
+	template <typename E>
+	Vec& operator=(const VecExpr<E>& e)
+	{
+		static_assert(E::Size == N, "Expression is a different size than the vector");
+		for (std::size_t i = 0u; i < N; i++)
+		{
+			Elements[i] = e.Self()[i];
+		}
+		return *this;
+	}
+	Vec& operator=(const Vec&) = default;
+
+	template <typename E>
+	Vec& operator+=(const VecExpr<E>& e) { return *this = *this + e; }
+	template <typename E>
+	Vec& operator-=(const VecExpr<E>& e) { return *this = *this - e; }
+	Vec& operator*=(T s) { return *this = *this * s; }
+
+	constexpr T operator[](std::size_t i) const { return Elements[i]; }
+	T& operator[](std::size_t i) { return Elements[i]; }
+
+	T Magnitude() const { return std::sqrt(sess::Dot(*this, *this)); }
+	Vec Normal() const { return *this * (T(1) / Magnitude()); }
+};
+
+};
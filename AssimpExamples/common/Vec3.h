@@ -3,38 +3,83 @@
 // 3D vector class, does all the 3D vector things
 // May represent either a point or a direction
 // May be transformed by various other components
+// +, -, and * by a scalar come from Vec.h - they build an expression that gets worked out
+//  all at once when it's assigned to a Vec3, instead of making a Vec3 for every operator.
+
+#include <Vec.h>
+#include <MathPolicy.h>
+
+#include <cmath>
 
 namespace sess
 {
 
-struct Vec3
+struct Vec3 : public VecExpr<Vec3>
 {
 public:
+	static const std::size_t Size = 3u;
+	typedef float Scalar;
+	typedef Vec3 Result;
+	static const bool IsLeaf = true;
+
 	float x, y, z;
 
 public:
-	Vec3();
-	Vec3(float x, float y, float z);
+	constexpr Vec3() : x(0.f), y(0.f), z(0.f) {}
+	constexpr Vec3(float xx, float yy, float zz) : x(xx), y(yy), z(zz) {}
 	Vec3(const Vec3&) = default;
 	~Vec3() = default;
 
-	Vec3 operator+(const Vec3&) const;
-	Vec3 operator-(const Vec3&) const;
-	Vec3 operator-() const;
-	Vec3 operator*(float) const;
+	// Where an expression (a + b * s, etc.) actually gets computed
+	template <typename E>
+	constexpr Vec3(const VecExpr<E>& e) : x(e.Self()[0]), y(e.Self()[1]), z(e.Self()[2])
+	{
+		static_assert(E::Size == 3u, "Only three component expressions can become a Vec3");
+	}
+	Vec3& operator=(const Vec3&) = default;
+
+	constexpr float operator[](std::size_t i) const { return i == 0u ? x : (i == 1u ? y : z); }
+
+	// Every operation in an expression is per component, so it's fine for the expression
+	//  to read from the vector it's being assigned to (v = v * 2.f + u, etc)
+	template <typename E>
+	Vec3& operator+=(const VecExpr<E>& e) { return *this = *this + e; }
+	template <typename E>
+	Vec3& operator-=(const VecExpr<E>& e) { return *this = *this - e; }
+	Vec3& operator*=(float s) { return *this = *this * s; }
+
+	static constexpr float Dot(const Vec3& _1, const Vec3& _2)
+	{
+		return
+			_1.x * _2.x +
+			_1.y * _2.y +
+			_1.z * _2.z;
+	}
 
-	Vec3& operator+=(const Vec3&);
-	Vec3& operator-=(const Vec3&);
-	Vec3& operator*=(float);
+	static constexpr Vec3 Cross(const Vec3& _1, const Vec3& _2)
+	{
+		return Vec3(
+			_1.y * _2.z - _1.z * _2.y,
+			_1.z * _2.x - _1.x * _2.z,
+			_1.x * _2.y - _1.y * _2.x
+			);
+	}
 
-	static float Dot(const Vec3&, const Vec3&);
-	static Vec3 Cross(const Vec3&, const Vec3&);
-	static Vec3 ComponentProduct(const Vec3&, const Vec3&);
+	static constexpr Vec3 ComponentProduct(const Vec3& l, const Vec3& r)
+	{
+		return Vec3(l.x * r.x, l.y * r.y, l.z * r.z);
+	}
 
 	float Magnitude() const;
+
+	// FastMath (MathPolicy.h) swaps the square root and divide for a reciprocal square root
+	//  estimate - the length comes out within ~2e-7 of 1 instead of exactly rounded
+	template <typename Math = ExactMath>
 	Vec3 Normal() const;
 
 public:
+	// Defined in Vec3.cc, but the constexpr constructor means they're baked into the
+	//  executable instead of being set up at startup - safe to use from other statics.
 	const static Vec3 Zero;
 	const static Vec3 Ones;
 	const static Vec3 UnitX;
@@ -42,4 +87,18 @@ public:
 	const static Vec3 UnitZ;
 };
 
+//
+// Everything else is small enough that it's worth letting the compiler inline it
+//
+inline float Vec3::Magnitude() const
+{
+	return sqrtf(x * x + y * y + z * z);
+}
+
+template <typename Math>
+inline Vec3 Vec3::Normal() const
+{
+	return *this * Math::RSqrt(x * x + y * y + z * z);
+}
+
 };
\ No newline at end of file